@@ -9,6 +9,7 @@ SET(NVCLOTH_SOURCE_DIR ${PROJECT_SOURCE_DIR}/../../../)
 SET(NVCLOTH_PLATFORM_SOURCE_FILES
 	${PROJECT_ROOT_DIR}/src/ps/unix/PsUnixAtomic.cpp
 	${PROJECT_ROOT_DIR}/src/ps/unix/PsUnixFPU.h
+	${PROJECT_ROOT_DIR}/src/ps/unix/PsUnixTime.cpp
 	${PROJECT_ROOT_DIR}/src/ps/android/cpu-features.c
 	${PROJECT_ROOT_DIR}/src/ps/android/cpu-features.h
 
@@ -62,6 +62,8 @@ SET( NV_CLOTH_SOURCE_LIST
 	${PROJECT_ROOT_DIR}/src/SwFactory.h
 	${PROJECT_ROOT_DIR}/src/SwInterCollision.cpp
 	${PROJECT_ROOT_DIR}/src/SwInterCollision.h
+	${PROJECT_ROOT_DIR}/src/SwKernelScheduler.cpp
+	${PROJECT_ROOT_DIR}/src/SwKernelScheduler.h
 	${PROJECT_ROOT_DIR}/src/SwSelfCollision.cpp
 	${PROJECT_ROOT_DIR}/src/SwSelfCollision.h
 	${PROJECT_ROOT_DIR}/src/SwSolver.cpp
@@ -138,17 +140,23 @@ SET( NV_CLOTH_SOURCE_LIST
 	${PROJECT_ROOT_DIR}/src/ps/PsFPU.h
 	${PROJECT_ROOT_DIR}/src/ps/PsSort.h
 	${PROJECT_ROOT_DIR}/src/ps/PsSortInternals.h
+	${PROJECT_ROOT_DIR}/src/ps/PsTime.h
 	${PROJECT_ROOT_DIR}/src/ps/PsUtilities.h
 	${PROJECT_ROOT_DIR}/src/ps/PxIntrinsics.h
 	
+	${PROJECT_ROOT_DIR}/extensions/include/NvClothExt/ClothCpuDispatcherExecutor.h
 	${PROJECT_ROOT_DIR}/extensions/include/NvClothExt/ClothFabricCooker.h
+	${PROJECT_ROOT_DIR}/extensions/include/NvClothExt/ClothLodManager.h
 	${PROJECT_ROOT_DIR}/extensions/include/NvClothExt/ClothMeshDesc.h
 	${PROJECT_ROOT_DIR}/extensions/include/NvClothExt/ClothMeshQuadifier.h
+	${PROJECT_ROOT_DIR}/extensions/include/NvClothExt/ClothTaskExecutor.h
 	${PROJECT_ROOT_DIR}/extensions/include/NvClothExt/ClothTetherCooker.h
 	${PROJECT_ROOT_DIR}/extensions/src/ClothFabricCooker.cpp
 	${PROJECT_ROOT_DIR}/extensions/src/ClothGeodesicTetherCooker.cpp
+	${PROJECT_ROOT_DIR}/extensions/src/ClothLodManager.cpp
 	${PROJECT_ROOT_DIR}/extensions/src/ClothMeshQuadifier.cpp
 	${PROJECT_ROOT_DIR}/extensions/src/ClothSimpleTetherCooker.cpp
+	${PROJECT_ROOT_DIR}/extensions/src/ClothTaskExecutor.cpp
 )
 
 ADD_LIBRARY(NvCloth ${NVCLOTH_LIBTYPE} ${NV_CLOTH_SOURCE_LIST})
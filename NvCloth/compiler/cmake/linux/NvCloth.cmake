@@ -32,6 +32,7 @@ SET(NVCLOTH_PLATFORM_INCLUDES
 SET(NVCLOTH_PLATFORM_SOURCE_FILES
 	${PROJECT_ROOT_DIR}/src/ps/unix/PsUnixAtomic.cpp
 	${PROJECT_ROOT_DIR}/src/ps/unix/PsUnixFPU.h
+	${PROJECT_ROOT_DIR}/src/ps/unix/PsUnixTime.cpp
 	#${PROJECT_ROOT_DIR}/src/neon/NeonCollision.cpp
 	#${PROJECT_ROOT_DIR}/src/neon/NeonSelfCollision.cpp
 	#${PROJECT_ROOT_DIR}/src/neon/NeonSolverKernel.cpp
@@ -64,6 +65,24 @@ LIST(APPEND NVCLOTH_PLATFORM_SOURCE_FILES
 )
 ENDIF()
 
+# avx code paths are selected at runtime, only these files may use avx instructions
+SET(NVCLOTH_AVX_SOURCE_FILES
+	${PROJECT_ROOT_DIR}/src/avx/SwCollideParticles.cpp
+	${PROJECT_ROOT_DIR}/src/avx/SwSolveConstraints.cpp
+)
+SET(NVCLOTH_AVX2_SOURCE_FILES
+	${PROJECT_ROOT_DIR}/src/avx/SwSolveConstraintsFma.cpp
+)
+SET(NVCLOTH_AVX512_SOURCE_FILES
+	${PROJECT_ROOT_DIR}/src/avx/SwSolveConstraintsAvx512.cpp
+)
+
+set_source_files_properties(${NVCLOTH_AVX_SOURCE_FILES} PROPERTIES COMPILE_FLAGS "-mavx")
+set_source_files_properties(${NVCLOTH_AVX2_SOURCE_FILES} PROPERTIES COMPILE_FLAGS "-mavx2 -mfma")
+set_source_files_properties(${NVCLOTH_AVX512_SOURCE_FILES} PROPERTIES COMPILE_FLAGS "-mavx512f")
+
+SET(NVCLOTH_PLATFORM_SOURCE_FILES ${NVCLOTH_PLATFORM_SOURCE_FILES} ${NVCLOTH_AVX_SOURCE_FILES} ${NVCLOTH_AVX2_SOURCE_FILES} ${NVCLOTH_AVX512_SOURCE_FILES})
+
 
 IF(${NV_CLOTH_ENABLE_CUDA})
 set(
@@ -130,7 +149,7 @@ ENDIF()
 # include common NvCloth settings
 INCLUDE(../common/NvCloth.cmake)
 
-TARGET_LINK_LIBRARIES(NvCloth PUBLIC ${CUDA_CUDA_LIBRARY})
+TARGET_LINK_LIBRARIES(NvCloth PUBLIC ${CUDA_CUDA_LIBRARY} pthread)
 
 SET_TARGET_PROPERTIES(NvCloth PROPERTIES 
 	LINK_FLAGS_DEBUG ""
@@ -17,6 +17,7 @@ SET(NVCLOTH_PLATFORM_INCLUDES
 SET(NVCLOTH_PLATFORM_SOURCE_FILES
 	${PROJECT_ROOT_DIR}/src/ps/unix/PsUnixAtomic.cpp
 	${PROJECT_ROOT_DIR}/src/ps/unix/PsUnixFPU.h
+	${PROJECT_ROOT_DIR}/src/ps/unix/PsUnixTime.cpp
 	#${PROJECT_ROOT_DIR}/src/neon/NeonCollision.cpp
 	#${PROJECT_ROOT_DIR}/src/neon/NeonSelfCollision.cpp
 	#${PROJECT_ROOT_DIR}/src/neon/NeonSolverKernel.cpp
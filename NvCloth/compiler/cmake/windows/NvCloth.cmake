@@ -27,6 +27,7 @@ SET(NVCLOTH_PLATFORM_SOURCE_FILES
 	${PROJECT_ROOT_DIR}/src/ps/windows/PsWindowsAtomic.cpp
 	${PROJECT_ROOT_DIR}/src/ps/windows/PsWindowsFPU.h
 	${PROJECT_ROOT_DIR}/src/ps/windows/PsWindowsInclude.h
+	${PROJECT_ROOT_DIR}/src/ps/windows/PsWindowsTime.cpp
 )
 IF(${NV_CLOTH_ENABLE_CUDA})
 LIST(APPEND NVCLOTH_PLATFORM_SOURCE_FILES
@@ -86,7 +87,9 @@ LIST(APPEND NVCLOTH_PLATFORM_SOURCE_FILES
 ENDIF()
 
 SET(NVCLOTH_AVX_SOURCE_FILES
+		${PROJECT_ROOT_DIR}/src/avx/SwCollideParticles.cpp
 		${PROJECT_ROOT_DIR}/src/avx/SwSolveConstraints.cpp
+		${PROJECT_ROOT_DIR}/src/avx/SwSolveConstraintsAvx512.cpp
 )
 
 set_source_files_properties(${NVCLOTH_AVX_SOURCE_FILES} PROPERTIES COMPILE_FLAGS "/arch:AVX")
@@ -0,0 +1,150 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2020 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#ifndef NV_CLOTH_EXTENSIONS_CLOTH_CPU_DISPATCHER_EXECUTOR_H
+#define NV_CLOTH_EXTENSIONS_CLOTH_CPU_DISPATCHER_EXECUTOR_H
+
+/** \addtogroup extensions
+@{
+*/
+
+#include "NvCloth/Solver.h"
+#include <task/PxCpuDispatcher.h>
+#include <task/PxTask.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace nv
+{
+namespace cloth
+{
+
+/**
+\brief Runs Solver::simulate() on the worker threads of a physx::PxCpuDispatcher.
+\details Header only, as the task interface is not part of the PxShared headers NvCloth is built with.
+One task per dispatcher worker is submitted, each task and the calling thread take the next
+index until all are done. The calling thread returns once every submitted task has finished,
+so the dispatcher must not be blocked by the thread calling Solver::simulate().
+*/
+class CpuDispatcherExecutor : public Executor
+{
+  public:
+	explicit CpuDispatcherExecutor(physx::PxCpuDispatcher& dispatcher) : mDispatcher(dispatcher)
+	{
+	}
+
+	virtual void parallelFor(TaskFunction function, void* context, uint32_t count) override
+	{
+		if (!count)
+			return;
+
+		Loop loop;
+		loop.mFunction = function;
+		loop.mContext = context;
+		loop.mCount = count;
+		loop.mNextIndex.store(0, std::memory_order_relaxed);
+
+		// the calling thread takes part, so one task less is needed
+		uint32_t numTasks = std::min(mDispatcher.getWorkerCount(), count - 1);
+		loop.mNumRunningTasks.store(numTasks, std::memory_order_relaxed);
+
+		Vector<LoopTask>::Type tasks;
+		tasks.resize(numTasks, LoopTask(&loop));
+		for (uint32_t i = 0; i < numTasks; ++i)
+			mDispatcher.submitTask(tasks[i]);
+
+		loop.run();
+
+		// tasks reference the loop until they are released
+		while (loop.mNumRunningTasks.load(std::memory_order_acquire))
+			std::this_thread::yield();
+	}
+
+  private:
+	CpuDispatcherExecutor& operator = (const CpuDispatcherExecutor&);
+
+	struct Loop
+	{
+		void run()
+		{
+			for (uint32_t i; (i = mNextIndex.fetch_add(1, std::memory_order_relaxed)) < mCount;)
+				mFunction(mContext, i);
+		}
+
+		TaskFunction mFunction;
+		void* mContext;
+		uint32_t mCount;
+		std::atomic<uint32_t> mNextIndex;
+		std::atomic<uint32_t> mNumRunningTasks;
+	};
+
+	class LoopTask : public physx::PxBaseTask
+	{
+	  public:
+		explicit LoopTask(Loop* loop) : mLoop(loop)
+		{
+		}
+
+		virtual void run() override
+		{
+			mLoop->run();
+		}
+		virtual const char* getName() const override
+		{
+			return "cloth::CpuDispatcherExecutor";
+		}
+		virtual void addReference() override
+		{
+		}
+		virtual void removeReference() override
+		{
+		}
+		virtual int32_t getReference() const override
+		{
+			return 1;
+		}
+		virtual void release() override
+		{
+			mLoop->mNumRunningTasks.fetch_sub(1, std::memory_order_release);
+		}
+
+	  private:
+		Loop* mLoop;
+	};
+
+	physx::PxCpuDispatcher& mDispatcher;
+};
+
+} // namespace cloth
+} // namespace nv
+
+/** @} */
+
+#endif // NV_CLOTH_EXTENSIONS_CLOTH_CPU_DISPATCHER_EXECUTOR_H
@@ -0,0 +1,119 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2020 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#ifndef NV_CLOTH_EXTENSIONS_CLOTH_LOD_MANAGER_H
+#define NV_CLOTH_EXTENSIONS_CLOTH_LOD_MANAGER_H
+
+/** \addtogroup extensions
+@{
+*/
+
+#include "NvCloth/Solver.h"
+#include "NvCloth/Cloth.h"
+#include "NvCloth/Callbacks.h"
+#include "NvCloth/Allocator.h"
+
+namespace nv
+{
+namespace cloth
+{
+
+/// Simulation settings of a level of detail, relative to the settings of the cloth when it was added.
+struct ClothLodLevel
+{
+	/// Scale of the solver frequency.
+	float mSolverFrequencyScale;
+	/// Keep the self-collision distance of the cloth, otherwise self-collision is disabled.
+	bool mSelfCollision;
+	/// Keep the virtual particles of the cloth, otherwise they are removed.
+	bool mVirtualParticles;
+	/// Simulate the cloth every mUpdateInterval frames, see Solver::setClothUpdateInterval().
+	uint32_t mUpdateInterval;
+};
+
+/**
+\brief Picks a level of detail for each cloth of a solver to keep the simulation within a time budget.
+\details Cloths are given the best level that fits the budget in order of decreasing importance,
+the remaining cloths get the cheapest level. The cost of a level is predicted from the measured
+simulation time of the cloth at its current level, see Solver::getClothSimulationTime().
+Levels only change when the predicted cost differs by a margin, to avoid switching every frame.
+*/
+class ClothLodManager : public UserAllocated
+{
+  public:
+	virtual ~ClothLodManager()
+	{
+	}
+
+	/** \brief Adds a cloth, its current settings are used for the best level of detail.
+		The virtual particles are restored when switching to a level using them, pass the ranges given to
+		Cloth::setVirtualParticles(), or empty ranges if the cloth has none.
+		The cloth needs to be added to the solver first.
+	*/
+	virtual void addCloth(Cloth* cloth, Range<const uint32_t[4]> virtualParticleIndices,
+	                      Range<const physx::PxVec3> virtualParticleWeights) = 0;
+	/// Removes the cloth and restores its original settings.
+	virtual void removeCloth(Cloth* cloth) = 0;
+
+	/// Sets the importance of the cloth, e.g. its size on screen. Defaults to 1.
+	virtual void setImportance(const Cloth* cloth, float importance) = 0;
+	virtual float getImportance(const Cloth* cloth) const = 0;
+
+	/// Sets the simulation time per frame in milliseconds, summed over all threads.
+	virtual void setBudget(float milliseconds) = 0;
+	virtual float getBudget() const = 0;
+
+	/** \brief Replaces the levels of detail, ordered from best to cheapest.
+		The defaults go from the original settings to updating every 4th frame at an 8th of the solver frequency.
+	*/
+	virtual void setLevels(Range<const ClothLodLevel> levels) = 0;
+	virtual uint32_t getNumLevels() const = 0;
+
+	/// Returns the current level of detail of the cloth, 0 being the best.
+	virtual uint32_t getLevel(const Cloth* cloth) const = 0;
+
+	/// Updates the level of detail of the cloths, call before simulating the frame.
+	virtual void update() = 0;
+
+	/// Same as update(), with the importance of each cloth divided by its distance to viewPosition.
+	virtual void update(const physx::PxVec3& viewPosition) = 0;
+};
+
+} // namespace cloth
+} // namespace nv
+
+/**
+\brief Creates a level of detail manager for the cloths of the solver.
+Release the manager with NV_CLOTH_DELETE before the solver.
+*/
+NV_CLOTH_API(nv::cloth::ClothLodManager*) NvClothCreateLodManager(nv::cloth::Solver& solver);
+
+/** @} */
+
+#endif // NV_CLOTH_EXTENSIONS_CLOTH_LOD_MANAGER_H
@@ -0,0 +1,54 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2020 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#ifndef NV_CLOTH_EXTENSIONS_CLOTH_TASK_EXECUTOR_H
+#define NV_CLOTH_EXTENSIONS_CLOTH_TASK_EXECUTOR_H
+
+/** \addtogroup extensions
+@{
+*/
+
+#include "NvCloth/Solver.h"
+#include "NvCloth/Callbacks.h"
+
+/**
+\brief Creates an executor with its own pool of worker threads for Solver::simulate().
+\details Each worker owns a lock-free work-stealing deque. The thread calling parallelFor() pushes
+the tasks on its own deque and works on them too, idle workers steal from the other deques.
+Workers spin for a short while before going to sleep, to pick up consecutive frames quickly.
+Executor::submit() hands the task to the workers, so Solver::simulateAsync() returns immediately.
+Release the executor with NV_CLOTH_DELETE.
+\param numWorkers Number of threads created in addition to the calling thread,
+typically std::thread::hardware_concurrency() - 1. With 0 the calling thread does all the work.
+*/
+NV_CLOTH_API(nv::cloth::Executor*) NvClothCreateThreadPoolExecutor(uint32_t numWorkers);
+
+/** @} */
+
+#endif // NV_CLOTH_EXTENSIONS_CLOTH_TASK_EXECUTOR_H
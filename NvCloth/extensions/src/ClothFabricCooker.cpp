@@ -407,7 +407,7 @@ bool FabricCookerImpl::cook(const ClothMeshDesc& desc, PxVec3 gravity, bool useG
 			else 
 			{
 				PxVec4 diff = particles[pair.first]-particles[pair.second];
-				PxReal dot = gravity.dot(reinterpret_cast<const PxVec3&>(diff).getNormalized());
+				PxReal dot = gravity.dot(diff.getXYZ().getNormalized());
 				type = fabsf(dot) < sqrtHalf ? ClothFabricPhaseType::eHORIZONTAL : ClothFabricPhaseType::eVERTICAL;
 			}
 			++valency[pair.first];
@@ -525,8 +525,7 @@ bool FabricCookerImpl::cook(const ClothMeshDesc& desc, PxVec3 gravity, bool useG
 		mIndices[2*index+1] = second;
 
 		PxVec4 diff = particles[second] - particles[first];
-		mRestvalues[index] = reinterpret_cast<
-			const PxVec3&>(diff).magnitude();
+		mRestvalues[index] = diff.getXYZ().magnitude();
 	} 
 	
 	// reorder constraints and rest values for more efficient cache access (linear)
@@ -0,0 +1,379 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2020 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#include "NvClothExt/ClothLodManager.h"
+#include "NvCloth/Allocator.h"
+#include "../../src/ps/PsSort.h"
+#include <foundation/PxVec3.h>
+#include <algorithm>
+
+using namespace physx;
+
+namespace nv
+{
+namespace cloth
+{
+
+namespace
+{
+// rough cost of self-collision and virtual particles relative to the rest of the simulation,
+// only used to predict the cost of levels that haven't been measured yet
+const float sSelfCollisionCost = 0.5f;
+const float sVirtualParticleCost = 0.5f;
+
+// weight of a new timing in the running average, smooths out timing noise
+const float sTimingWeight = 0.25f;
+
+// the predicted cost needs to fit the budget by this fraction to switch to a better level
+const float sUpgradeMargin = 0.1f;
+
+const ClothLodLevel sDefaultLevels[] = {
+	{ 1.0f, true, true, 1 },
+	{ 0.75f, true, false, 1 },
+	{ 0.5f, false, false, 1 },
+	{ 0.5f, false, false, 2 },
+	{ 0.5f, false, false, 4 },
+};
+
+struct ClothState
+{
+	Cloth* mCloth;
+	float mImportance;
+
+	// settings of the cloth when it was added
+	float mSolverFrequency;
+	float mSelfCollisionDistance;
+	Vector<uint32_t>::Type mVirtualParticleIndices; // 4 per virtual particle
+	Vector<PxVec3>::Type mVirtualParticleWeights;
+
+	uint32_t mLevel;
+	bool mHasVirtualParticles;
+	uint32_t mFramesSinceChange;
+
+	// average measured time per frame divided by the relative cost of the level
+	float mUnitTime;
+
+	// importance of this update, the cloths are visited in decreasing order
+	float mSortKey;
+};
+
+struct ImportanceGreater
+{
+	explicit ImportanceGreater(const ClothState* states) : mStates(states)
+	{
+	}
+
+	// ties are broken by index to be deterministic
+	bool operator()(uint32_t i, uint32_t j) const
+	{
+		return mStates[i].mSortKey > mStates[j].mSortKey || (mStates[i].mSortKey == mStates[j].mSortKey && i < j);
+	}
+
+	const ClothState* mStates;
+};
+}
+
+class ClothLodManagerImpl : public ClothLodManager
+{
+  public:
+	explicit ClothLodManagerImpl(Solver& solver);
+	virtual ~ClothLodManagerImpl();
+
+	virtual void addCloth(Cloth* cloth, Range<const uint32_t[4]> virtualParticleIndices,
+	                      Range<const PxVec3> virtualParticleWeights) override;
+	virtual void removeCloth(Cloth* cloth) override;
+
+	virtual void setImportance(const Cloth* cloth, float importance) override;
+	virtual float getImportance(const Cloth* cloth) const override;
+
+	virtual void setBudget(float milliseconds) override
+	{
+		mBudget = milliseconds;
+	}
+	virtual float getBudget() const override
+	{
+		return mBudget;
+	}
+
+	virtual void setLevels(Range<const ClothLodLevel> levels) override;
+	virtual uint32_t getNumLevels() const override
+	{
+		return mLevels.size();
+	}
+
+	virtual uint32_t getLevel(const Cloth* cloth) const override;
+
+	virtual void update() override;
+	virtual void update(const PxVec3& viewPosition) override;
+
+  private:
+	// returns the index into mStates, or its size if the cloth wasn't added
+	uint32_t findCloth(const Cloth* cloth) const;
+
+	// cost of the level relative to the best level without self-collision and virtual particles
+	float getRelativeCost(const ClothState& state, uint32_t level) const;
+
+	void applySettings(ClothState& state, const ClothLodLevel& lod);
+	void applyLevel(ClothState& state, uint32_t level);
+	void updateLevels();
+
+	Solver& mSolver;
+	Vector<ClothLodLevel>::Type mLevels;
+	Vector<ClothState>::Type mStates;
+	Vector<uint32_t>::Type mOrder;
+	float mBudget;
+};
+
+ClothLodManagerImpl::ClothLodManagerImpl(Solver& solver) : mSolver(solver), mBudget(1.0f)
+{
+	const uint32_t numLevels = sizeof(sDefaultLevels) / sizeof(sDefaultLevels[0]);
+	mLevels.assign(sDefaultLevels, sDefaultLevels + numLevels);
+}
+
+ClothLodManagerImpl::~ClothLodManagerImpl()
+{
+	while (!mStates.empty())
+		removeCloth(mStates.back().mCloth);
+}
+
+void ClothLodManagerImpl::addCloth(Cloth* cloth, Range<const uint32_t[4]> virtualParticleIndices,
+                                   Range<const PxVec3> virtualParticleWeights)
+{
+	NV_CLOTH_ASSERT(findCloth(cloth) == mStates.size());
+
+	ClothState state;
+	state.mCloth = cloth;
+	state.mImportance = 1.0f;
+	state.mSolverFrequency = cloth->getSolverFrequency();
+	state.mSelfCollisionDistance = cloth->getSelfCollisionDistance();
+	const uint32_t* indices = reinterpret_cast<const uint32_t*>(virtualParticleIndices.begin());
+	state.mVirtualParticleIndices.assign(indices, indices + 4 * virtualParticleIndices.size());
+	state.mVirtualParticleWeights.assign(virtualParticleWeights.begin(), virtualParticleWeights.end());
+	state.mLevel = 0;
+	state.mHasVirtualParticles = !virtualParticleIndices.empty();
+	state.mFramesSinceChange = 0;
+	state.mUnitTime = 0.0f;
+	state.mSortKey = 0.0f;
+
+	mStates.pushBack(state);
+}
+
+void ClothLodManagerImpl::removeCloth(Cloth* cloth)
+{
+	uint32_t index = findCloth(cloth);
+	if (index == mStates.size())
+		return;
+
+	const ClothLodLevel original = { 1.0f, true, true, 1 };
+	applySettings(mStates[index], original);
+
+	mStates.replaceWithLast(index);
+}
+
+void ClothLodManagerImpl::setImportance(const Cloth* cloth, float importance)
+{
+	uint32_t index = findCloth(cloth);
+	NV_CLOTH_ASSERT(index < mStates.size());
+	if (index < mStates.size())
+		mStates[index].mImportance = importance;
+}
+
+float ClothLodManagerImpl::getImportance(const Cloth* cloth) const
+{
+	uint32_t index = findCloth(cloth);
+	return index < mStates.size() ? mStates[index].mImportance : 0.0f;
+}
+
+void ClothLodManagerImpl::setLevels(Range<const ClothLodLevel> levels)
+{
+	NV_CLOTH_ASSERT(!levels.empty());
+	if (levels.empty())
+		return;
+
+	mLevels.assign(levels.begin(), levels.end());
+
+	// the old timings were measured with different settings
+	for (uint32_t i = 0; i < mStates.size(); ++i)
+	{
+		applyLevel(mStates[i], std::min(mStates[i].mLevel, mLevels.size() - 1));
+		mStates[i].mUnitTime = 0.0f;
+	}
+}
+
+uint32_t ClothLodManagerImpl::getLevel(const Cloth* cloth) const
+{
+	uint32_t index = findCloth(cloth);
+	return index < mStates.size() ? mStates[index].mLevel : 0;
+}
+
+void ClothLodManagerImpl::update()
+{
+	for (uint32_t i = 0; i < mStates.size(); ++i)
+		mStates[i].mSortKey = mStates[i].mImportance;
+
+	updateLevels();
+}
+
+void ClothLodManagerImpl::update(const PxVec3& viewPosition)
+{
+	for (uint32_t i = 0; i < mStates.size(); ++i)
+	{
+		float distance = (mStates[i].mCloth->getTranslation() - viewPosition).magnitude();
+		mStates[i].mSortKey = mStates[i].mImportance / std::max(distance, 1.0e-3f);
+	}
+
+	updateLevels();
+}
+
+uint32_t ClothLodManagerImpl::findCloth(const Cloth* cloth) const
+{
+	uint32_t i = 0;
+	while (i < mStates.size() && mStates[i].mCloth != cloth)
+		++i;
+	return i;
+}
+
+float ClothLodManagerImpl::getRelativeCost(const ClothState& state, uint32_t level) const
+{
+	const ClothLodLevel& lod = mLevels[level];
+
+	float cost = 1.0f;
+	if (lod.mSelfCollision && state.mSelfCollisionDistance > 0.0f)
+		cost += sSelfCollisionCost;
+	if (lod.mVirtualParticles && !state.mVirtualParticleIndices.empty())
+		cost += sVirtualParticleCost;
+
+	// an update runs the iterations of a single frame, spread over the update interval
+	return cost * lod.mSolverFrequencyScale / float(lod.mUpdateInterval);
+}
+
+void ClothLodManagerImpl::applySettings(ClothState& state, const ClothLodLevel& lod)
+{
+	Cloth& cloth = *state.mCloth;
+
+	cloth.setSolverFrequency(state.mSolverFrequency * lod.mSolverFrequencyScale);
+	cloth.setSelfCollisionDistance(lod.mSelfCollision ? state.mSelfCollisionDistance : 0.0f);
+
+	bool hasVirtualParticles = lod.mVirtualParticles && !state.mVirtualParticleIndices.empty();
+	if (hasVirtualParticles != state.mHasVirtualParticles)
+	{
+		const uint32_t(*indices)[4] = reinterpret_cast<const uint32_t(*)[4]>(state.mVirtualParticleIndices.begin());
+		uint32_t numIndices = hasVirtualParticles ? state.mVirtualParticleIndices.size() / 4 : 0;
+		uint32_t numWeights = hasVirtualParticles ? state.mVirtualParticleWeights.size() : 0;
+		cloth.setVirtualParticles(Range<const uint32_t[4]>(indices, indices + numIndices),
+		                          Range<const PxVec3>(state.mVirtualParticleWeights.begin(),
+		                                              state.mVirtualParticleWeights.begin() + numWeights));
+		state.mHasVirtualParticles = hasVirtualParticles;
+	}
+
+	mSolver.setClothUpdateInterval(cloth, lod.mUpdateInterval);
+}
+
+void ClothLodManagerImpl::applyLevel(ClothState& state, uint32_t level)
+{
+	applySettings(state, mLevels[level]);
+	state.mLevel = level;
+	state.mFramesSinceChange = 0;
+}
+
+void ClothLodManagerImpl::updateLevels()
+{
+	// predict the cost of the levels from the timings of the current ones
+	float totalUnitTime = 0.0f;
+	uint32_t numMeasured = 0;
+	for (uint32_t i = 0; i < mStates.size(); ++i)
+	{
+		ClothState& state = mStates[i];
+		const ClothLodLevel& lod = mLevels[state.mLevel];
+
+		// the cloth needs to be updated once before the timing reflects a level change
+		float time = mSolver.getClothSimulationTime(*state.mCloth);
+		if (++state.mFramesSinceChange >= lod.mUpdateInterval && time > 0.0f)
+		{
+			float unitTime = time / float(lod.mUpdateInterval) / getRelativeCost(state, state.mLevel);
+			state.mUnitTime = state.mUnitTime > 0.0f ? state.mUnitTime + (unitTime - state.mUnitTime) * sTimingWeight : unitTime;
+		}
+
+		if (state.mUnitTime > 0.0f)
+		{
+			totalUnitTime += state.mUnitTime;
+			++numMeasured;
+		}
+	}
+
+	// cloths that weren't simulated yet are assumed to be average
+	float averageUnitTime = numMeasured ? totalUnitTime / float(numMeasured) : 0.0f;
+
+	// start from the cheapest level for all awake cloths
+	const uint32_t cheapest = mLevels.size() - 1;
+	float remaining = mBudget;
+
+	mOrder.resize(0);
+	for (uint32_t i = 0; i < mStates.size(); ++i)
+	{
+		// sleeping cloths don't cost anything and keep their level
+		if (mStates[i].mCloth->isAsleep())
+			continue;
+
+		float unitTime = mStates[i].mUnitTime > 0.0f ? mStates[i].mUnitTime : averageUnitTime;
+		remaining -= unitTime * getRelativeCost(mStates[i], cheapest);
+		mOrder.pushBack(i);
+	}
+
+	ps::sort(mOrder.begin(), mOrder.size(), ImportanceGreater(mStates.begin()), ps::NonTrackingAllocator());
+
+	// give the most important cloths the best level that fits the remaining budget
+	for (uint32_t i = 0; i < mOrder.size(); ++i)
+	{
+		ClothState& state = mStates[mOrder[i]];
+		float unitTime = state.mUnitTime > 0.0f ? state.mUnitTime : averageUnitTime;
+		remaining += unitTime * getRelativeCost(state, cheapest);
+
+		uint32_t level = 0;
+		for (; level < cheapest; ++level)
+		{
+			float margin = level < state.mLevel ? 1.0f + sUpgradeMargin : 1.0f;
+			if (unitTime * getRelativeCost(state, level) * margin <= remaining)
+				break;
+		}
+
+		remaining -= unitTime * getRelativeCost(state, level);
+
+		if (level != state.mLevel)
+			applyLevel(state, level);
+	}
+}
+
+} // namespace cloth
+} // namespace nv
+
+NV_CLOTH_API(nv::cloth::ClothLodManager*) NvClothCreateLodManager(nv::cloth::Solver& solver)
+{
+	return NV_CLOTH_NEW(nv::cloth::ClothLodManagerImpl)(solver);
+}
@@ -0,0 +1,446 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2020 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#include "NvClothExt/ClothTaskExecutor.h"
+#include "NvCloth/Allocator.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+
+namespace nv
+{
+namespace cloth
+{
+
+namespace
+{
+struct Job
+{
+	Executor::TaskFunction mFunction;
+	void* mContext;
+	std::atomic<uint32_t> mNumPendingTasks;
+	void (*mRelease)(Job*); // frees jobs nobody waits for after their task ran, NULL for parallelFor() jobs
+};
+
+struct Task
+{
+	Job* mJob;
+	uint32_t mIndex;
+};
+
+// job and task of Executor::submit()
+struct AsyncJob : Job
+{
+	Task mTask;
+};
+
+void releaseAsyncJob(Job* job)
+{
+	AsyncJob* asyncJob = static_cast<AsyncJob*>(job);
+	asyncJob->~AsyncJob();
+	NV_CLOTH_FREE(asyncJob);
+}
+
+void execute(const Task* task)
+{
+	Job* job = task->mJob;
+
+	// read before the job may be released by the waiting thread
+	void (*release)(Job*) = job->mRelease;
+
+	job->mFunction(job->mContext, task->mIndex);
+
+	if (release)
+		release(job);
+	else
+		job->mNumPendingTasks.fetch_sub(1, std::memory_order_release);
+}
+
+// lock-free work-stealing deque (Chase-Lev, with the memory orders of Le et al. 2013)
+// the owning thread pushes and pops at the bottom, other threads steal from the top
+class TaskDeque
+{
+  public:
+	static const int64_t sCapacity = 1024; // power of two
+
+	TaskDeque() : mTop(0), mBottom(0)
+	{
+		for (int64_t i = 0; i < sCapacity; ++i)
+			mTasks[i].store(NULL, std::memory_order_relaxed);
+	}
+
+	// returns false if the deque is full
+	bool push(Task* task)
+	{
+		int64_t bottom = mBottom.load(std::memory_order_relaxed);
+		int64_t top = mTop.load(std::memory_order_acquire);
+		if (bottom - top >= sCapacity)
+			return false;
+
+		mTasks[bottom & (sCapacity - 1)].store(task, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	Task* pop()
+	{
+		int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+		mBottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = mTop.load(std::memory_order_relaxed);
+
+		Task* task = NULL;
+		if (top <= bottom)
+		{
+			task = mTasks[bottom & (sCapacity - 1)].load(std::memory_order_relaxed);
+			if (top < bottom)
+				return task;
+
+			// last task, race against the thieves
+			if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				task = NULL;
+		}
+
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return task;
+	}
+
+	// returns NULL if the deque is empty or another thread took the task
+	Task* steal()
+	{
+		int64_t top = mTop.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = mBottom.load(std::memory_order_acquire);
+		if (top >= bottom)
+			return NULL;
+
+		Task* task = mTasks[top & (sCapacity - 1)].load(std::memory_order_relaxed);
+		if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return NULL;
+
+		return task;
+	}
+
+  private:
+	// keep the ends of the deque on separate cache lines, the thieves only write mTop
+	std::atomic<int64_t> mTop;
+	char mPadding[64];
+	std::atomic<int64_t> mBottom;
+	std::atomic<Task*> mTasks[sCapacity];
+};
+
+// number of times an idle worker looks for tasks before it goes to sleep
+const uint32_t sMaxSpinCount = 1024;
+
+class ThreadPoolExecutor : public Executor
+{
+  public:
+	explicit ThreadPoolExecutor(uint32_t numWorkers);
+	virtual ~ThreadPoolExecutor();
+
+	virtual void parallelFor(TaskFunction function, void* context, uint32_t count) override;
+	virtual void submit(TaskFunction function, void* context) override;
+	virtual bool runPendingTask() override;
+
+  private:
+	ThreadPoolExecutor(const ThreadPoolExecutor&);
+	ThreadPoolExecutor& operator = (const ThreadPoolExecutor&);
+
+	static void workerMain(ThreadPoolExecutor* executor, uint32_t slot);
+
+	// returns the deque owned by the calling thread, mNumWorkers for non-worker threads
+	uint32_t getSlot() const;
+
+	// returns the deque to push to, threads outside the pool share the last one and take
+	// turns, except for nested calls from a task run by the thread currently owning it
+	uint32_t acquireSlot(std::unique_lock<std::mutex>& externalLock);
+	void releaseSlot(std::unique_lock<std::mutex>& externalLock);
+
+	// pops from the own deque first if owned, then steals from the others
+	Task* findTask(uint32_t slot, bool isOwner = true);
+
+	// wakes up sleeping workers after pushing tasks
+	void signal();
+
+	uint32_t mNumWorkers;
+	std::thread* mThreads;
+	TaskDeque* mDeques; // one per worker, plus one shared by the other threads
+
+	// serializes parallelFor() calls from threads outside the pool
+	std::mutex mExternalMutex;
+	std::atomic<std::thread::id> mExternalThread;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::atomic<uint32_t> mSignalCount;
+	uint32_t mNumSleeping; // guarded by mMutex
+	bool mQuit;            // guarded by mMutex
+};
+
+ThreadPoolExecutor::ThreadPoolExecutor(uint32_t numWorkers)
+: mNumWorkers(numWorkers), mSignalCount(0), mNumSleeping(0), mQuit(false)
+{
+	mDeques = static_cast<TaskDeque*>(NV_CLOTH_ALLOC(sizeof(TaskDeque) * (numWorkers + 1), "ThreadPoolExecutor::mDeques"));
+	for (uint32_t i = 0; i <= numWorkers; ++i)
+		new (mDeques + i) TaskDeque();
+
+	mThreads = static_cast<std::thread*>(NV_CLOTH_ALLOC(sizeof(std::thread) * numWorkers, "ThreadPoolExecutor::mThreads"));
+	for (uint32_t i = 0; i < numWorkers; ++i)
+		new (mThreads + i) std::thread(&ThreadPoolExecutor::workerMain, this, i);
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mCondition.notify_all();
+
+	for (uint32_t i = 0; i < mNumWorkers; ++i)
+	{
+		mThreads[i].join();
+		mThreads[i].~thread();
+	}
+	NV_CLOTH_FREE(mThreads);
+
+	for (uint32_t i = 0; i <= mNumWorkers; ++i)
+		mDeques[i].~TaskDeque();
+	NV_CLOTH_FREE(mDeques);
+}
+
+void ThreadPoolExecutor::parallelFor(TaskFunction function, void* context, uint32_t count)
+{
+	if (!count)
+		return;
+
+	std::unique_lock<std::mutex> externalLock(mExternalMutex, std::defer_lock);
+	uint32_t slot = acquireSlot(externalLock);
+
+	Job job;
+	job.mFunction = function;
+	job.mContext = context;
+	job.mNumPendingTasks.store(count, std::memory_order_relaxed);
+	job.mRelease = NULL;
+
+	Vector<Task>::Type tasks;
+	tasks.resize(count);
+
+	// thieves take from the top, so pushing in index order lets the
+	// workers start the first (most expensive) tasks while this thread
+	// pops from the end
+	TaskDeque& deque = mDeques[slot];
+	uint32_t numPushed = 0;
+	for (; numPushed < count; ++numPushed)
+	{
+		tasks[numPushed].mJob = &job;
+		tasks[numPushed].mIndex = numPushed;
+		if (!deque.push(&tasks[numPushed]))
+			break;
+	}
+
+	// wake up the workers before running the tasks that didn't fit into the deque
+	signal();
+
+	for (uint32_t i = numPushed; i < count; ++i)
+	{
+		tasks[i].mJob = &job;
+		tasks[i].mIndex = i;
+		execute(&tasks[i]);
+	}
+
+	// help with any task until this job is done
+	for (uint32_t spinCount = 0; job.mNumPendingTasks.load(std::memory_order_acquire);)
+	{
+		if (Task* task = findTask(slot))
+		{
+			execute(task);
+			spinCount = 0;
+		}
+		else if (++spinCount >= sMaxSpinCount)
+		{
+			std::this_thread::yield();
+			spinCount = 0;
+		}
+	}
+
+	releaseSlot(externalLock);
+}
+
+void ThreadPoolExecutor::submit(TaskFunction function, void* context)
+{
+	// nobody else could run it
+	if (!mNumWorkers)
+		return function(context, 0);
+
+	AsyncJob* job = new (NV_CLOTH_ALLOC(sizeof(AsyncJob), "ThreadPoolExecutor::AsyncJob")) AsyncJob();
+	job->mFunction = function;
+	job->mContext = context;
+	job->mNumPendingTasks.store(1, std::memory_order_relaxed);
+	job->mRelease = &releaseAsyncJob;
+	job->mTask.mJob = job;
+	job->mTask.mIndex = 0;
+
+	std::unique_lock<std::mutex> externalLock(mExternalMutex, std::defer_lock);
+	uint32_t slot = acquireSlot(externalLock);
+	bool isPushed = mDeques[slot].push(&job->mTask);
+	releaseSlot(externalLock);
+
+	if (isPushed)
+		signal();
+	else
+		execute(&job->mTask);
+}
+
+bool ThreadPoolExecutor::runPendingTask()
+{
+	uint32_t slot = getSlot();
+	bool isOwner = slot < mNumWorkers || mExternalThread.load() == std::this_thread::get_id();
+
+	Task* task = findTask(slot, isOwner);
+	if (!task)
+		return false;
+
+	execute(task);
+	return true;
+}
+
+void ThreadPoolExecutor::workerMain(ThreadPoolExecutor* executor, uint32_t slot)
+{
+	for (uint32_t spinCount = 0;;)
+	{
+		// read before looking for work, so a signal in between prevents sleeping
+		uint32_t signalCount = executor->mSignalCount.load(std::memory_order_acquire);
+
+		if (Task* task = executor->findTask(slot))
+		{
+			execute(task);
+			spinCount = 0;
+			continue;
+		}
+
+		if (++spinCount < sMaxSpinCount)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(executor->mMutex);
+		++executor->mNumSleeping;
+		while (!executor->mQuit && executor->mSignalCount.load(std::memory_order_relaxed) == signalCount)
+			executor->mCondition.wait(lock);
+		--executor->mNumSleeping;
+
+		if (executor->mQuit)
+			return;
+
+		spinCount = 0;
+	}
+}
+
+uint32_t ThreadPoolExecutor::getSlot() const
+{
+	std::thread::id id = std::this_thread::get_id();
+	for (uint32_t i = 0; i < mNumWorkers; ++i)
+	{
+		if (mThreads[i].get_id() == id)
+			return i;
+	}
+	return mNumWorkers;
+}
+
+uint32_t ThreadPoolExecutor::acquireSlot(std::unique_lock<std::mutex>& externalLock)
+{
+	uint32_t slot = getSlot();
+
+	std::thread::id threadId = std::this_thread::get_id();
+	if (slot == mNumWorkers && mExternalThread.load() != threadId)
+	{
+		externalLock.lock();
+		mExternalThread.store(threadId);
+	}
+
+	return slot;
+}
+
+void ThreadPoolExecutor::releaseSlot(std::unique_lock<std::mutex>& externalLock)
+{
+	if (!externalLock.owns_lock())
+		return;
+
+	mExternalThread.store(std::thread::id());
+	externalLock.unlock();
+}
+
+Task* ThreadPoolExecutor::findTask(uint32_t slot, bool isOwner)
+{
+	if (isOwner)
+	{
+		if (Task* task = mDeques[slot].pop())
+			return task;
+	}
+	else if (Task* task = mDeques[slot].steal())
+	{
+		return task;
+	}
+
+	for (uint32_t i = 1; i <= mNumWorkers; ++i)
+	{
+		if (Task* task = mDeques[(slot + i) % (mNumWorkers + 1)].steal())
+			return task;
+	}
+
+	return NULL;
+}
+
+void ThreadPoolExecutor::signal()
+{
+	bool wakeUp;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mSignalCount.fetch_add(1, std::memory_order_release);
+		wakeUp = mNumSleeping > 0;
+	}
+
+	if (wakeUp)
+		mCondition.notify_all();
+}
+
+} // anonymous namespace
+
+} // namespace cloth
+} // namespace nv
+
+NV_CLOTH_API(nv::cloth::Executor*) NvClothCreateThreadPoolExecutor(uint32_t numWorkers)
+{
+	return NV_CLOTH_NEW(nv::cloth::ThreadPoolExecutor)(numWorkers);
+}
@@ -142,6 +142,13 @@ class Cloth : public UserAllocated
 	/** \brief Returns platform dependent pointers to the current GPU particle memory.*/
 	virtual GpuParticles getGpuParticles() = 0;
 
+	/** \brief Returns the particles published at the end of the last completed frame, read only.
+		Only available when output buffering is enabled on the solver, see Solver::enableOutputBuffering(), empty otherwise.
+		Unlike getCurrentParticles(), the snapshot is not modified while the next frame simulates.
+		The returned range stays valid until the end of the next frame.
+	*/
+	virtual Range<const physx::PxVec4> getPublishedParticles() const = 0;
+
 
 	/** \brief Set the translation of the local space simulation after next call to simulate(). 
 		This applies a force to make the cloth behave as if it was moved through space.
@@ -314,6 +321,45 @@ class Cloth : public UserAllocated
 	/// Returns the number of triangles currently set.
 	virtual uint32_t getNumTriangles() const = 0;
 
+	/** \brief Set a signed distance field for collision, replacing the current one.
+		distances contains dimX * dimY * dimZ samples at the corners of a regular grid, with x varying fastest, then y.
+		The samples are negative inside the shape, particles are pushed out along the gradient of the trilinearly
+		interpolated field. Offset the samples to add a collision margin.
+		lower is the position of the first sample and cellSize the spacing between samples, in the space of the field.
+		Only particles inside the grid collide. Pass an empty range to remove the field.
+		Not supported by the GPU solvers.
+		*/
+	virtual void setDistanceField(Range<const float> distances, uint32_t dimX, uint32_t dimY, uint32_t dimZ,
+	                              const physx::PxVec3& lower, float cellSize) = 0;
+	/// Returns the number of distance field samples currently set.
+	virtual uint32_t getNumDistanceFieldSamples() const = 0;
+	/** \brief Set the transform from the space of the distance field to the local space of the cloth.
+		The field moves from its pose in the previous frame to pose over the next frame, like spheres set with setSpheres().
+		*/
+	virtual void setDistanceFieldPose(const physx::PxTransform& pose) = 0;
+	virtual void setDistanceFieldPose(const physx::PxTransform& startPose, const physx::PxTransform& targetPose) = 0;
+	/// Returns the target pose of the distance field.
+	virtual const physx::PxTransform& getDistanceFieldPose() const = 0;
+
+	/** \brief Set a heightfield for collision, replacing the current one.
+		heights contains numColumns * numRows samples on a regular grid in the xz plane, with x varying fastest.
+		Sample (i, j) is at (lower.x + i * cellSize, lower.y + heights[j * numColumns + i], lower.z + j * cellSize)
+		in the space of the heightfield, with y pointing up. The surface is interpolated bilinearly, particles
+		below it are pushed out along the surface normal. Only particles above the grid collide.
+		Pass an empty range to remove the heightfield. Not supported by the GPU solvers.
+		*/
+	virtual void setHeightfield(Range<const float> heights, uint32_t numColumns, uint32_t numRows,
+	                            const physx::PxVec3& lower, float cellSize) = 0;
+	/// Returns the number of heightfield samples currently set.
+	virtual uint32_t getNumHeightfieldSamples() const = 0;
+	/** \brief Set the transform from the space of the heightfield to the local space of the cloth.
+		The heightfield moves from its pose in the previous frame to pose over the next frame, like spheres set with setSpheres().
+		*/
+	virtual void setHeightfieldPose(const physx::PxTransform& pose) = 0;
+	virtual void setHeightfieldPose(const physx::PxTransform& startPose, const physx::PxTransform& targetPose) = 0;
+	/// Returns the target pose of the heightfield.
+	virtual const physx::PxTransform& getHeightfieldPose() const = 0;
+
 	/// Returns true if we use ccd
 	virtual bool isContinuousCollisionEnabled() const = 0;
 	/// Set if we use ccd or not (disabled by default)
@@ -457,6 +503,20 @@ class Cloth : public UserAllocated
 	virtual void putToSleep() = 0;
 	virtual void wakeUp() = 0;
 
+	/* convergence (disabled by default) */
+
+	/** \brief Stops the solver iterations of a frame early once the cloth has come to rest.
+		Iterating stops when no particle moved faster (per axis) than the threshold during the last iteration,
+		if the motion and separation constraints, collision shapes and cloth frame don't move this frame.
+		The skipped iterations are not made up for, so keep the threshold well below visible motion.
+		Set to 0 to always run all iterations (default). Has no effect on GPU solvers.
+	*/
+	virtual void setConvergenceThreshold(float) = 0;
+	virtual float getConvergenceThreshold() const = 0;
+	// minimum number of iterations per frame before testing for convergence
+	virtual void setConvergenceMinIterations(uint32_t) = 0;
+	virtual uint32_t getConvergenceMinIterations() const = 0;
+
 	/**  \brief Set user data. Not used internally.	*/
 	virtual void setUserData(void*) = 0;
 	// Returns value set by setUserData().
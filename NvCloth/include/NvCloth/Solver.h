@@ -43,6 +43,37 @@ class Cloth;
 // called during inter-collision, user0 and user1 are the user data from each cloth
 typedef bool (*InterCollisionFilter)(void* user0, void* user1);
 
+/// interface to distribute the simulation chunks of Solver::simulate() over threads
+class Executor : public UserAllocated
+{
+  public:
+	typedef void (*TaskFunction)(void* context, uint32_t index);
+
+	virtual ~Executor() {}
+
+	/** \brief Calls function(context, i) for every i in [0, count), possibly from multiple threads in parallel.
+		Returns after all calls have completed.
+		Indices should be started in roughly increasing order, as the solver orders chunks by decreasing cost.
+	*/
+	virtual void parallelFor(TaskFunction function, void* context, uint32_t count) = 0;
+
+	/** \brief Calls function(context, 0) in the background and returns without waiting for it.
+		The default implementation calls it on the calling thread.
+	*/
+	virtual void submit(TaskFunction function, void* context)
+	{
+		function(context, 0);
+	}
+
+	/** \brief Runs one pending task on the calling thread, used to help while waiting for a submitted task.
+		Returns false if there was no task to run.
+	*/
+	virtual bool runPendingTask()
+	{
+		return false;
+	}
+};
+
 /// base class for solvers
 class Solver : public UserAllocated
 {
@@ -85,16 +116,91 @@ class Solver : public UserAllocated
 	virtual void simulateChunk(int idx) = 0;
 
 	/** \brief Finishes up the simulation.
-		This function can be expensive if inter-collision is enabled.
+		This function can be expensive if inter-collision is enabled on GPU solvers.
+		CPU solvers run inter-collision as part of the simulation chunks.
 	*/
 	virtual void endSimulation() = 0;
 
 	/** \brief Returns the number of chunks that need to be simulated this frame.
+		When inter-collision is enabled CPU solvers add chunks that share its work.
 	*/
 	virtual int getSimulationChunkCount() const = 0;
 
+	/** \brief Simulates a frame using the executor to run the chunks in parallel.
+		Calls beginSimulation(), simulateChunk() for every chunk, and endSimulation().
+		Returns false if there is nothing to simulate.
+		@param dt The delta time for this frame.
+		@param executor Runs the simulation chunks, see NvClothCreateThreadPoolExecutor().
+	*/
+	bool simulate(float dt, Executor& executor);
+
+	/** \brief Starts simulating a frame on the executor and returns without waiting for it to complete.
+		Calls beginSimulation() on the calling thread, the chunks and endSimulation() run through Executor::submit().
+		The solver and its cloths must not be modified or simulated until the frame has completed.
+		With output buffering enabled, Cloth::getPublishedParticles() of the previous frame can be read in the meantime.
+		GPU solvers simulate the frame before returning.
+		Returns a fence for isSimulationComplete() and waitForSimulation(), 0 if there is nothing to simulate.
+	*/
+	virtual uint32_t simulateAsync(float dt, Executor& executor) = 0;
+
+	/// Returns true if the frame of the fence returned by simulateAsync() has completed.
+	virtual bool isSimulationComplete(uint32_t fence) const = 0;
+
+	/// Blocks until the frame of the fence has completed, the calling thread helps the executor in the meantime.
+	virtual void waitForSimulation(uint32_t fence) = 0;
+
+	/** \brief Publishes the particles at the end of every frame to a snapshot, see Cloth::getPublishedParticles().
+		The snapshots are double buffered, so a snapshot can be read while the next frame simulates.
+		Has no effect on GPU solvers.
+	*/
+	virtual void enableOutputBuffering(bool enable) = 0;
+	virtual bool isOutputBufferingEnabled() const = 0;
+
+	/** \brief Returns the estimated cost of simulating chunk idx this frame, in arbitrary units.
+		Chunks are ordered by decreasing cost, so simulating them in index order already
+		starts the most expensive ones first (longest-processing-time-first scheduling).
+		CPU solvers estimate the cost from the cloth setup and refine it with the timings of previous frames.
+		Only valid between beginSimulation() and endSimulation().
+	*/
+	virtual float getSimulationChunkCost(int idx) const = 0;
+
+	/** \brief Allows large cloths to be simulated by multiple chunks in parallel.
+		A cloth is given one chunk for every numParticles particles it has,
+		the chunks of a cloth share the work of its solver iterations.
+		Only worthwhile for cloths with thousands of particles.
+		Set to 0 to use one chunk per cloth (default).
+		Has no effect on GPU solvers.
+	*/
+	virtual void setMinParticlesPerChunk(uint32_t numParticles) = 0;
+	virtual uint32_t getMinParticlesPerChunk() const = 0;
+
+	/** \brief Groups cloths into simulation chunks to approach the given chunk count, typically the number of worker threads.
+		Cloths cheaper than the average chunk cost share a chunk, which reduces the scheduling overhead of many small cloths.
+		Set to 0 to use at least one chunk per cloth (default).
+		Has no effect on GPU solvers.
+	*/
+	virtual void setTargetSimulationChunkCount(uint32_t count) = 0;
+	virtual uint32_t getTargetSimulationChunkCount() const = 0;
+
+	/** \brief Simulates the cloth only every interval frames, with the delta time accumulated over the skipped frames.
+		An update runs the solver iterations of a single frame with a correspondingly larger iteration delta time,
+		so the solver work per frame drops with the interval.
+		Cloths are staggered over the frames to spread the cost of updating them.
+		With output buffering enabled, the published particles are interpolated from the previous update to the last one,
+		trailing the simulation by up to interval - 1 frames.
+		Set to 1 to simulate the cloth every frame (default).
+		Has no effect on GPU solvers.
+	*/
+	virtual void setClothUpdateInterval(Cloth& cloth, uint32_t interval) = 0;
+	virtual uint32_t getClothUpdateInterval(const Cloth& cloth) const = 0;
+
+	/** \brief Returns the measured time in milliseconds it took to simulate the last update of the cloth,
+		summed over the chunks sharing the cloth. Returns 0 if the cloth was not simulated yet, and on GPU solvers.
+	*/
+	virtual float getClothSimulationTime(const Cloth& cloth) const = 0;
+
 	/// inter-collision parameters
-	/// Note that using intercollision with more than 32 cloths added to the solver will cause undefined behavior
+	/// Note that intercollision supports up to 65535 cloths added to the solver
 	virtual void setInterCollisionDistance(float distance) = 0;
 	virtual float getInterCollisionDistance() const = 0;
 	virtual void setInterCollisionStiffness(float stiffness) = 0;
@@ -105,7 +211,24 @@ class Solver : public UserAllocated
 
 	/// Returns true if an unrecoverable error has occurred.
 	virtual bool hasError() const = 0;
+
+  protected:
+	static void simulateChunkTask(void* solver, uint32_t idx)
+	{
+		static_cast<Solver*>(solver)->simulateChunk(int(idx));
+	}
 };
 
+inline bool Solver::simulate(float dt, Executor& executor)
+{
+	if (!beginSimulation(dt))
+		return false;
+
+	executor.parallelFor(&simulateChunkTask, this, uint32_t(getSimulationChunkCount()));
+
+	endSimulation();
+	return true;
+}
+
 } // namespace cloth
 } // namespace nv
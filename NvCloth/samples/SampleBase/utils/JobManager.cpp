@@ -102,14 +102,39 @@ void MultithreadedSolverHelper::Initialize(nv::cloth::Solver* solver, JobManager
 {
 	mSolver = solver;
 	mJobManager = jobManager;
+	mSimulating = false;
 	mEndSimulationJob.Initialize(mJobManager, [this](Job*) {
-		mSolver->endSimulation();
+		if (mSimulating)
+			mSolver->endSimulation();
 	});
 
 	mStartSimulationJob.Initialize(mJobManager, [this](Job*) {
-		mSolver->beginSimulation(mDt);
-		for(int j = 0; j < mSolver->getSimulationChunkCount(); j++)
+		mSimulating = mSolver->beginSimulation(mDt);
+
+		// the chunk count is only final after beginSimulation(), and may be 0 if no cloth needs an update
+		int chunkCount = mSimulating ? mSolver->getSimulationChunkCount() : 0;
+		if (chunkCount != int(mSimulationChunkJobs.size()))
+		{
+			mSimulationChunkJobs.resize(chunkCount, JobDependency());
+			for (int j = 0; j < chunkCount; j++)
+			{
+				mSimulationChunkJobs[j].Initialize(mJobManager, [this, j](Job*) {mSolver->simulateChunk(j); });
+				mSimulationChunkJobs[j].SetDependentJob(&mEndSimulationJob);
+			}
+		}
+		else
+		{
+			for (int j = 0; j < chunkCount; j++)
+				mSimulationChunkJobs[j].Reset();
+		}
+
+		for (int j = 0; j < chunkCount; j++)
+			mEndSimulationJob.AddReference();
+		for (int j = 0; j < chunkCount; j++)
 			mSimulationChunkJobs[j].RemoveReference();
+
+		// release the reference of this job, runs endSimulation() right away if there are no chunks
+		mEndSimulationJob.RemoveReference();
 	});
 }
 
@@ -117,30 +142,12 @@ void MultithreadedSolverHelper::StartSimulation(float dt)
 {
 	mDt = dt;
 
-	if (mSolver->getSimulationChunkCount() != mSimulationChunkJobs.size())
-	{
-		mSimulationChunkJobs.resize(mSolver->getSimulationChunkCount(), JobDependency());
-		for (int j = 0; j < mSolver->getSimulationChunkCount(); j++)
-		{
-			mSimulationChunkJobs[j].Initialize(mJobManager, [this, j](Job*) {mSolver->simulateChunk(j); });
-			mSimulationChunkJobs[j].SetDependentJob(&mEndSimulationJob);
-		}
-	}
-	else
-	{
-		for (int j = 0; j < mSolver->getSimulationChunkCount(); j++)
-			mSimulationChunkJobs[j].Reset();
-	}
-
 	mStartSimulationJob.Reset();
-	mEndSimulationJob.Reset(mSolver->getSimulationChunkCount());
+	mEndSimulationJob.Reset();
 	mStartSimulationJob.RemoveReference();
 }
 
 void MultithreadedSolverHelper::WaitForSimulation()
 {
-	if (mSolver->getSimulationChunkCount() == 0)
-		return;
-
 	mEndSimulationJob.Wait();
 }
\ No newline at end of file
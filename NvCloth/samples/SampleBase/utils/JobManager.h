@@ -187,6 +187,7 @@ private:
 	std::vector<JobDependency> mSimulationChunkJobs;
 
 	float mDt;
+	bool mSimulating;
 
 	nv::cloth::Solver* mSolver;
 	JobManager* mJobManager;
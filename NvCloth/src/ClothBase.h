@@ -48,8 +48,8 @@ void initialize(Cloth& cloth, const physx::PxVec4* pIt, const physx::PxVec4* pEn
 	}
 	physx::PxVec4 center = (upper + lower) * 0.5f;
 	physx::PxVec4 extent = (upper - lower) * 0.5f;
-	cloth.mParticleBoundsCenter = reinterpret_cast<const physx::PxVec3&>(center);
-	cloth.mParticleBoundsHalfExtent = reinterpret_cast<const physx::PxVec3&>(extent);
+	cloth.mParticleBoundsCenter = center.getXYZ();
+	cloth.mParticleBoundsHalfExtent = extent.getXYZ();
 
 	cloth.mGravity = physx::PxVec3(0.0f);
 	cloth.mLogDamping = physx::PxVec3(0.0f);
@@ -65,6 +65,10 @@ void initialize(Cloth& cloth, const physx::PxVec4* pIt, const physx::PxVec4* pEn
 	cloth.mLinearVelocity = physx::PxVec3(0.0f);
 	cloth.mAngularVelocity = physx::PxVec3(0.0f);
 	cloth.mIgnoreVelocityDiscontinuityNextFrame = false;
+	cloth.mStartDistanceFieldPose = physx::PxTransform(physx::PxIdentity);
+	cloth.mTargetDistanceFieldPose = physx::PxTransform(physx::PxIdentity);
+	cloth.mStartHeightfieldPose = physx::PxTransform(physx::PxIdentity);
+	cloth.mTargetHeightfieldPose = physx::PxTransform(physx::PxIdentity);
 	cloth.mPrevIterDt = 0.0f;
 	cloth.mIterDtAvg = MovingAverage(30);
 	cloth.mTetherConstraintLogStiffness = float(-FLT_MAX_EXP);
@@ -86,6 +90,8 @@ void initialize(Cloth& cloth, const physx::PxVec4* pIt, const physx::PxVec4* pEn
 	cloth.mSleepThreshold = 0.0f;
 	cloth.mSleepPassCounter = 0;
 	cloth.mSleepTestCounter = 0;
+	cloth.mConvergenceThreshold = 0.0f;
+	cloth.mConvergenceMinIterations = 1;
 }
 
 template <typename DstCloth, typename SrcCloth>
@@ -106,6 +112,10 @@ void copy(DstCloth& dstCloth, const SrcCloth& srcCloth)
 	dstCloth.mCurrentMotion = srcCloth.mCurrentMotion;
 	dstCloth.mLinearVelocity = srcCloth.mLinearVelocity;
 	dstCloth.mAngularVelocity = srcCloth.mAngularVelocity;
+	dstCloth.mStartDistanceFieldPose = srcCloth.mStartDistanceFieldPose;
+	dstCloth.mTargetDistanceFieldPose = srcCloth.mTargetDistanceFieldPose;
+	dstCloth.mStartHeightfieldPose = srcCloth.mStartHeightfieldPose;
+	dstCloth.mTargetHeightfieldPose = srcCloth.mTargetHeightfieldPose;
 	dstCloth.mPrevIterDt = srcCloth.mPrevIterDt;
 	dstCloth.mIterDtAvg = srcCloth.mIterDtAvg;
 	dstCloth.mTetherConstraintLogStiffness = srcCloth.mTetherConstraintLogStiffness;
@@ -126,6 +136,8 @@ void copy(DstCloth& dstCloth, const SrcCloth& srcCloth)
 	dstCloth.mSleepThreshold = srcCloth.mSleepThreshold;
 	dstCloth.mSleepPassCounter = srcCloth.mSleepPassCounter;
 	dstCloth.mSleepTestCounter = srcCloth.mSleepTestCounter;
+	dstCloth.mConvergenceThreshold = srcCloth.mConvergenceThreshold;
+	dstCloth.mConvergenceMinIterations = srcCloth.mConvergenceMinIterations;
 	dstCloth.mUserData = srcCloth.mUserData;
 }
 
@@ -62,6 +62,8 @@ class ClothImpl : public Cloth
 	typedef typename ClothTraits<ClothType>::FabricType FabricType;
 	typedef typename ClothTraits<ClothType>::ContextLockType ContextLockType;
 
+	static const uint32_t sMaxCollisionShapes = ClothTraits<ClothType>::sMaxCollisionShapes;
+
 	ClothImpl& operator = (const ClothImpl&);
 
 	ClothType* getChildCloth() { return static_cast<T*>(this); }
@@ -126,6 +128,14 @@ class ClothImpl : public Cloth
 	virtual void setTriangles(Range<const physx::PxVec3>, Range<const physx::PxVec3>, uint32_t first);
 	virtual uint32_t getNumTriangles() const;
 
+	virtual void setDistanceFieldPose(const physx::PxTransform& pose);
+	virtual void setDistanceFieldPose(const physx::PxTransform& startPose, const physx::PxTransform& targetPose);
+	virtual const physx::PxTransform& getDistanceFieldPose() const;
+
+	virtual void setHeightfieldPose(const physx::PxTransform& pose);
+	virtual void setHeightfieldPose(const physx::PxTransform& startPose, const physx::PxTransform& targetPose);
+	virtual const physx::PxTransform& getHeightfieldPose() const;
+
 	virtual bool isContinuousCollisionEnabled() const;
 	virtual void enableContinuousCollision(bool);
 
@@ -192,6 +202,11 @@ class ClothImpl : public Cloth
 	virtual bool isSleeping() const;
 	virtual void wakeUp();
 
+	virtual void setConvergenceThreshold(float);
+	virtual float getConvergenceThreshold() const;
+	virtual void setConvergenceMinIterations(uint32_t);
+	virtual uint32_t getConvergenceMinIterations() const;
+
 	virtual void setUserData(void*);
 	virtual void* getUserData() const;
 
@@ -219,6 +234,14 @@ public: //Fields shared between all cloth classes
 	physx::PxVec3 mAngularVelocity;
 	bool mIgnoreVelocityDiscontinuityNextFrame;
 
+	// distance field collision, moved from the start to the target pose over the frame
+	physx::PxTransform mStartDistanceFieldPose;
+	physx::PxTransform mTargetDistanceFieldPose;
+
+	// heightfield collision, moved from the start to the target pose over the frame
+	physx::PxTransform mStartHeightfieldPose;
+	physx::PxTransform mTargetHeightfieldPose;
+
 	float mPrevIterDt;
 	MovingAverage mIterDtAvg;
 
@@ -234,6 +257,10 @@ public: //Fields shared between all cloth classes
 	float mSleepThreshold;       // max movement delta to pass test
 	uint32_t mSleepPassCounter;  // how many tests passed
 	uint32_t mSleepTestCounter;  // how many iterations since tested
+
+	// convergence
+	float mConvergenceThreshold;         // max movement delta per iteration to stop iterating
+	uint32_t mConvergenceMinIterations;  // number of iterations before testing
 };
 
 template <typename T>
@@ -538,7 +565,7 @@ inline void ClothImpl<T>::setSpheres(Range<const physx::PxVec4> spheres, uint32_
 	uint32_t oldSize = uint32_t(getChildCloth()->mStartCollisionSpheres.size());
 	uint32_t newSize = uint32_t(spheres.size()) + oldSize - last + first;
 
-	NV_CLOTH_ASSERT(newSize <= 32);
+	NV_CLOTH_ASSERT(newSize <= sMaxCollisionShapes);
 	NV_CLOTH_ASSERT(first <= oldSize);
 	NV_CLOTH_ASSERT(last <= oldSize);
 
@@ -623,9 +650,9 @@ inline void ClothImpl<T>::setSpheres(Range<const physx::PxVec4> startSpheres, Ra
 {
 	NV_CLOTH_ASSERT(startSpheres.size() == targetSpheres.size());
 
-	//Clamp ranges to the first 32 spheres
-	startSpheres = Range<const physx::PxVec4>(startSpheres.begin(), std::min(startSpheres.end(), startSpheres.begin() + 32));
-	targetSpheres = Range<const physx::PxVec4>(targetSpheres.begin(), std::min(targetSpheres.end(), targetSpheres.begin() + 32));
+	//Clamp ranges to the maximum number of spheres
+	startSpheres = Range<const physx::PxVec4>(startSpheres.begin(), std::min(startSpheres.end(), startSpheres.begin() + sMaxCollisionShapes));
+	targetSpheres = Range<const physx::PxVec4>(targetSpheres.begin(), std::min(targetSpheres.end(), targetSpheres.begin() + sMaxCollisionShapes));
 
 	uint32_t oldSize = uint32_t(getChildCloth()->mStartCollisionSpheres.size());
 	uint32_t newSize = uint32_t(startSpheres.size());
@@ -666,7 +693,7 @@ inline void ClothImpl<T>::setCapsules(Range<const uint32_t> capsules, uint32_t f
 	uint32_t oldSize = uint32_t(getChildCloth()->mCapsuleIndices.size());
 	uint32_t newSize = srcIndicesSize + oldSize - last + first;
 
-	NV_CLOTH_ASSERT(newSize <= 32);
+	NV_CLOTH_ASSERT(newSize <= sMaxCollisionShapes);
 	NV_CLOTH_ASSERT(first <= oldSize);
 	NV_CLOTH_ASSERT(last <= oldSize);
 
@@ -1058,6 +1085,54 @@ inline uint32_t ClothImpl<T>::getNumTriangles() const
 	return uint32_t(getChildCloth()->mStartCollisionTriangles.size()) / 3;
 }
 
+template <typename T>
+inline void ClothImpl<T>::setDistanceFieldPose(const physx::PxTransform& pose)
+{
+	if (pose == mTargetDistanceFieldPose)
+		return;
+
+	mTargetDistanceFieldPose = pose;
+	wakeUp();
+}
+
+template <typename T>
+inline void ClothImpl<T>::setDistanceFieldPose(const physx::PxTransform& startPose, const physx::PxTransform& targetPose)
+{
+	mStartDistanceFieldPose = startPose;
+	mTargetDistanceFieldPose = targetPose;
+	wakeUp();
+}
+
+template <typename T>
+inline const physx::PxTransform& ClothImpl<T>::getDistanceFieldPose() const
+{
+	return mTargetDistanceFieldPose;
+}
+
+template <typename T>
+inline void ClothImpl<T>::setHeightfieldPose(const physx::PxTransform& pose)
+{
+	if (pose == mTargetHeightfieldPose)
+		return;
+
+	mTargetHeightfieldPose = pose;
+	wakeUp();
+}
+
+template <typename T>
+inline void ClothImpl<T>::setHeightfieldPose(const physx::PxTransform& startPose, const physx::PxTransform& targetPose)
+{
+	mStartHeightfieldPose = startPose;
+	mTargetHeightfieldPose = targetPose;
+	wakeUp();
+}
+
+template <typename T>
+inline const physx::PxTransform& ClothImpl<T>::getHeightfieldPose() const
+{
+	return mTargetHeightfieldPose;
+}
+
 template <typename T>
 inline bool ClothImpl<T>::isContinuousCollisionEnabled() const
 {
@@ -1472,7 +1547,42 @@ inline bool ClothImpl<T>::isSleeping() const
 template <typename T>
 inline void ClothImpl<T>::wakeUp()
 {
+	bool wasSleeping = isSleeping();
 	mSleepPassCounter = 0;
+	if (wasSleeping)
+		getChildCloth()->notifyWakeUp();
+}
+
+template <typename T>
+inline void ClothImpl<T>::setConvergenceThreshold(float threshold)
+{
+	if (threshold == mConvergenceThreshold)
+		return;
+
+	mConvergenceThreshold = threshold;
+	getChildCloth()->notifyChanged();
+}
+
+template <typename T>
+inline float ClothImpl<T>::getConvergenceThreshold() const
+{
+	return mConvergenceThreshold;
+}
+
+template <typename T>
+inline void ClothImpl<T>::setConvergenceMinIterations(uint32_t minIterations)
+{
+	if (minIterations == mConvergenceMinIterations)
+		return;
+
+	mConvergenceMinIterations = minIterations;
+	getChildCloth()->notifyChanged();
+}
+
+template <typename T>
+inline uint32_t ClothImpl<T>::getConvergenceMinIterations() const
+{
+	return mConvergenceMinIterations;
 }
 
 template <typename T>
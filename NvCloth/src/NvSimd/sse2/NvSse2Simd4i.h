@@ -47,7 +47,7 @@ Simd4iScalarFactory::operator Simd4i() const
 
 Simd4iTupleFactory::operator Simd4i() const
 {
-	return reinterpret_cast<const Simd4i&>(tuple);
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(tuple));
 }
 
 Simd4iLoadFactory::operator Simd4i() const
@@ -34,6 +34,11 @@
 
 #include "NvSimd/NvSimd4f.h"
 #include "NvSimd/NvSimd4i.h"
+#include <foundation/PxPreprocessor.h>
+
+// platforms compiling the avx/ sources, selected at runtime in SwSolverKernel.cpp
+#define NV_AVX (NV_SIMD_SIMD && ((PX_WIN32 || PX_WIN64) && PX_VC >= 10 || PX_LINUX && (PX_X86 || PX_X64)))
+#define NV_AVX512 (NV_AVX && (_MSC_VER >= 1911 || PX_GCC_FAMILY))
 
 namespace nv
 {
@@ -30,10 +30,12 @@
 #include "SwCloth.h"
 #include "SwFabric.h"
 #include "SwFactory.h"
+#include "SwSolver.h"
 #include "TripletScheduler.h"
 #include "ClothBase.h"
 #include <foundation/PxMat44.h>
 #include "NvCloth/Allocator.h"
+#include "limits.h" // for USHRT_MAX
 
 using namespace physx;
 
@@ -48,14 +50,14 @@ PhaseConfig transform(const PhaseConfig&); // from PhaseConfig.cpp
 using namespace nv;
 
 cloth::SwCloth::SwCloth(SwFactory& factory, SwFabric& fabric, Range<const PxVec4> particles)
-: mFactory(factory), mFabric(fabric), mNumVirtualParticles(0), mUserData(0)
+: mFactory(factory), mFabric(fabric), mPublishedIndex(0), mNumVirtualParticles(0), mUserData(0), mSolver(NULL)
 {
 	NV_CLOTH_ASSERT(!particles.empty());
 
 	initialize(*this, particles.begin(), particles.end());
 
-#if PX_WINDOWS_FAMILY
-	const uint32_t kSimdWidth = 8; // avx
+#if NV_CLOTH_AVX_LAYOUT
+	const uint32_t kSimdWidth = getAvxConstraintWidth(); // avx or avx-512
 #else
 	const uint32_t kSimdWidth = 4; // sse
 #endif
@@ -66,13 +68,21 @@ cloth::SwCloth::SwCloth(SwFactory& factory, SwFabric& fabric, Range<const PxVec4
 	mCurParticles.assign(reinterpret_cast<const PxVec4*>(particles.begin()),
 	                     reinterpret_cast<const PxVec4*>(particles.end()));
 
-	// 7 dummy particles used in SIMD solver
+	// kSimdWidth - 1 dummy particles used in SIMD solver
 	mCurParticles.resize(particles.size() + kSimdWidth - 1, PxVec4(0.0f));
 	mPrevParticles = mCurParticles;
 
 	mCurParticles.resize(particles.size());
 	mPrevParticles.resize(particles.size());
 
+	mDistanceFieldDims[0] = mDistanceFieldDims[1] = mDistanceFieldDims[2] = 0;
+	mDistanceFieldLower = PxVec3(0.0f);
+	mDistanceFieldCellSize = 0.0f;
+
+	mHeightfieldDims[0] = mHeightfieldDims[1] = 0;
+	mHeightfieldLower = PxVec3(0.0f);
+	mHeightfieldCellSize = 0.0f;
+
 	mFabric.incRefCount();
 }
 
@@ -94,6 +104,7 @@ void copyVector(nv::cloth::Vector<PxVec4>::Type& dst, const nv::cloth::Vector<Px
 cloth::SwCloth::SwCloth(SwFactory& factory, const SwCloth& cloth)
 : mFactory(factory)
 , mFabric(cloth.mFabric)
+, mPublishedIndex(0)
 , mPhaseConfigs(cloth.mPhaseConfigs)
 , mCapsuleIndices(cloth.mCapsuleIndices)
 , mStartCollisionSpheres(cloth.mStartCollisionSpheres)
@@ -102,14 +113,27 @@ cloth::SwCloth::SwCloth(SwFactory& factory, const SwCloth& cloth)
 , mTargetCollisionPlanes(cloth.mTargetCollisionPlanes)
 , mStartCollisionTriangles(cloth.mStartCollisionTriangles)
 , mTargetCollisionTriangles(cloth.mTargetCollisionTriangles)
+, mDistanceField(cloth.mDistanceField)
+, mDistanceFieldLower(cloth.mDistanceFieldLower)
+, mDistanceFieldCellSize(cloth.mDistanceFieldCellSize)
+, mHeightfield(cloth.mHeightfield)
+, mHeightfieldLower(cloth.mHeightfieldLower)
+, mHeightfieldCellSize(cloth.mHeightfieldCellSize)
 , mVirtualParticleIndices(cloth.mVirtualParticleIndices)
+, mVirtualParticleIndices32(cloth.mVirtualParticleIndices32)
 , mVirtualParticleWeights(cloth.mVirtualParticleWeights)
 , mNumVirtualParticles(cloth.mNumVirtualParticles)
 , mSelfCollisionIndices(cloth.mSelfCollisionIndices)
 , mRestPositions(cloth.mRestPositions)
+, mSolver(NULL)
 {
 	copy(*this, cloth);
 
+	for (uint32_t i = 0; i < 3; ++i)
+		mDistanceFieldDims[i] = cloth.mDistanceFieldDims[i];
+	mHeightfieldDims[0] = cloth.mHeightfieldDims[0];
+	mHeightfieldDims[1] = cloth.mHeightfieldDims[1];
+
 	// carry over capacity (using as dummy particles)
 	copyVector(mCurParticles, cloth.mCurParticles);
 	copyVector(mPrevParticles, cloth.mPrevParticles);
@@ -167,6 +191,77 @@ cloth::Range<const PxVec3> cloth::SwCloth::clampTriangleCount(Range<const PxVec3
 	return range;
 }
 
+void cloth::SwCloth::setDistanceField(Range<const float> distances, uint32_t dimX, uint32_t dimY, uint32_t dimZ,
+                                       const PxVec3& lower, float cellSize)
+{
+	Vector<float>::Type().swap(mDistanceField); // clear and trim
+	mDistanceFieldDims[0] = mDistanceFieldDims[1] = mDistanceFieldDims[2] = 0;
+
+	if (!distances.empty())
+	{
+		if (dimX < 2 || dimY < 2 || dimZ < 2 || distances.size() != dimX * dimY * dimZ || !(cellSize > 0.0f))
+		{
+			NV_CLOTH_LOG_INVALID_PARAMETER("Cloth::setDistanceField expects at least 2 samples along each axis, "
+			                               "dimX * dimY * dimZ samples in total, and a positive cell size.");
+		}
+		else
+		{
+			mDistanceField.assign(distances.begin(), distances.end());
+			mDistanceFieldDims[0] = dimX;
+			mDistanceFieldDims[1] = dimY;
+			mDistanceFieldDims[2] = dimZ;
+			mDistanceFieldLower = lower;
+			mDistanceFieldCellSize = cellSize;
+		}
+	}
+
+	mClothCostDirty = true;
+	wakeUp();
+}
+
+uint32_t cloth::SwCloth::getNumDistanceFieldSamples() const
+{
+	return uint32_t(mDistanceField.size());
+}
+
+void cloth::SwCloth::setHeightfield(Range<const float> heights, uint32_t numColumns, uint32_t numRows,
+                                     const PxVec3& lower, float cellSize)
+{
+	Vector<float>::Type().swap(mHeightfield); // clear and trim
+	mHeightfieldDims[0] = mHeightfieldDims[1] = 0;
+
+	if (!heights.empty())
+	{
+		if (numColumns < 2 || numRows < 2 || heights.size() != numColumns * numRows || !(cellSize > 0.0f))
+		{
+			NV_CLOTH_LOG_INVALID_PARAMETER("Cloth::setHeightfield expects at least 2 columns and rows, "
+			                               "numColumns * numRows samples in total, and a positive cell size.");
+		}
+		else
+		{
+			mHeightfield.assign(heights.begin(), heights.end());
+			mHeightfieldDims[0] = numColumns;
+			mHeightfieldDims[1] = numRows;
+			mHeightfieldLower = lower;
+			mHeightfieldCellSize = cellSize;
+		}
+	}
+
+	mClothCostDirty = true;
+	wakeUp();
+}
+
+uint32_t cloth::SwCloth::getNumHeightfieldSamples() const
+{
+	return uint32_t(mHeightfield.size());
+}
+
+void cloth::SwCloth::notifyWakeUp()
+{
+	if (mSolver)
+		mSolver->notifyWakeUp();
+}
+
 #include "ClothImpl.h"
 
 namespace nv
@@ -218,6 +313,38 @@ GpuParticles SwCloth::getGpuParticles()
 	return result;
 }
 
+Range<const physx::PxVec4> SwCloth::getPublishedParticles() const
+{
+	const Vector<PxVec4>::Type& particles = mPublishedParticles[mPublishedIndex.load(std::memory_order_acquire)];
+	return Range<const PxVec4>(particles.begin(), particles.end());
+}
+
+void SwCloth::publishParticles()
+{
+	// the front snapshot may still be read while we write the back one
+	uint32_t backIndex = mPublishedIndex.load(std::memory_order_relaxed) ^ 1;
+	Vector<PxVec4>::Type& particles = mPublishedParticles[backIndex];
+	particles.assign(mCurParticles.begin(), mCurParticles.end());
+	mPublishedIndex.store(backIndex, std::memory_order_release);
+}
+
+void SwCloth::publishParticles(const PxVec4* start, float t)
+{
+	uint32_t backIndex = mPublishedIndex.load(std::memory_order_relaxed) ^ 1;
+	Vector<PxVec4>::Type& particles = mPublishedParticles[backIndex];
+	particles.resize(mCurParticles.size());
+	for (uint32_t i = 0; i < mCurParticles.size(); ++i)
+		particles[i] = start[i] + (mCurParticles[i] - start[i]) * t;
+	mPublishedIndex.store(backIndex, std::memory_order_release);
+}
+
+void SwCloth::clearPublishedParticles()
+{
+	mPublishedParticles[0].reset();
+	mPublishedParticles[1].reset();
+	mPublishedIndex.store(0, std::memory_order_release);
+}
+
 void SwCloth::setPhaseConfig(Range<const PhaseConfig> configs)
 {
 	mPhaseConfigs.resize(0);
@@ -268,11 +395,24 @@ void SwCloth::setVirtualParticles(Range<const uint32_t[4]> indices, Range<const
 	mNumVirtualParticles = 0;
 
 	// shuffle indices to form independent SIMD sets
-	uint16_t numParticles = uint16_t(mCurParticles.size());
+	uint32_t numParticles = uint32_t(mCurParticles.size());
 	TripletScheduler scheduler(indices); //the TripletScheduler makes a copy so indices is not modified
 	scheduler.simd(numParticles, 4);
 
-	mVirtualParticleIndices.swap(scheduler.mPaddedTriplets);
+	// narrow indices to 16 bit when possible (including the padding dummies)
+	Vector<Vec4us>::Type().swap(mVirtualParticleIndices);
+	Vector<Vec4u>::Type().swap(mVirtualParticleIndices32);
+	if (numParticles + 2 > USHRT_MAX)
+	{
+		mVirtualParticleIndices32.swap(scheduler.mPaddedTriplets);
+	}
+	else
+	{
+		mVirtualParticleIndices.reserve(scheduler.mPaddedTriplets.size());
+		Vector<Vec4u>::Type::ConstIterator tIt = scheduler.mPaddedTriplets.begin();
+		for (; tIt != scheduler.mPaddedTriplets.end(); ++tIt)
+			mVirtualParticleIndices.pushBack(Vec4us(*tIt));
+	}
 
 	// precompute 1/dot(w,w)
 	Vector<PxVec4>::Type().swap(mVirtualParticleWeights); //clear and trim
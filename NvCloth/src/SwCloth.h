@@ -40,6 +40,7 @@
 #include "SwFactory.h"
 #include "SwFabric.h"
 #include "ClothImpl.h"
+#include <atomic>
 
 namespace nv
 {
@@ -70,6 +71,7 @@ struct SwContextLock
 };
 
 class SwCloth;
+class SwSolver;
 
 template<>
 class ClothTraits<SwCloth>
@@ -78,6 +80,9 @@ public:
 	typedef SwFactory FactoryType;
 	typedef SwFabric FabricType;
 	typedef SwContextLock ContextLockType;
+
+	// collision spheres and capsules each, see SwCollision::sMaxShapeWords
+	static const uint32_t sMaxCollisionShapes = 256;
 };
 
 class SwCloth : public ClothImpl<SwCloth>
@@ -110,6 +115,13 @@ class SwCloth : public ClothImpl<SwCloth>
 	MappedRange<physx::PxVec4> getPreviousParticles();
 	MappedRange<const physx::PxVec4> getPreviousParticles() const;
 	GpuParticles getGpuParticles();
+	Range<const physx::PxVec4> getPublishedParticles() const;
+
+	// copies the current particles to the back snapshot and makes it the front
+	void publishParticles();
+	// publishes start + (mCurParticles - start) * t instead
+	void publishParticles(const physx::PxVec4* start, float t);
+	void clearPublishedParticles();
 
 	void setPhaseConfig(Range<const PhaseConfig> configs);
 	void setSelfCollisionIndices(Range<const uint32_t> indices);
@@ -121,6 +133,7 @@ class SwCloth : public ClothImpl<SwCloth>
 	void notifyChanged()
 	{
 	}
+	void notifyWakeUp();
 
 	void setParticleBounds(const float*);
 
@@ -129,6 +142,14 @@ class SwCloth : public ClothImpl<SwCloth>
 
 	static Range<const physx::PxVec3> clampTriangleCount(Range<const physx::PxVec3>, uint32_t);
 
+	void setDistanceField(Range<const float> distances, uint32_t dimX, uint32_t dimY, uint32_t dimZ,
+	                      const physx::PxVec3& lower, float cellSize);
+	uint32_t getNumDistanceFieldSamples() const;
+
+	void setHeightfield(Range<const float> heights, uint32_t numColumns, uint32_t numRows, const physx::PxVec3& lower,
+	                    float cellSize);
+	uint32_t getNumHeightfieldSamples() const;
+
   public:
 	SwFactory& mFactory;
 	SwFabric& mFabric;
@@ -139,6 +160,11 @@ class SwCloth : public ClothImpl<SwCloth>
 	Vector<physx::PxVec4>::Type mCurParticles;
 	Vector<physx::PxVec4>::Type mPrevParticles;
 
+	// double buffered snapshots of mCurParticles, written by the solver with output buffering.
+	// the index of the front snapshot is released after the back one has been written.
+	Vector<physx::PxVec4>::Type mPublishedParticles[2];
+	std::atomic<uint32_t> mPublishedIndex;
+
 	Vector<PhaseConfig>::Type mPhaseConfigs; // transformed!
 
 	// tether constraints stuff
@@ -166,12 +192,21 @@ class SwCloth : public ClothImpl<SwCloth>
 	Vector<physx::PxVec4>::Type mTargetCollisionPlanes;
 	Vector<physx::PxVec3>::Type mStartCollisionTriangles;
 	Vector<physx::PxVec3>::Type mTargetCollisionTriangles;
+	Vector<float>::Type mDistanceField; // samples of the signed distance field, x varying fastest
+	uint32_t mDistanceFieldDims[3];
+	physx::PxVec3 mDistanceFieldLower; // position of the first sample
+	float mDistanceFieldCellSize;
+	Vector<float>::Type mHeightfield; // heights of the samples, x varying fastest
+	uint32_t mHeightfieldDims[2];
+	physx::PxVec3 mHeightfieldLower; // position of the first sample at zero height
+	float mHeightfieldCellSize;
 	bool mEnableContinuousCollision;
 	float mCollisionMassScale;
 	float mFriction;
 
 	// virtual particles
 	Vector<Vec4us>::Type mVirtualParticleIndices;
+	Vector<Vec4u>::Type mVirtualParticleIndices32; // used instead if the cloth has too many particles
 	Vector<physx::PxVec4>::Type mVirtualParticleWeights;
 	uint32_t mNumVirtualParticles;
 
@@ -185,6 +220,9 @@ class SwCloth : public ClothImpl<SwCloth>
 
 	// unused for CPU simulation
 	void* mUserData;
+
+	// solver this cloth has been added to, notified when the cloth wakes up
+	SwSolver* mSolver;
 };
 
 } // namespace cloth
@@ -66,8 +66,9 @@ cloth::SwClothData::SwClothData(SwCloth& cloth, const SwFabric& fabric)
 	mNumRestvalues = uint32_t(fabric.mRestvalues.size());
 	mStiffnessValues = fabric.mStiffnessValues.empty()?nullptr:&fabric.mStiffnessValues.front();
 
-	mIndices = &fabric.mIndices.front();
-	mNumIndices = uint32_t(fabric.mIndices.size());
+	mIndices = fabric.mIndices.empty() ? 0 : &fabric.mIndices.front();
+	mIndices32 = fabric.mIndices32.empty() ? 0 : &fabric.mIndices32.front();
+	mNumIndices = uint32_t(fabric.mIndices.size() + fabric.mIndices32.size());
 
 	float stiffnessExponent = cloth.mStiffnessFrequency * cloth.mPrevIterDt * 0.69314718055994531f; // logf(2.0f);
 
@@ -78,7 +79,9 @@ cloth::SwClothData::SwClothData(SwCloth& cloth, const SwFabric& fabric)
 	mTetherConstraintScale = cloth.mTetherConstraintScale * fabric.mTetherLengthScale;
 
 	mTriangles = fabric.mTriangles.begin();
-	mNumTriangles = uint32_t(fabric.mTriangles.size()) / 3;
+	mTriangles32 = fabric.mTriangles32.empty() ? 0 : fabric.mTriangles32.begin();
+	mNumTriangles = uint32_t(fabric.mTriangles.size() + fabric.mTriangles32.size()) / 3;
+	mNumTriangleBatches = fabric.mNumTriangleBatches;
 	mDragCoefficient = 1.0f - expf(stiffnessExponent * cloth.mDragLogCoefficient);
 	mLiftCoefficient = 1.0f - expf(stiffnessExponent * cloth.mLiftLogCoefficient);
 	mFluidDensity = cloth.mFluidDensity * 0.5f; //divide by 2 to so we don't have to compensate for double area from cross product in the solver
@@ -116,8 +119,34 @@ cloth::SwClothData::SwClothData(SwCloth& cloth, const SwFabric& fabric)
 	                                                                    : array(cloth.mTargetCollisionTriangles.front());
 	mNumCollisionTriangles = uint32_t(cloth.mStartCollisionTriangles.size()) / 3;
 
+	mDistanceField = cloth.mDistanceField.empty() ? 0 : cloth.mDistanceField.begin();
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		mDistanceFieldDims[i] = cloth.mDistanceFieldDims[i];
+		mDistanceFieldLower[i] = cloth.mDistanceFieldLower[i];
+	}
+	mDistanceFieldCellSize = cloth.mDistanceFieldCellSize;
+	mStartDistanceFieldPose = &cloth.mStartDistanceFieldPose;
+	mTargetDistanceFieldPose = cloth.mTargetDistanceFieldPose == cloth.mStartDistanceFieldPose
+	                               ? mStartDistanceFieldPose
+	                               : &cloth.mTargetDistanceFieldPose;
+
+	mHeightfield = cloth.mHeightfield.empty() ? 0 : cloth.mHeightfield.begin();
+	mHeightfieldDims[0] = cloth.mHeightfieldDims[0];
+	mHeightfieldDims[1] = cloth.mHeightfieldDims[1];
+	for (uint32_t i = 0; i < 3; ++i)
+		mHeightfieldLower[i] = cloth.mHeightfieldLower[i];
+	mHeightfieldCellSize = cloth.mHeightfieldCellSize;
+	mStartHeightfieldPose = &cloth.mStartHeightfieldPose;
+	mTargetHeightfieldPose = cloth.mTargetHeightfieldPose == cloth.mStartHeightfieldPose
+	                             ? mStartHeightfieldPose
+	                             : &cloth.mTargetHeightfieldPose;
+
 	mVirtualParticlesBegin = cloth.mVirtualParticleIndices.empty() ? 0 : array(cloth.mVirtualParticleIndices.front());
 	mVirtualParticlesEnd = mVirtualParticlesBegin + 4 * cloth.mVirtualParticleIndices.size();
+	mVirtualParticles32Begin =
+	    cloth.mVirtualParticleIndices32.empty() ? 0 : array(cloth.mVirtualParticleIndices32.front());
+	mVirtualParticles32End = mVirtualParticles32Begin + 4 * cloth.mVirtualParticleIndices32.size();
 	mVirtualParticleWeights = cloth.mVirtualParticleWeights.empty() ? 0 : array(cloth.mVirtualParticleWeights.front());
 	mNumVirtualParticleWeights = uint32_t(cloth.mVirtualParticleWeights.size());
 
@@ -80,6 +80,7 @@ struct SwClothData
 	const float* mStiffnessValues;
 
 	const uint16_t* mIndices;
+	const uint32_t* mIndices32; // non-null for fabrics with 32 bit indices
 	uint32_t mNumIndices;
 
 	const SwTether* mTethers;
@@ -89,7 +90,9 @@ struct SwClothData
 
 	// wind data
 	const uint16_t* mTriangles;
+	const uint32_t* mTriangles32;
 	uint32_t mNumTriangles;
+	uint32_t mNumTriangleBatches; // groups of 4 triangles without shared particles, followed by the others
 	float mDragCoefficient;
 	float mLiftCoefficient;
 	float mFluidDensity;
@@ -125,8 +128,24 @@ struct SwClothData
 	const float* mTargetCollisionTriangles;
 	uint32_t mNumCollisionTriangles;
 
+	const float* mDistanceField; // samples at the grid corners, x varying fastest
+	uint32_t mDistanceFieldDims[3];
+	float mDistanceFieldLower[3];
+	float mDistanceFieldCellSize;
+	const physx::PxTransform* mStartDistanceFieldPose; // field to cloth space
+	const physx::PxTransform* mTargetDistanceFieldPose;
+
+	const float* mHeightfield; // heights at the grid corners, x varying fastest
+	uint32_t mHeightfieldDims[2];
+	float mHeightfieldLower[3];
+	float mHeightfieldCellSize;
+	const physx::PxTransform* mStartHeightfieldPose; // heightfield to cloth space
+	const physx::PxTransform* mTargetHeightfieldPose;
+
 	const uint16_t* mVirtualParticlesBegin;
 	const uint16_t* mVirtualParticlesEnd;
+	const uint32_t* mVirtualParticles32Begin; // non-null for cloths with 32 bit virtual particle indices
+	const uint32_t* mVirtualParticles32End;
 
 	const float* mVirtualParticleWeights;
 	uint32_t mNumVirtualParticleWeights;
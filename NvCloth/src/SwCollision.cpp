@@ -35,13 +35,36 @@
 #include "PointInterpolator.h"
 #include "SwCollisionHelpers.h"
 #include <foundation/PxProfiler.h>
+#include <foundation/PxMat33.h>
 #include <cstring> // for memset
+#include <algorithm> // for nth_element
 #include "ps/PsSort.h"
+#include "NvCloth/ps/PsAtomic.h"
 
 using namespace nv;
 using namespace physx;
 using namespace cloth;
 
+// asserts that the triangle tree finds the same triangles as a linear search,
+// costs particles * triangles per iteration so it is opt-in even for debug builds
+#ifndef NV_CLOTH_CHECK_TRIANGLE_TREE
+#define NV_CLOTH_CHECK_TRIANGLE_TREE 0
+#endif
+
+#if NV_AVX
+namespace avx
+{
+// defined in avx/SwCollideParticles.cpp
+
+uint32_t collideParticles(float* __restrict curIt, float* __restrict prevIt, const float* __restrict blocks,
+                          uint32_t numParticles, const float* __restrict spheres, const float* __restrict prevSpheres,
+                          const float* __restrict cones, const uint32_t* __restrict capsuleIndices,
+                          const uint32_t* __restrict sphereGrid, const uint32_t* __restrict coneGrid,
+                          uint32_t numSphereWords, uint32_t numConeWords, const uint32_t* numCells,
+                          const __m128& gridScale, const __m128& gridBias, float frictionScale, float massScale);
+}
+#endif
+
 // the particle trajectory needs to penetrate more than 0.2 * radius to trigger continuous collision
 template <typename T4f>
 const T4f cloth::SwCollision<T4f>::sSkeletonWidth = simd4f(cloth::sqr(1 - 0.2f) - 1);
@@ -62,7 +85,8 @@ const Simd4fTupleFactory sMaskX = simd4f(simd4i(~0, 0, 0, 0));
 const Simd4fTupleFactory sMaskZ = simd4f(simd4i(0, 0, ~0, 0));
 const Simd4fTupleFactory sMaskW = simd4f(simd4i(0, 0, 0, ~0));
 const Simd4fTupleFactory gSimd4fOneXYZ = simd4f(1.0f, 1.0f, 1.0f, 0.0f);
-const Simd4fScalarFactory sGridLength = simd4f(8 - 1e-3f); // sGridSize
+const Simd4fScalarFactory sGridMargin = simd4f(1e-3f);
+const float sGridRefineCost = 1.0f; // cost of the extra gathers of a mask word relative to a shape test
 const Simd4fScalarFactory sGridExpand = simd4f(1e-4f);
 const Simd4fTupleFactory sMinusFloatMaxXYZ = simd4f(-FLT_MAX, -FLT_MAX, -FLT_MAX, 0.0f);
 
@@ -75,6 +99,26 @@ uint32_t horizontalSum(const T4f& x)
 }
 #endif
 
+template <typename T4f>
+void loadBlock(const T4f* block, T4f (&pos)[4])
+{
+	pos[0] = block[0];
+	pos[1] = block[1];
+	pos[2] = block[2];
+	pos[3] = block[3];
+}
+
+// transposes the (x, y, z, w) vectors of 4 particles back and stores the particles
+template <typename T4f>
+void storeTransposed(float* ptr, T4f (&pos)[4])
+{
+	transpose(pos[0], pos[1], pos[2], pos[3]);
+	storeAligned(ptr, 0, pos[0]);
+	storeAligned(ptr, 16, pos[1]);
+	storeAligned(ptr, 32, pos[2]);
+	storeAligned(ptr, 48, pos[3]);
+}
+
 // 7 elements are written to ptr!
 template <typename T4f>
 void storeBounds(float* ptr, const cloth::BoundingBox<T4f>& bounds)
@@ -100,8 +144,13 @@ struct cloth::ConeData
 	float sqrCosine; // cos^2(alpha)
 	float halfLength;
 
+	// bits of the two spheres in their shape mask words, secondMask is 0 if both are the same sphere
 	uint32_t firstMask;
-	uint32_t bothMask;
+	uint32_t secondMask;
+
+	uint32_t firstWord;
+	uint32_t secondWord;
+	uint32_t padding[2];
 };
 
 struct cloth::TriangleData
@@ -125,6 +174,14 @@ struct cloth::TriangleData
 	float edge1InvSqrLength;
 };
 
+struct cloth::TriangleNode
+{
+	PxVec3 lower;
+	uint32_t first; // first child node, or first triangle index of leaves
+	PxVec3 upper;
+	uint32_t count; // number of triangles of leaves, 0 for inner nodes
+};
+
 namespace nv
 {
 namespace cloth
@@ -197,9 +254,11 @@ void generateCones(cloth::ConeData* dst, const cloth::SphereData* sourceSpheres,
 		cIt->sqrCosine = 1.0f - cloth::sqr(axis.w * invAxisHalfLength);
 		cIt->halfLength = axisHalfLength;
 
-		uint32_t firstMask = 0x1u << iIt->first;
-		cIt->firstMask = firstMask;
-		cIt->bothMask = firstMask | 0x1u << iIt->second;
+		cIt->firstMask = 0x1u << (iIt->first & 31);
+		cIt->secondMask = iIt->first != iIt->second ? 0x1u << (iIt->second & 31) : 0;
+		cIt->firstWord = iIt->first >> 5;
+		cIt->secondWord = iIt->second >> 5;
+		cIt->padding[0] = cIt->padding[1] = 0;
 	}
 }
 
@@ -249,6 +308,38 @@ void generateTriangles(cloth::TriangleData* dIt, const SrcIterator& src, uint32_
 	}
 }
 
+// triangles per leaf of the triangle tree
+const uint32_t sTrianglesPerLeaf = 4;
+// the median split keeps the tree balanced, this is enough for any triangle count
+const uint32_t sMaxTriangleTreeDepth = 32;
+
+struct TriangleCenterLess
+{
+	TriangleCenterLess(const float* centers, uint32_t axis) : mCenters(centers), mAxis(axis)
+	{
+	}
+	bool operator()(uint32_t i, uint32_t j) const
+	{
+		return mCenters[i * 4 + mAxis] < mCenters[j * 4 + mAxis];
+	}
+	const float* mCenters;
+	uint32_t mAxis;
+};
+
+// squared distance of the 4 particles to the node bounds
+template <typename T4f>
+T4f sqrDistance(const cloth::TriangleNode& node, const T4f* curPos)
+{
+	T4f lower = loadAligned(&node.lower.x);
+	T4f upper = loadAligned(&node.upper.x);
+
+	T4f dx = max(gSimd4fZero, max(splat<0>(lower) - curPos[0], curPos[0] - splat<0>(upper)));
+	T4f dy = max(gSimd4fZero, max(splat<1>(lower) - curPos[1], curPos[1] - splat<1>(upper)));
+	T4f dz = max(gSimd4fZero, max(splat<2>(lower) - curPos[2], curPos[2] - splat<2>(upper)));
+
+	return dx * dx + dy * dy + dz * dz;
+}
+
 } // namespace
 
 template <typename T4f>
@@ -259,8 +350,14 @@ cloth::SwCollision<T4f>::CollisionData::CollisionData()
 
 template <typename T4f>
 cloth::SwCollision<T4f>::SwCollision(SwClothData& clothData, SwKernelAllocator& alloc)
-: mClothData(clothData), mAllocator(alloc)
+: mNumSphereWords((clothData.mNumSpheres + 31) >> 5)
+, mNumConeWords((clothData.mNumCapsules + 31) >> 5)
+, mParticleBlocks(0)
+, mClothData(clothData)
+, mAllocator(alloc)
 {
+	NV_CLOTH_ASSERT(mNumSphereWords <= sMaxShapeWords && mNumConeWords <= sMaxShapeWords);
+
 	allocate(mCurData);
 
 	if (mClothData.mEnableContinuousCollision || mClothData.mFrictionScale > 0.0f)
@@ -283,16 +380,37 @@ cloth::SwCollision<T4f>::~SwCollision()
 
 template <typename T4f>
 void cloth::SwCollision<T4f>::operator()(const IterationState<T4f>& state)
+{
+	if (!beginCollision(state))
+		return;
+
+	collideParticleRange(0, mClothData.mNumParticles);
+
+	endCollision();
+}
+
+// returns false if there is no particle collision to perform this iteration
+template <typename T4f>
+bool cloth::SwCollision<T4f>::beginCollision(const IterationState<T4f>& state)
 {
 	mNumCollisions = 0;
 
-	collideConvexes(state);  // discrete convex collision, no friction
-	collideTriangles(state); // discrete triangle collision, no friction
+	if (mClothData.mNumConvexes || mClothData.mNumCollisionTriangles || mClothData.mDistanceField ||
+	    mClothData.mHeightfield)
+		loadParticleBlocks();
+
+	collideConvexes(state);      // discrete convex collision, no friction
+	collideTriangles(state);     // discrete triangle collision, no friction
+	collideDistanceField(state); // discrete distance field collision
+	collideHeightfield(state);   // discrete heightfield collision
 
 	computeBounds();
 
 	if (!mClothData.mNumSpheres)
-		return;
+	{
+		releaseParticleBlocks(true);
+		return false;
+	}
 
 	bool lastIteration = state.mRemainingIterations == 1;
 
@@ -316,20 +434,46 @@ void cloth::SwCollision<T4f>::operator()(const IterationState<T4f>& state)
 	// continuous collision might need it in next iteration
 	generateCones(mCurData.mCones, mCurData.mSpheres, mClothData.mCapsuleIndices, mClothData.mNumCapsules);
 
-	if (buildAcceleration())
+	if (!buildAcceleration())
 	{
-		if (mClothData.mEnableContinuousCollision)
-			collideContinuousParticles();
+		if (mPrevData.mSpheres)
+			ps::swap(mCurData, mPrevData);
+		releaseParticleBlocks(true);
+		return false;
+	}
+
+	// continuous collision uses the separate first/last grids, merge them afterwards
+	if (!mClothData.mEnableContinuousCollision)
+	{
+		mergeAcceleration(reinterpret_cast<uint32_t*>(mSphereGrid), mNumSphereWords, mGridStride);
+		mergeAcceleration(reinterpret_cast<uint32_t*>(mConeGrid), mNumConeWords, mGridStride);
+	}
+
+	return true;
+}
 
-		mergeAcceleration(reinterpret_cast<uint32_t*>(mSphereGrid));
-		mergeAcceleration(reinterpret_cast<uint32_t*>(mConeGrid));
+template <typename T4f>
+void cloth::SwCollision<T4f>::collideParticleRange(uint32_t first, uint32_t last)
+{
+	if (mClothData.mEnableContinuousCollision)
+		collideContinuousParticles(first, last);
+	else
+		collideParticles(first, last);
+}
 
-		if (!mClothData.mEnableContinuousCollision)
-			collideParticles();
+template <typename T4f>
+void cloth::SwCollision<T4f>::endCollision()
+{
+	releaseParticleBlocks(false);
 
-		collideVirtualParticles();
+	if (mClothData.mEnableContinuousCollision)
+	{
+		mergeAcceleration(reinterpret_cast<uint32_t*>(mSphereGrid), mNumSphereWords, mGridStride);
+		mergeAcceleration(reinterpret_cast<uint32_t*>(mConeGrid), mNumConeWords, mGridStride);
 	}
 
+	collideVirtualParticles();
+
 	if (mPrevData.mSpheres)
 		ps::swap(mCurData, mPrevData);
 }
@@ -340,10 +484,17 @@ size_t cloth::SwCollision<T4f>::estimateTemporaryMemory(const SwCloth& cloth)
 	size_t numTriangles = cloth.mStartCollisionTriangles.size();
 	size_t numPlanes = cloth.mStartCollisionPlanes.size();
 
-	const size_t kTriangleDataSize = sizeof(TriangleData) * numTriangles;
+	// triangle data, tree nodes and indices, plus the triangle bounds used while building the tree
+	const size_t kTriangleDataSize =
+	    (sizeof(TriangleData) + sizeof(TriangleNode) + sizeof(uint32_t) + 3 * sizeof(PxVec4)) * numTriangles + 64;
 	const size_t kPlaneDataSize = sizeof(PxVec4) * numPlanes * 2;
 
-	return std::max(kTriangleDataSize, kPlaneDataSize);
+	// particle blocks live through the convex, triangle, distance field and heightfield collision
+	size_t particleBlockSize = 0;
+	if (numTriangles || !cloth.mConvexMasks.empty() || !cloth.mDistanceField.empty() || !cloth.mHeightfield.empty())
+		particleBlockSize = sizeof(PxVec4) * ((cloth.mCurParticles.size() + 3) & ~3);
+
+	return particleBlockSize + std::max(kTriangleDataSize, kPlaneDataSize);
 }
 
 template <typename T4f>
@@ -378,19 +529,61 @@ void cloth::SwCollision<T4f>::computeBounds()
 {
 	NV_CLOTH_PROFILE_ZONE("cloth::SwSolverKernel::computeBounds", /*ProfileContext::None*/ 0);
 
-	T4f* prevIt = reinterpret_cast<T4f*>(mClothData.mPrevParticles);
-	T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles);
-	T4f* curEnd = curIt + mClothData.mNumParticles;
-	T4f floatMaxXYZ = -static_cast<T4f>(sMinusFloatMaxXYZ);
-
 	T4f lower = simd4f(FLT_MAX), upper = -lower;
-	for (; curIt < curEnd; ++curIt, ++prevIt)
+
+	if (mParticleBlocks)
 	{
-		T4f current = *curIt;
-		lower = min(lower, current);
-		upper = max(upper, current);
-		// if (current.w > 0) current.w = previous.w
-		*curIt = select(current > floatMaxXYZ, *prevIt, current);
+		// per axis bounds of each lane, invMass has been taken care of by loadParticleBlocks()
+		T4f blockLower[4] = { lower, lower, lower, lower };
+		T4f blockUpper[4] = { upper, upper, upper, upper };
+
+		const uint32_t numFullBlocks = mClothData.mNumParticles / 4;
+		const T4f* bIt = mParticleBlocks;
+		const T4f* bEnd = bIt + numFullBlocks * 4;
+		for (; bIt < bEnd; bIt += 4)
+		{
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				blockLower[i] = min(blockLower[i], bIt[i]);
+				blockUpper[i] = max(blockUpper[i], bIt[i]);
+			}
+		}
+
+		// skip the padding of the last block
+		if (uint32_t numRemaining = mClothData.mNumParticles - numFullBlocks * 4)
+		{
+			T4f mask = simd4f(simd4i(~0, numRemaining > 1 ? ~0 : 0, numRemaining > 2 ? ~0 : 0, 0));
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				blockLower[i] = select(mask, min(blockLower[i], bIt[i]), blockLower[i]);
+				blockUpper[i] = select(mask, max(blockUpper[i], bIt[i]), blockUpper[i]);
+			}
+		}
+
+		// reduce the lanes
+		transpose(blockLower[0], blockLower[1], blockLower[2], blockLower[3]);
+		transpose(blockUpper[0], blockUpper[1], blockUpper[2], blockUpper[3]);
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			lower = min(lower, blockLower[i]);
+			upper = max(upper, blockUpper[i]);
+		}
+	}
+	else
+	{
+		T4f* prevIt = reinterpret_cast<T4f*>(mClothData.mPrevParticles);
+		T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles);
+		T4f* curEnd = curIt + mClothData.mNumParticles;
+		T4f floatMaxXYZ = -static_cast<T4f>(sMinusFloatMaxXYZ);
+
+		for (; curIt < curEnd; ++curIt, ++prevIt)
+		{
+			T4f current = *curIt;
+			lower = min(lower, current);
+			upper = max(upper, current);
+			// if (current.w > 0) current.w = previous.w
+			*curIt = select(current > floatMaxXYZ, *prevIt, current);
+		}
 	}
 
 	BoundingBox<T4f> curBounds;
@@ -403,6 +596,59 @@ void cloth::SwCollision<T4f>::computeBounds()
 	storeBounds(mClothData.mPrevBounds, prevBounds);
 }
 
+template <typename T4f>
+void cloth::SwCollision<T4f>::loadParticleBlocks()
+{
+	const uint32_t numBlocks = (mClothData.mNumParticles + 3) / 4;
+	mParticleBlocks = static_cast<T4f*>(mAllocator.allocate(sizeof(T4f) * 4 * numBlocks));
+
+	T4f floatMaxXYZ = -static_cast<T4f>(sMinusFloatMaxXYZ);
+
+	const float* __restrict prevIt = mClothData.mPrevParticles;
+	const float* __restrict curIt = mClothData.mCurParticles;
+	T4f* __restrict bIt = mParticleBlocks;
+	T4f* bEnd = bIt + 4 * numBlocks;
+	for (; bIt < bEnd; bIt += 4, curIt += 16, prevIt += 16)
+	{
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			// if (current.w > 0) current.w = previous.w, done here instead of computeBounds()
+			// because the convex and triangle collision don't touch invMass
+			T4f current = loadAligned(curIt, i * 16);
+			bIt[i] = select(current > floatMaxXYZ, loadAligned(prevIt, i * 16), current);
+		}
+		transpose(bIt[0], bIt[1], bIt[2], bIt[3]);
+	}
+}
+
+// first needs to be a multiple of 4
+template <typename T4f>
+void cloth::SwCollision<T4f>::storeParticleBlocks(uint32_t first, uint32_t last)
+{
+	const T4f* __restrict bIt = mParticleBlocks + first;
+	float* __restrict curIt = mClothData.mCurParticles + first * 4;
+	float* __restrict curEnd = mClothData.mCurParticles + last * 4;
+	for (; curIt < curEnd; curIt += 16, bIt += 4)
+	{
+		T4f curPos[4];
+		loadBlock(bIt, curPos);
+		storeTransposed(curIt, curPos);
+	}
+}
+
+template <typename T4f>
+void cloth::SwCollision<T4f>::releaseParticleBlocks(bool writeBack)
+{
+	if (!mParticleBlocks)
+		return;
+
+	if (writeBack)
+		storeParticleBlocks(0, mClothData.mNumParticles);
+
+	mAllocator.deallocate(mParticleBlocks);
+	mParticleBlocks = 0;
+}
+
 namespace
 {
 template <typename T4i>
@@ -416,30 +662,30 @@ T4i andNotIsZero(const T4i& left, const T4i& right)
 template <typename T4f>
 void cloth::SwCollision<T4f>::buildSphereAcceleration(const SphereData* sIt)
 {
-	static const int maxIndex = sGridSize - 1;
-
-	uint32_t mask = 0x1; //single bit mask for current sphere
 	const SphereData* sEnd = sIt + mClothData.mNumSpheres;
-	for (; sIt != sEnd; ++sIt, mask <<= 1)
+	for (uint32_t sphereIndex = 0; sIt != sEnd; ++sIt, ++sphereIndex)
 	{
+		uint32_t mask = 0x1u << (sphereIndex & 31); //single bit mask for current sphere
 		T4f sphere = loadAligned(array(sIt->center));
 		T4f radius = splat<3>(sphere);
 
 		//calculate the first and last cell index, for each axis, that contains the sphere
-		T4i first = intFloor(min(max((sphere - radius) * mGridScale + mGridBias, gSimd4fZero), sGridLength)); //use both min and max to deal with bad grid scales
-		T4i last = intFloor(min(max((sphere + radius) * mGridScale + mGridBias, gSimd4fZero), sGridLength));
+		T4i first = intFloor(min(max((sphere - radius) * mGridScale + mGridBias, gSimd4fZero), mGridLength)); //use both min and max to deal with bad grid scales
+		T4i last = intFloor(min(max((sphere + radius) * mGridScale + mGridBias, gSimd4fZero), mGridLength));
 
-		const int* firstIdx = array(first);
-		const int* lastIdx = array(last);
+		// int lanes of T4i can't be read through array() under strict aliasing
+		int firstIdx[4], lastIdx[4];
+		store(firstIdx, first);
+		store(lastIdx, last);
 
-		uint32_t* firstIt = reinterpret_cast<uint32_t*>(mSphereGrid);
-		uint32_t* lastIt = firstIt + 3 * sGridSize;
+		uint32_t* firstIt = reinterpret_cast<uint32_t*>(mSphereGrid) + (sphereIndex >> 5) * 6 * mGridStride;
+		uint32_t* lastIt = firstIt + 3 * mGridStride;
 
 		//loop through the 3 axes 
-		for (uint32_t i = 0; i < 3; ++i, firstIt += sGridSize, lastIt += sGridSize)
+		for (uint32_t i = 0; i < 3; ++i, firstIt += mGridStride, lastIt += mGridStride)
 		{
 			//mark the sphere and everything to the right
-			for (int j = firstIdx[i]; j <= maxIndex; ++j)
+			for (int j = firstIdx[i], maxIndex = int(mNumCells[i]) - 1; j <= maxIndex; ++j)
 				firstIt[j] |= mask;
 
 			//mark the sphere and everything to the left
@@ -455,30 +701,42 @@ void cloth::SwCollision<T4f>::buildConeAcceleration()
 {
 	const ConeData* coneIt = mCurData.mCones;
 	const ConeData* coneEnd = coneIt + mClothData.mNumCapsules;
-	for (uint32_t coneMask = 0x1; coneIt != coneEnd; ++coneIt, coneMask <<= 1)
+	for (uint32_t coneIndex = 0; coneIt != coneEnd; ++coneIt, ++coneIndex)
 	{
 		if (coneIt->radius == 0.0f)
 			continue;
 
-		uint32_t spheresMask = coneIt->bothMask;
+		uint32_t coneMask = 0x1u << (coneIndex & 31);
+		uint32_t firstMask = coneIt->firstMask;
+		uint32_t secondMask = coneIt->secondMask;
+
+		// the two spheres may be in different words
+		const uint32_t* firstIt = reinterpret_cast<const uint32_t*>(mSphereGrid) + coneIt->firstWord * 6 * mGridStride;
+		const uint32_t* secondIt = reinterpret_cast<const uint32_t*>(mSphereGrid) + coneIt->secondWord * 6 * mGridStride;
+		uint32_t* gridIt = reinterpret_cast<uint32_t*>(mConeGrid) + (coneIndex >> 5) * 6 * mGridStride;
 
-		uint32_t* sphereIt = reinterpret_cast<uint32_t*>(mSphereGrid);
-		uint32_t* sphereEnd = sphereIt + 6 * sGridSize;
-		uint32_t* gridIt = reinterpret_cast<uint32_t*>(mConeGrid);
-		for (; sphereIt != sphereEnd; ++sphereIt, ++gridIt)
-			if (*sphereIt & spheresMask)
-				*gridIt |= coneMask;
+		// first and last cells of the 3 axes
+		for (uint32_t i = 0; i < 6; ++i, firstIt += mGridStride, secondIt += mGridStride, gridIt += mGridStride)
+		{
+			for (uint32_t j = 0, numCells = mNumCells[i % 3]; j < numCells; ++j)
+				if ((firstIt[j] & firstMask) | (secondIt[j] & secondMask))
+					gridIt[j] |= coneMask;
+		}
 	}
 }
 
 // convert right/left mask arrays into single overlap array
 template <typename T4f>
-void cloth::SwCollision<T4f>::mergeAcceleration(uint32_t* firstIt)
+void cloth::SwCollision<T4f>::mergeAcceleration(uint32_t* gridIt, uint32_t numWords, uint32_t gridStride)
 {
-	uint32_t* firstEnd = firstIt + 3 * sGridSize;
-	uint32_t* lastIt = firstEnd;
-	for (; firstIt != firstEnd; ++firstIt, ++lastIt)
-		*firstIt &= *lastIt;
+	for (uint32_t i = 0; i < numWords; ++i, gridIt += 6 * gridStride)
+	{
+		uint32_t* firstIt = gridIt;
+		uint32_t* firstEnd = firstIt + 3 * gridStride;
+		uint32_t* lastIt = firstEnd;
+		for (; firstIt != firstEnd; ++firstIt, ++lastIt)
+			*firstIt &= *lastIt;
+	}
 }
 
 // build mask of spheres/cones touching a regular grid along each axis
@@ -511,21 +769,52 @@ bool cloth::SwCollision<T4f>::buildAcceleration()
 	const T4f expandedUpper = bounds.mUpper + abs(bounds.mUpper) * sGridExpand;
 	const T4f expandedEdgeLength = max(expandedUpper - expandedLower, gSimd4fEpsilon);
 
+	// refine the grid along axes that are long compared to the average sphere, so that the shapes
+	// overlapping a cell depend on the local shape density rather than the total count.
+	// each refinement costs another gather per mask word, refine while the shape tests saved
+	// (assuming uniformly distributed shapes) outweigh the extra gathers
+	float diameter = 0.0f;
+	for (uint32_t i = 0; i < mClothData.mNumSpheres; ++i)
+		diameter += mCurData.mSpheres[i].radius;
+	diameter *= 2.0f / float(mClothData.mNumSpheres);
+
+	const float* edge = array(expandedEdgeLength);
+	float numCandidates = float(mClothData.mNumSpheres + mClothData.mNumCapsules);
+	for (uint32_t i = 0; i < 3; ++i)
+		numCandidates *= PxMin(1.0f, (diameter + edge[i] / sGridSize) / edge[i]);
+
+	const float refineCost = sGridRefineCost * float(mNumSphereWords + mNumConeWords);
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		mNumCells[i] = sGridSize;
+		for (; mNumCells[i] < sMaxGridSize; mNumCells[i] *= 2)
+		{
+			float cellLength = edge[i] / float(mNumCells[i]);
+			float ratio = (diameter + 0.5f * cellLength) / (diameter + cellLength);
+			if (numCandidates * (1.0f - ratio) < refineCost)
+				break;
+			numCandidates *= ratio;
+		}
+	}
+	mGridStride = PxMax(mNumCells[0], PxMax(mNumCells[1], mNumCells[2]));
+
 	// make grid minimal thickness and strict upper bound of spheres
-	// grid maps bounds to 0-7 space (sGridLength =~= 8)
-	mGridScale = sGridLength * recip<1>(expandedEdgeLength);
+	// grid maps bounds to 0-(mNumCells-1) space (mGridLength =~= mNumCells)
+	T4f numCells = simd4f(float(mNumCells[0]), float(mNumCells[1]), float(mNumCells[2]), float(sGridSize));
+	mGridLength = numCells - sGridMargin;
+	mGridScale = mGridLength * recip<1>(expandedEdgeLength);
 	mGridBias = -expandedLower * mGridScale;
 	array(mGridBias)[3] = 1.0f; // needed for collideVirtualParticles()
 
 	NV_CLOTH_ASSERT(allTrue(((bounds.mLower * mGridScale + mGridBias) >= simd4f(0.0f)) | sMaskW));
-	NV_CLOTH_ASSERT(allTrue(((bounds.mUpper * mGridScale + mGridBias) < simd4f(8.0f)) | sMaskW));
+	NV_CLOTH_ASSERT(allTrue(((bounds.mUpper * mGridScale + mGridBias) < mGridLength + sGridMargin) | sMaskW));
 
-	memset(mSphereGrid, 0, sizeof(uint32_t) * 6 * (sGridSize));
+	memset(mSphereGrid, 0, sizeof(uint32_t) * 6 * mGridStride * mNumSphereWords);
 	if (mClothData.mEnableContinuousCollision)
 		buildSphereAcceleration(mPrevData.mSpheres);
 	buildSphereAcceleration(mCurData.mSpheres);
 
-	memset(mConeGrid, 0, sizeof(uint32_t) * 6 * (sGridSize));
+	memset(mConeGrid, 0, sizeof(uint32_t) * 6 * mGridStride * mNumConeWords);
 	buildConeAcceleration();
 
 	return true;
@@ -537,44 +826,51 @@ bool cloth::SwCollision<T4f>::buildAcceleration()
 #define FORCE_INLINE inline __attribute__((always_inline))
 #endif
 
-template <typename T4f>
-FORCE_INLINE typename cloth::SwCollision<T4f>::ShapeMask& cloth::SwCollision<T4f>::ShapeMask::
-operator = (const ShapeMask& right)
+namespace
 {
-	mCones = right.mCones;
-	mSpheres = right.mSpheres;
-	return *this;
-}
-
-template <typename T4f>
-FORCE_INLINE typename cloth::SwCollision<T4f>::ShapeMask& cloth::SwCollision<T4f>::ShapeMask::
-operator &= (const ShapeMask& right)
+// gathers the cell masks along one axis, grids with more than 8 cells are gathered 8 cells at a time
+// and combined, the gather returns zero for indices outside of its cells
+template <typename T4i>
+FORCE_INLINE T4i gatherCells(const Gather<T4i>& gather, const T4i* cells, const T4i& index, uint32_t numCells)
 {
-	mCones = mCones & right.mCones;
-	mSpheres = mSpheres & right.mSpheres;
-	return *this;
+	T4i result = gather(cells);
+	for (uint32_t i = 8; i < numCells; i += 8)
+		result = result | Gather<T4i>(index - simd4i(int(i)))(cells + i / 4);
+	return result;
+}
 }
 
-// get collision shape masks from a single cell from a single axis of the acceleration structure
+// get collision shape masks from a single cell from a single axis of the acceleration structure,
+// axis selects the first (0-2) or last (3-5) cell masks along x, y, or z of each word
 template <typename T4f>
-FORCE_INLINE typename cloth::SwCollision<T4f>::ShapeMask
-cloth::SwCollision<T4f>::getShapeMask(const T4f& position, const T4i* __restrict sphereGrid,
-                                         const T4i* __restrict coneGrid)
+FORCE_INLINE void cloth::SwCollision<T4f>::getShapeMask(ShapeMask& result, const T4f& position, uint32_t axis,
+                                                         bool intersect) const
 {
 	// position are the grid positions along a single axis (x, y, or z)
-	Gather<T4i> gather(intFloor(position));
+	T4i index = intFloor(position);
+	Gather<T4i> gather(index);
+	const uint32_t numCells = mNumCells[axis % 3];
 
 	// get the bitmask indicating which cones/spheres overlap the grid cell
-	ShapeMask result;
-	result.mCones = gather(coneGrid);
-	result.mSpheres = gather(sphereGrid);
-	return result;
+	const uint32_t wordSize = 6 * mGridStride / 4;
+	const T4i* __restrict coneGrid = mConeGrid + axis * mGridStride / 4;
+	for (uint32_t i = 0; i < mNumConeWords; ++i, coneGrid += wordSize)
+	{
+		T4i cones = gatherCells(gather, coneGrid, index, numCells);
+		result.mCones[i] = intersect ? result.mCones[i] & cones : cones;
+	}
+
+	const T4i* __restrict sphereGrid = mSphereGrid + axis * mGridStride / 4;
+	for (uint32_t i = 0; i < mNumSphereWords; ++i, sphereGrid += wordSize)
+	{
+		T4i spheres = gatherCells(gather, sphereGrid, index, numCells);
+		result.mSpheres[i] = intersect ? result.mSpheres[i] & spheres : spheres;
+	}
 }
 
 // lookup acceleration structure and return mask of potential intersection collision shapes
 template <typename T4f>
-FORCE_INLINE typename cloth::SwCollision<T4f>::ShapeMask
-cloth::SwCollision<T4f>::getShapeMask(const T4f* __restrict positions) const
+FORCE_INLINE void cloth::SwCollision<T4f>::getShapeMask(ShapeMask& result, const T4f* __restrict positions) const
 {
 	// positions are the particle positions
 	T4f posX = positions[0] * splat<0>(mGridScale) + splat<0>(mGridBias);
@@ -583,19 +879,17 @@ cloth::SwCollision<T4f>::getShapeMask(const T4f* __restrict positions) const
 
 	// AND together the bit masks so only the cones/spheres remain
 	//  that overlap with the particle posision on all axis
-	ShapeMask result = getShapeMask(posX, mSphereGrid, mConeGrid); // X
-	result &= getShapeMask(posY, mSphereGrid + 2, mConeGrid + 2); // Y 
-	result &= getShapeMask(posZ, mSphereGrid + 4, mConeGrid + 4); // Z
-
-	return result;
+	getShapeMask(result, posX, 0, false); // X
+	getShapeMask(result, posY, 1, true); // Y
+	getShapeMask(result, posZ, 2, true); // Z
 }
 
 // lookup acceleration structure and return mask of potential intersection collision shapes for CCD
 template <typename T4f>
-FORCE_INLINE typename cloth::SwCollision<T4f>::ShapeMask
-cloth::SwCollision<T4f>::getShapeMask(const T4f* __restrict prevPos, const T4f* __restrict curPos) const
+FORCE_INLINE void cloth::SwCollision<T4f>::getShapeMask(ShapeMask& result, const T4f* __restrict prevPos,
+                                                         const T4f* __restrict curPos) const
 {
-	// same as getShapeMask(const T4f* __restrict positions) but for continuous collision detection
+	// same as getShapeMask(ShapeMask&, const T4f* __restrict positions) but for continuous collision detection
 	T4f scaleX = splat<0>(mGridScale);
 	T4f scaleY = splat<1>(mGridScale);
 	T4f scaleZ = splat<2>(mGridScale);
@@ -613,13 +907,13 @@ cloth::SwCollision<T4f>::getShapeMask(const T4f* __restrict prevPos, const T4f*
 	T4f curZ = curPos[2] * scaleZ + biasZ;
 
 	// get maximum extent corner of the AABB containing both prevPos and curPos
-	T4f maxX = min(max(prevX, curX), sGridLength);
-	T4f maxY = min(max(prevY, curY), sGridLength);
-	T4f maxZ = min(max(prevZ, curZ), sGridLength);
+	T4f maxX = min(max(prevX, curX), splat<0>(mGridLength));
+	T4f maxY = min(max(prevY, curY), splat<1>(mGridLength));
+	T4f maxZ = min(max(prevZ, curZ), splat<2>(mGridLength));
 
-	ShapeMask result = getShapeMask(maxX, mSphereGrid, mConeGrid); // X
-	result &= getShapeMask(maxY, mSphereGrid + 2, mConeGrid + 2); // Y
-	result &= getShapeMask(maxZ, mSphereGrid + 4, mConeGrid + 4); // Z
+	getShapeMask(result, maxX, 0, false); // X
+	getShapeMask(result, maxY, 1, true); // Y
+	getShapeMask(result, maxZ, 2, true); // Z
 
 	// get min extent corner of the AABB containing both prevPos and curPos
 	T4f zero = gSimd4fZero;
@@ -627,11 +921,9 @@ cloth::SwCollision<T4f>::getShapeMask(const T4f* __restrict prevPos, const T4f*
 	T4f minY = max(min(prevY, curY), zero);
 	T4f minZ = max(min(prevZ, curZ), zero);
 
-	result &= getShapeMask(minX, mSphereGrid + 6, mConeGrid + 6); // X
-	result &= getShapeMask(minY, mSphereGrid + 8, mConeGrid + 8); // Y
-	result &= getShapeMask(minZ, mSphereGrid + 10, mConeGrid + 10); // Z
-
-	return result;
+	getShapeMask(result, minX, 3, true); // X
+	getShapeMask(result, minY, 4, true); // Y
+	getShapeMask(result, minZ, 5, true); // Z
 }
 
 template <typename T4f>
@@ -693,55 +985,59 @@ struct cloth::SwCollision<T4f>::ImpulseAccumulator
 };
 
 template <typename T4f>
-FORCE_INLINE void cloth::SwCollision<T4f>::collideSpheres(const T4i& sphereMask, const T4f* positions,
+FORCE_INLINE void cloth::SwCollision<T4f>::collideSpheres(const T4i* sphereMask, const T4f* positions,
                                                              ImpulseAccumulator& accum) const
 {
 	const float* __restrict spherePtr = array(mCurData.mSpheres->center);
 
 	bool frictionEnabled = mClothData.mFrictionScale > 0.0f;
 
-	T4i mask4 = horizontalOr(sphereMask);
-	uint32_t mask = uint32_t(array(mask4)[0]);
-	while (mask)
+	for (uint32_t word = 0; word < mNumSphereWords; ++word)
 	{
-		uint32_t test = mask - 1;
-		uint32_t offset = findBitSet(mask & ~test) * sizeof(SphereData);
-		mask = mask & test;
+		int mask4[4];
+		store(mask4, horizontalOr(sphereMask[word]));
+		uint32_t mask = uint32_t(mask4[0]);
+		while (mask)
+		{
+			uint32_t test = mask - 1;
+			uint32_t offset = (word * 32 + findBitSet(mask & ~test)) * sizeof(SphereData);
+			mask = mask & test;
 
-		T4f sphere = loadAligned(spherePtr, offset);
+			T4f sphere = loadAligned(spherePtr, offset);
 
-		T4f deltaX = positions[0] - splat<0>(sphere);
-		T4f deltaY = positions[1] - splat<1>(sphere);
-		T4f deltaZ = positions[2] - splat<2>(sphere);
+			T4f deltaX = positions[0] - splat<0>(sphere);
+			T4f deltaY = positions[1] - splat<1>(sphere);
+			T4f deltaZ = positions[2] - splat<2>(sphere);
 
-		T4f sqrDistance = gSimd4fEpsilon + deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ;
-		T4f negativeScale = gSimd4fOne - rsqrt(sqrDistance) * splat<3>(sphere);
-		// negativeScale = 1 - radius/|position-sphere|
+			T4f sqrDistance = gSimd4fEpsilon + deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ;
+			T4f negativeScale = gSimd4fOne - rsqrt(sqrDistance) * splat<3>(sphere);
+			// negativeScale = 1 - radius/|position-sphere|
 
-		T4f contactMask;
-		if (!anyGreater(gSimd4fZero, negativeScale, contactMask))
-			continue;
+			T4f contactMask;
+			if (!anyGreater(gSimd4fZero, negativeScale, contactMask))
+				continue;
 
-		accum.subtract(deltaX, deltaY, deltaZ, negativeScale, contactMask);
-		// -= delta * negativeScale
-		//  = delta - delta * radius/|position-sphere|
+			accum.subtract(deltaX, deltaY, deltaZ, negativeScale, contactMask);
+			// -= delta * negativeScale
+			//  = delta - delta * radius/|position-sphere|
 
-		if (frictionEnabled)
-		{
-			// load previous sphere pos
-			const float* __restrict prevSpherePtr = array(mPrevData.mSpheres->center);
+			if (frictionEnabled)
+			{
+				// load previous sphere pos
+				const float* __restrict prevSpherePtr = array(mPrevData.mSpheres->center);
 
-			T4f prevSphere = loadAligned(prevSpherePtr, offset);
-			T4f velocity = sphere - prevSphere;
+				T4f prevSphere = loadAligned(prevSpherePtr, offset);
+				T4f velocity = sphere - prevSphere;
 
-			accum.addVelocity(splat<0>(velocity), splat<1>(velocity), splat<2>(velocity), contactMask);
+				accum.addVelocity(splat<0>(velocity), splat<1>(velocity), splat<2>(velocity), contactMask);
+			}
 		}
 	}
 }
 
 template <typename T4f>
-FORCE_INLINE typename cloth::SwCollision<T4f>::T4i
-cloth::SwCollision<T4f>::collideCones(const T4f* __restrict positions, ImpulseAccumulator& accum) const
+FORCE_INLINE void cloth::SwCollision<T4f>::collideCones(const T4f* __restrict positions, ShapeMask& shapeMask,
+                                                         ImpulseAccumulator& accum) const
 {
 	const float* __restrict centerPtr = array(mCurData.mCones->center);
 	const float* __restrict axisPtr = array(mCurData.mCones->axis);
@@ -749,133 +1045,141 @@ cloth::SwCollision<T4f>::collideCones(const T4f* __restrict positions, ImpulseAc
 
 	bool frictionEnabled = mClothData.mFrictionScale > 0.0f;
 
-	ShapeMask shapeMask = getShapeMask(positions);
-	T4i mask4 = horizontalOr(shapeMask.mCones);
-	uint32_t mask = uint32_t(array(mask4)[0]);
-	while (mask)
+	getShapeMask(shapeMask, positions);
+	for (uint32_t word = 0; word < mNumConeWords; ++word)
 	{
-		uint32_t test = mask - 1;
-		uint32_t coneIndex = findBitSet(mask & ~test);
-		uint32_t offset = coneIndex * sizeof(ConeData);
-		mask = mask & test;
+		T4i mask4 = horizontalOr(shapeMask.mCones[word]);
+		int maskLanes[4];
+		store(maskLanes, mask4);
+		uint32_t mask = uint32_t(maskLanes[0]);
+		while (mask)
+		{
+			uint32_t test = mask - 1;
+			uint32_t coneIndex = word * 32 + findBitSet(mask & ~test);
+			uint32_t offset = coneIndex * sizeof(ConeData);
+			mask = mask & test;
 
-		T4i test4 = mask4 - gSimd4iOne;
-		T4f culled = simd4f(andNotIsZero(shapeMask.mCones, test4));
-		mask4 = mask4 & test4;
+			T4i test4 = mask4 - gSimd4iOne;
+			T4f culled = simd4f(andNotIsZero(shapeMask.mCones[word], test4));
+			mask4 = mask4 & test4;
 
-		T4f center = loadAligned(centerPtr, offset);
+			T4f center = loadAligned(centerPtr, offset);
 
-		// offset from center of cone to particle
-		// delta = pos - center
-		T4f deltaX = positions[0] - splat<0>(center);
-		T4f deltaY = positions[1] - splat<1>(center);
-		T4f deltaZ = positions[2] - splat<2>(center);
+			// offset from center of cone to particle
+			// delta = pos - center
+			T4f deltaX = positions[0] - splat<0>(center);
+			T4f deltaY = positions[1] - splat<1>(center);
+			T4f deltaZ = positions[2] - splat<2>(center);
 
-		//axis of the cone
-		T4f axis = loadAligned(axisPtr, offset);
+			//axis of the cone
+			T4f axis = loadAligned(axisPtr, offset);
 
-		T4f axisX = splat<0>(axis);
-		T4f axisY = splat<1>(axis);
-		T4f axisZ = splat<2>(axis);
-		T4f slope = splat<3>(axis);
+			T4f axisX = splat<0>(axis);
+			T4f axisY = splat<1>(axis);
+			T4f axisZ = splat<2>(axis);
+			T4f slope = splat<3>(axis);
 
-		// distance along cone axis (from center)
-		T4f dot = deltaX * axisX + deltaY * axisY + deltaZ * axisZ;
-		// interpolate radius
-		T4f radius = dot * slope + splat<3>(center);
+			// distance along cone axis (from center)
+			T4f dot = deltaX * axisX + deltaY * axisY + deltaZ * axisZ;
+			// interpolate radius
+			T4f radius = dot * slope + splat<3>(center);
 
-		// set radius to zero if cone is culled
-		radius = max(radius, gSimd4fZero) & ~culled;
+			// set radius to zero if cone is culled
+			radius = max(radius, gSimd4fZero) & ~culled;
 
-		// distance to axis
-		// sqrDistance = |delta|^2 - |dot|^2
-		T4f sqrDistance = deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ - dot * dot;
+			// distance to axis
+			// sqrDistance = |delta|^2 - |dot|^2
+			T4f sqrDistance = deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ - dot * dot;
 
-		T4i auxiliary = loadAligned(auxiliaryPtr, offset);
-		T4i bothMask = splat<3>(auxiliary);
+			T4i auxiliary = loadAligned(auxiliaryPtr, offset);
+			T4i firstMask = splat<2>(auxiliary);
+			T4i secondMask = splat<3>(auxiliary);
 
-		T4f contactMask;
-		if (!anyGreater(radius * radius, sqrDistance, contactMask))
-		{
-			// cone only culled when spheres culled, ok to clear those too
-			shapeMask.mSpheres = shapeMask.mSpheres & ~bothMask;
-			continue;
-		}
+			// sphere masks of the capsule ends, may be the same word
+			T4i& firstSpheres = shapeMask.mSpheres[mCurData.mCones[coneIndex].firstWord];
+			T4i& secondSpheres = shapeMask.mSpheres[mCurData.mCones[coneIndex].secondWord];
+
+			T4f contactMask;
+			if (!anyGreater(radius * radius, sqrDistance, contactMask))
+			{
+				// cone only culled when spheres culled, ok to clear those too
+				firstSpheres = firstSpheres & ~firstMask;
+				secondSpheres = secondSpheres & ~secondMask;
+				continue;
+			}
 
-		// clamp to a small positive epsilon to avoid numerical error
-		// making sqrDistance negative when point lies on the cone axis
-		sqrDistance = max(sqrDistance, gSimd4fEpsilon);
+			// clamp to a small positive epsilon to avoid numerical error
+			// making sqrDistance negative when point lies on the cone axis
+			sqrDistance = max(sqrDistance, gSimd4fEpsilon);
 
-		T4f invDistance = rsqrt(sqrDistance);
+			T4f invDistance = rsqrt(sqrDistance);
 
-		//offset base to take slope in to account
-		T4f base = dot + slope * sqrDistance * invDistance;
+			//offset base to take slope in to account
+			T4f base = dot + slope * sqrDistance * invDistance;
 
-		// force left/rightMask to false if not inside cone
-		base = base & contactMask;
+			// force left/rightMask to false if not inside cone
+			base = base & contactMask;
 
-		T4f halfLength = splat<1>(simd4f(auxiliary));
-		T4i leftMask = simd4i(base < -halfLength);
-		T4i rightMask = simd4i(base > halfLength);
+			T4f halfLength = splat<1>(simd4f(auxiliary));
+			T4i leftMask = simd4i(base < -halfLength);
+			T4i rightMask = simd4i(base > halfLength);
 
-		// we use both mask because of the early out above.
-		T4i firstMask = splat<2>(auxiliary);
-		T4i secondMask = firstMask ^ bothMask;
-		shapeMask.mSpheres = shapeMask.mSpheres & ~(firstMask & ~leftMask);
-		shapeMask.mSpheres = shapeMask.mSpheres & ~(secondMask & ~rightMask);
+			// we use both mask because of the early out above.
+			firstSpheres = firstSpheres & ~(firstMask & ~leftMask);
+			secondSpheres = secondSpheres & ~(secondMask & ~rightMask);
 
-		//contact normal direction
-		deltaX = deltaX - base * axisX;
-		deltaY = deltaY - base * axisY;
-		deltaZ = deltaZ - base * axisZ;
+			//contact normal direction
+			deltaX = deltaX - base * axisX;
+			deltaY = deltaY - base * axisY;
+			deltaZ = deltaZ - base * axisZ;
 
-		T4f sqrCosine = splat<0>(simd4f(auxiliary));
-		T4f scale = radius * invDistance * sqrCosine - sqrCosine;
+			T4f sqrCosine = splat<0>(simd4f(auxiliary));
+			T4f scale = radius * invDistance * sqrCosine - sqrCosine;
 
-		contactMask = contactMask & ~simd4f(leftMask | rightMask);
+			contactMask = contactMask & ~simd4f(leftMask | rightMask);
 
-		if (!anyTrue(contactMask))
-			continue;
+			if (!anyTrue(contactMask))
+				continue;
 
-		accum.add(deltaX, deltaY, deltaZ, scale, contactMask);
+			accum.add(deltaX, deltaY, deltaZ, scale, contactMask);
 
-		if (frictionEnabled)
-		{
-			uint32_t s0 = mClothData.mCapsuleIndices[coneIndex].first;
-			uint32_t s1 = mClothData.mCapsuleIndices[coneIndex].second;
+			if (frictionEnabled)
+			{
+				uint32_t s0 = mClothData.mCapsuleIndices[coneIndex].first;
+				uint32_t s1 = mClothData.mCapsuleIndices[coneIndex].second;
 
-			float* prevSpheres = reinterpret_cast<float*>(mPrevData.mSpheres);
-			float* curSpheres = reinterpret_cast<float*>(mCurData.mSpheres);
+				float* prevSpheres = reinterpret_cast<float*>(mPrevData.mSpheres);
+				float* curSpheres = reinterpret_cast<float*>(mCurData.mSpheres);
 
-			// todo: could pre-compute sphere velocities or it might be
-			// faster to compute cur/prev sphere positions directly
-			T4f s0p0 = loadAligned(prevSpheres, s0 * sizeof(SphereData));
-			T4f s0p1 = loadAligned(curSpheres, s0 * sizeof(SphereData));
+				// todo: could pre-compute sphere velocities or it might be
+				// faster to compute cur/prev sphere positions directly
+				T4f s0p0 = loadAligned(prevSpheres, s0 * sizeof(SphereData));
+				T4f s0p1 = loadAligned(curSpheres, s0 * sizeof(SphereData));
 
-			T4f s1p0 = loadAligned(prevSpheres, s1 * sizeof(SphereData));
-			T4f s1p1 = loadAligned(curSpheres, s1 * sizeof(SphereData));
+				T4f s1p0 = loadAligned(prevSpheres, s1 * sizeof(SphereData));
+				T4f s1p1 = loadAligned(curSpheres, s1 * sizeof(SphereData));
 
-			T4f v0 = s0p1 - s0p0;
-			T4f v1 = s1p1 - s1p0;
-			T4f vd = v1 - v0;
+				T4f v0 = s0p1 - s0p0;
+				T4f v1 = s1p1 - s1p0;
+				T4f vd = v1 - v0;
 
-			// dot is in the range -1 to 1, scale and bias to 0 to 1
-			dot = dot * gSimd4fHalf + gSimd4fHalf;
+				// dot is in the range -1 to 1, scale and bias to 0 to 1
+				dot = dot * gSimd4fHalf + gSimd4fHalf;
 
-			// interpolate velocity at contact points
-			T4f vx = splat<0>(v0) + dot * splat<0>(vd);
-			T4f vy = splat<1>(v0) + dot * splat<1>(vd);
-			T4f vz = splat<2>(v0) + dot * splat<2>(vd);
+				// interpolate velocity at contact points
+				T4f vx = splat<0>(v0) + dot * splat<0>(vd);
+				T4f vy = splat<1>(v0) + dot * splat<1>(vd);
+				T4f vz = splat<2>(v0) + dot * splat<2>(vd);
 
-			accum.addVelocity(vx, vy, vz, contactMask);
+				accum.addVelocity(vx, vy, vz, contactMask);
+			}
 		}
 	}
 
-	return shapeMask.mSpheres;
 }
 
 template <typename T4f>
-FORCE_INLINE void cloth::SwCollision<T4f>::collideSpheres(const T4i& sphereMask, const T4f* __restrict prevPos,
+FORCE_INLINE void cloth::SwCollision<T4f>::collideSpheres(const T4i* sphereMask, const T4f* __restrict prevPos,
                                                              T4f* __restrict curPos, ImpulseAccumulator& accum) const
 {
 	const float* __restrict prevSpheres = array(mPrevData.mSpheres->center);
@@ -883,99 +1187,102 @@ FORCE_INLINE void cloth::SwCollision<T4f>::collideSpheres(const T4i& sphereMask,
 
 	bool frictionEnabled = mClothData.mFrictionScale > 0.0f;
 
-	T4i mask4 = horizontalOr(sphereMask);
-	uint32_t mask = uint32_t(array(mask4)[0]);
-	while (mask)
+	for (uint32_t word = 0; word < mNumSphereWords; ++word)
 	{
-		uint32_t test = mask - 1;
-		uint32_t offset = findBitSet(mask & ~test) * sizeof(SphereData);
-		mask = mask & test;
-
-		T4f prevSphere = loadAligned(prevSpheres, offset);
-		T4f prevX = prevPos[0] - splat<0>(prevSphere);
-		T4f prevY = prevPos[1] - splat<1>(prevSphere);
-		T4f prevZ = prevPos[2] - splat<2>(prevSphere);
-		T4f prevRadius = splat<3>(prevSphere);
-
-		T4f curSphere = loadAligned(curSpheres, offset);
-		T4f curX = curPos[0] - splat<0>(curSphere);
-		T4f curY = curPos[1] - splat<1>(curSphere);
-		T4f curZ = curPos[2] - splat<2>(curSphere);
-		T4f curRadius = splat<3>(curSphere);
-
-		T4f sqrDistance = gSimd4fEpsilon + curX * curX + curY * curY + curZ * curZ;
-
-		T4f dotPrevPrev = prevX * prevX + prevY * prevY + prevZ * prevZ - prevRadius * prevRadius;
-		T4f dotPrevCur = prevX * curX + prevY * curY + prevZ * curZ - prevRadius * curRadius;
-		T4f dotCurCur = sqrDistance - curRadius * curRadius;
-
-		T4f discriminant = dotPrevCur * dotPrevCur - dotCurCur * dotPrevPrev;
-		T4f sqrtD = sqrt(discriminant); //we get -nan if there are no roots
-		T4f halfB = dotPrevCur - dotPrevPrev;
-		T4f minusA = dotPrevCur - dotCurCur + halfB;
-
-		// time of impact or 0 if prevPos inside sphere
-		T4f toi = recip(minusA) * min(gSimd4fZero, halfB + sqrtD);
-		T4f collisionMask = (toi < gSimd4fOne) & (halfB < sqrtD);
-
-		// skip continuous collision if the (un-clamped) particle
-		// trajectory only touches the outer skin of the cone.
-		T4f rMin = prevRadius + halfB * minusA * (curRadius - prevRadius);
-		collisionMask = collisionMask & (discriminant > minusA * rMin * rMin * sSkeletonWidth);
-
-		// a is negative when one relative sphere is contained in the other,
-		// which is already handled by discrete collision.
-		collisionMask = collisionMask & (minusA < -static_cast<T4f>(gSimd4fEpsilon));
-
-		if (!allEqual(collisionMask, gSimd4fZero))
+		int mask4[4];
+		store(mask4, horizontalOr(sphereMask[word]));
+		uint32_t mask = uint32_t(mask4[0]);
+		while (mask)
 		{
-			T4f deltaX = prevX - curX;
-			T4f deltaY = prevY - curY;
-			T4f deltaZ = prevZ - curZ;
+			uint32_t test = mask - 1;
+			uint32_t offset = (word * 32 + findBitSet(mask & ~test)) * sizeof(SphereData);
+			mask = mask & test;
+
+			T4f prevSphere = loadAligned(prevSpheres, offset);
+			T4f prevX = prevPos[0] - splat<0>(prevSphere);
+			T4f prevY = prevPos[1] - splat<1>(prevSphere);
+			T4f prevZ = prevPos[2] - splat<2>(prevSphere);
+			T4f prevRadius = splat<3>(prevSphere);
+
+			T4f curSphere = loadAligned(curSpheres, offset);
+			T4f curX = curPos[0] - splat<0>(curSphere);
+			T4f curY = curPos[1] - splat<1>(curSphere);
+			T4f curZ = curPos[2] - splat<2>(curSphere);
+			T4f curRadius = splat<3>(curSphere);
+
+			T4f sqrDistance = gSimd4fEpsilon + curX * curX + curY * curY + curZ * curZ;
+
+			T4f dotPrevPrev = prevX * prevX + prevY * prevY + prevZ * prevZ - prevRadius * prevRadius;
+			T4f dotPrevCur = prevX * curX + prevY * curY + prevZ * curZ - prevRadius * curRadius;
+			T4f dotCurCur = sqrDistance - curRadius * curRadius;
+
+			T4f discriminant = dotPrevCur * dotPrevCur - dotCurCur * dotPrevPrev;
+			T4f sqrtD = sqrt(discriminant); //we get -nan if there are no roots
+			T4f halfB = dotPrevCur - dotPrevPrev;
+			T4f minusA = dotPrevCur - dotCurCur + halfB;
+
+			// time of impact or 0 if prevPos inside sphere
+			T4f toi = recip(minusA) * min(gSimd4fZero, halfB + sqrtD);
+			T4f collisionMask = (toi < gSimd4fOne) & (halfB < sqrtD);
+
+			// skip continuous collision if the (un-clamped) particle
+			// trajectory only touches the outer skin of the cone.
+			T4f rMin = prevRadius + halfB * minusA * (curRadius - prevRadius);
+			collisionMask = collisionMask & (discriminant > minusA * rMin * rMin * sSkeletonWidth);
+
+			// a is negative when one relative sphere is contained in the other,
+			// which is already handled by discrete collision.
+			collisionMask = collisionMask & (minusA < -static_cast<T4f>(gSimd4fEpsilon));
+
+			if (!allEqual(collisionMask, gSimd4fZero))
+			{
+				T4f deltaX = prevX - curX;
+				T4f deltaY = prevY - curY;
+				T4f deltaZ = prevZ - curZ;
 
-			T4f oneMinusToi = (gSimd4fOne - toi) & collisionMask;
+				T4f oneMinusToi = (gSimd4fOne - toi) & collisionMask;
 
-			// reduce ccd impulse if (clamped) particle trajectory stays in sphere skin,
-			// i.e. scale by exp2(-k) or 1/(1+k) with k = (tmin - toi) / (1 - toi)
-			T4f minusK = sqrtD * recip(minusA * oneMinusToi) & (oneMinusToi > gSimd4fEpsilon);
-			oneMinusToi = oneMinusToi * recip(gSimd4fOne - minusK);
+				// reduce ccd impulse if (clamped) particle trajectory stays in sphere skin,
+				// i.e. scale by exp2(-k) or 1/(1+k) with k = (tmin - toi) / (1 - toi)
+				T4f minusK = sqrtD * recip(minusA * oneMinusToi) & (oneMinusToi > gSimd4fEpsilon);
+				oneMinusToi = oneMinusToi * recip(gSimd4fOne - minusK);
 
 
-			//Move curXYZ to toi point
-			curX = curX + deltaX * oneMinusToi;
-			curY = curY + deltaY * oneMinusToi;
-			curZ = curZ + deltaZ * oneMinusToi;
-			//curXYZ is now touching the sphere at toi
-			//Note that curXYZ is also relative to the sphere center at toi
+				//Move curXYZ to toi point
+				curX = curX + deltaX * oneMinusToi;
+				curY = curY + deltaY * oneMinusToi;
+				curZ = curZ + deltaZ * oneMinusToi;
+				//curXYZ is now touching the sphere at toi
+				//Note that curXYZ is also relative to the sphere center at toi
 
-			//We assume that the point sticks to the sphere until the end of the frame
-			curPos[0] = splat<0>(curSphere) + curX;
-			curPos[1] = splat<1>(curSphere) + curY;
-			curPos[2] = splat<2>(curSphere) + curZ;
+				//We assume that the point sticks to the sphere until the end of the frame
+				curPos[0] = splat<0>(curSphere) + curX;
+				curPos[1] = splat<1>(curSphere) + curY;
+				curPos[2] = splat<2>(curSphere) + curZ;
 
-			sqrDistance = gSimd4fEpsilon + curX * curX + curY * curY + curZ * curZ;
-		}
+				sqrDistance = gSimd4fEpsilon + curX * curX + curY * curY + curZ * curZ;
+			}
 
-		T4f negativeScale = gSimd4fOne - rsqrt(sqrDistance) * curRadius;
+			T4f negativeScale = gSimd4fOne - rsqrt(sqrDistance) * curRadius;
 
-		T4f contactMask;
-		if (!anyGreater(gSimd4fZero, negativeScale, contactMask))
-			continue;
+			T4f contactMask;
+			if (!anyGreater(gSimd4fZero, negativeScale, contactMask))
+				continue;
 
-		accum.subtract(curX, curY, curZ, negativeScale, contactMask);
+			accum.subtract(curX, curY, curZ, negativeScale, contactMask);
 
-		if (frictionEnabled)
-		{
-			T4f velocity = curSphere - prevSphere;
-			accum.addVelocity(splat<0>(velocity), splat<1>(velocity), splat<2>(velocity), contactMask);
+			if (frictionEnabled)
+			{
+				T4f velocity = curSphere - prevSphere;
+				accum.addVelocity(splat<0>(velocity), splat<1>(velocity), splat<2>(velocity), contactMask);
+			}
 		}
 	}
 }
 
 template <typename T4f>
-FORCE_INLINE typename cloth::SwCollision<T4f>::T4i
-cloth::SwCollision<T4f>::collideCones(const T4f* __restrict prevPos, T4f* __restrict curPos,
-                                         ImpulseAccumulator& accum) const
+FORCE_INLINE void cloth::SwCollision<T4f>::collideCones(const T4f* __restrict prevPos, T4f* __restrict curPos,
+                                                         ShapeMask& shapeMask, ImpulseAccumulator& accum) const
 {
 	const float* __restrict prevCenterPtr = array(mPrevData.mCones->center);
 	const float* __restrict prevAxisPtr = array(mPrevData.mCones->axis);
@@ -987,238 +1294,246 @@ cloth::SwCollision<T4f>::collideCones(const T4f* __restrict prevPos, T4f* __rest
 
 	bool frictionEnabled = mClothData.mFrictionScale > 0.0f;
 
-	ShapeMask shapeMask = getShapeMask(prevPos, curPos);
-	T4i mask4 = horizontalOr(shapeMask.mCones);
-	uint32_t mask = uint32_t(array(mask4)[0]);
-	while (mask)
+	getShapeMask(shapeMask, prevPos, curPos);
+	for (uint32_t word = 0; word < mNumConeWords; ++word)
 	{
-		uint32_t test = mask - 1;
-		uint32_t coneIndex = findBitSet(mask & ~test);
-		uint32_t offset = coneIndex * sizeof(ConeData);
-		mask = mask & test;
-
-		T4i test4 = mask4 - gSimd4iOne;
-		T4f culled = simd4f(andNotIsZero(shapeMask.mCones, test4));
-		mask4 = mask4 & test4;
-
-		T4f prevCenter = loadAligned(prevCenterPtr, offset);
-		T4f prevAxis = loadAligned(prevAxisPtr, offset);
-		T4f prevAxisX = splat<0>(prevAxis);
-		T4f prevAxisY = splat<1>(prevAxis);
-		T4f prevAxisZ = splat<2>(prevAxis);
-		T4f prevSlope = splat<3>(prevAxis);
-
-		T4f prevX = prevPos[0] - splat<0>(prevCenter);
-		T4f prevY = prevPos[1] - splat<1>(prevCenter);
-		T4f prevZ = prevPos[2] - splat<2>(prevCenter);
-		T4f prevT = prevY * prevAxisZ - prevZ * prevAxisY;
-		T4f prevU = prevZ * prevAxisX - prevX * prevAxisZ;
-		T4f prevV = prevX * prevAxisY - prevY * prevAxisX;
-		T4f prevDot = prevX * prevAxisX + prevY * prevAxisY + prevZ * prevAxisZ; //distance along the axis
-		T4f prevRadius = prevDot * prevSlope + splat<3>(prevCenter);
-
-		T4f curCenter = loadAligned(curCenterPtr, offset);
-		T4f curAxis = loadAligned(curAxisPtr, offset);
-		T4f curAxisX = splat<0>(curAxis);
-		T4f curAxisY = splat<1>(curAxis);
-		T4f curAxisZ = splat<2>(curAxis);
-		T4f curSlope = splat<3>(curAxis);
-		T4i curAuxiliary = loadAligned(curAuxiliaryPtr, offset);
-
-		T4f curX = curPos[0] - splat<0>(curCenter);
-		T4f curY = curPos[1] - splat<1>(curCenter);
-		T4f curZ = curPos[2] - splat<2>(curCenter);
-		//curTUV = cross(curXYZ, curAxisXYZ)
-		T4f curT = curY * curAxisZ - curZ * curAxisY;
-		T4f curU = curZ * curAxisX - curX * curAxisZ;
-		T4f curV = curX * curAxisY - curY * curAxisX;
-		T4f curDot = curX * curAxisX + curY * curAxisY + curZ * curAxisZ;
-		T4f curRadius = curDot * curSlope + splat<3>(curCenter);
-
-		//Magnitude of cross product gives area of parallelogram |curAxisXYZ|*parallelogramHeight, |curAxisXYZ|=1 
-		//parallelogramHeight is distance between the axis and the point
-		T4f curSqrDistance = gSimd4fEpsilon + curT * curT + curU * curU + curV * curV;
-
-		// set radius to zero if cone is culled
-		prevRadius = max(prevRadius, gSimd4fZero) & ~culled;
-		curRadius = max(curRadius, gSimd4fZero) & ~culled;
-
-		//Use quadratic equation to solve for time of impact (against infinite cone)
-		T4f dotPrevPrev = prevT * prevT + prevU * prevU + prevV * prevV - prevRadius * prevRadius;
-		T4f dotPrevCur = prevT * curT + prevU * curU + prevV * curV - prevRadius * curRadius;
-		T4f dotCurCur = curSqrDistance - curRadius * curRadius;
-
-		T4f discriminant = dotPrevCur * dotPrevCur - dotCurCur * dotPrevPrev;
-		T4f sqrtD = sqrt(discriminant);
-		T4f halfB = dotPrevCur - dotPrevPrev;
-		T4f minusA = dotPrevCur - dotCurCur + halfB;
-
-		// time of impact or 0 if prevPos inside cone
-		T4f toi = recip(minusA) * min(gSimd4fZero, halfB + sqrtD);
-		T4f collisionMask = (toi < gSimd4fOne) & (halfB < sqrtD);
-
-		// skip continuous collision if the (un-clamped) particle
-		// trajectory only touches the outer skin of the cone.
-		T4f rMin = prevRadius + halfB * minusA * (curRadius - prevRadius);
-		collisionMask = collisionMask & (discriminant > minusA * rMin * rMin * sSkeletonWidth);
-
-		// a is negative when one cone is contained in the other,
-		// which is already handled by discrete collision.
-		collisionMask = collisionMask & (minusA < -static_cast<T4f>(gSimd4fEpsilon));
-
-		// test if any particle hits infinite cone (and 0<time of impact<1)
-		if (!allEqual(collisionMask, gSimd4fZero))
+		T4i mask4 = horizontalOr(shapeMask.mCones[word]);
+		int maskLanes[4];
+		store(maskLanes, mask4);
+		uint32_t mask = uint32_t(maskLanes[0]);
+		while (mask)
 		{
-			T4f deltaX = prevX - curX;
-			T4f deltaY = prevY - curY;
-			T4f deltaZ = prevZ - curZ;
-
-			// interpolate delta at toi
-			T4f posX = prevX - deltaX * toi;
-			T4f posY = prevY - deltaY * toi;
-			T4f posZ = prevZ - deltaZ * toi;
-
-			//                                axisHalfLength
-			T4f curScaledAxis = curAxis * splat<1>(simd4f(curAuxiliary));
-			T4i prevAuxiliary = loadAligned(prevAuxiliaryPtr, offset);
-			T4f deltaScaledAxis = curScaledAxis - prevAxis * splat<1>(simd4f(prevAuxiliary));
-
-			T4f oneMinusToi = gSimd4fOne - toi;
-
-			// interpolate axis at toi
-			T4f axisX = splat<0>(curScaledAxis) - splat<0>(deltaScaledAxis) * oneMinusToi;
-			T4f axisY = splat<1>(curScaledAxis) - splat<1>(deltaScaledAxis) * oneMinusToi;
-			T4f axisZ = splat<2>(curScaledAxis) - splat<2>(deltaScaledAxis) * oneMinusToi;
-			T4f slope = (prevSlope * oneMinusToi + curSlope * toi);
-
-			T4f sqrHalfLength = axisX * axisX + axisY * axisY + axisZ * axisZ;
-			T4f invHalfLength = rsqrt(sqrHalfLength);
-			// distance along toi cone axis (from center)
-			T4f dot = (posX * axisX + posY * axisY + posZ * axisZ) * invHalfLength;
-
-			//point line distance
-			T4f sqrDistance = posX * posX + posY * posY + posZ * posZ - dot * dot;
-			T4f invDistance = rsqrt(sqrDistance) & (sqrDistance > gSimd4fZero);
-
-			//offset base to take slope in to account
-			T4f base = dot + slope * sqrDistance * invDistance;
-			T4f scale = base * invHalfLength & collisionMask;
-			// use invHalfLength to map base from [-HalfLength, +HalfLength]=inside to [-1, +1] =inside
-
-			// test if any impact position is in cone section
-			T4f cullMask = (abs(scale) < gSimd4fOne) & collisionMask;
-
-			// test if any impact position is in cone section
-			if (!allEqual(cullMask, gSimd4fZero))
+			uint32_t test = mask - 1;
+			uint32_t coneIndex = word * 32 + findBitSet(mask & ~test);
+			uint32_t offset = coneIndex * sizeof(ConeData);
+			mask = mask & test;
+
+			T4i test4 = mask4 - gSimd4iOne;
+			T4f culled = simd4f(andNotIsZero(shapeMask.mCones[word], test4));
+			mask4 = mask4 & test4;
+
+			T4f prevCenter = loadAligned(prevCenterPtr, offset);
+			T4f prevAxis = loadAligned(prevAxisPtr, offset);
+			T4f prevAxisX = splat<0>(prevAxis);
+			T4f prevAxisY = splat<1>(prevAxis);
+			T4f prevAxisZ = splat<2>(prevAxis);
+			T4f prevSlope = splat<3>(prevAxis);
+
+			T4f prevX = prevPos[0] - splat<0>(prevCenter);
+			T4f prevY = prevPos[1] - splat<1>(prevCenter);
+			T4f prevZ = prevPos[2] - splat<2>(prevCenter);
+			T4f prevT = prevY * prevAxisZ - prevZ * prevAxisY;
+			T4f prevU = prevZ * prevAxisX - prevX * prevAxisZ;
+			T4f prevV = prevX * prevAxisY - prevY * prevAxisX;
+			T4f prevDot = prevX * prevAxisX + prevY * prevAxisY + prevZ * prevAxisZ; //distance along the axis
+			T4f prevRadius = prevDot * prevSlope + splat<3>(prevCenter);
+
+			T4f curCenter = loadAligned(curCenterPtr, offset);
+			T4f curAxis = loadAligned(curAxisPtr, offset);
+			T4f curAxisX = splat<0>(curAxis);
+			T4f curAxisY = splat<1>(curAxis);
+			T4f curAxisZ = splat<2>(curAxis);
+			T4f curSlope = splat<3>(curAxis);
+			T4i curAuxiliary = loadAligned(curAuxiliaryPtr, offset);
+
+			T4f curX = curPos[0] - splat<0>(curCenter);
+			T4f curY = curPos[1] - splat<1>(curCenter);
+			T4f curZ = curPos[2] - splat<2>(curCenter);
+			//curTUV = cross(curXYZ, curAxisXYZ)
+			T4f curT = curY * curAxisZ - curZ * curAxisY;
+			T4f curU = curZ * curAxisX - curX * curAxisZ;
+			T4f curV = curX * curAxisY - curY * curAxisX;
+			T4f curDot = curX * curAxisX + curY * curAxisY + curZ * curAxisZ;
+			T4f curRadius = curDot * curSlope + splat<3>(curCenter);
+
+			//Magnitude of cross product gives area of parallelogram |curAxisXYZ|*parallelogramHeight, |curAxisXYZ|=1 
+			//parallelogramHeight is distance between the axis and the point
+			T4f curSqrDistance = gSimd4fEpsilon + curT * curT + curU * curU + curV * curV;
+
+			// set radius to zero if cone is culled
+			prevRadius = max(prevRadius, gSimd4fZero) & ~culled;
+			curRadius = max(curRadius, gSimd4fZero) & ~culled;
+
+			//Use quadratic equation to solve for time of impact (against infinite cone)
+			T4f dotPrevPrev = prevT * prevT + prevU * prevU + prevV * prevV - prevRadius * prevRadius;
+			T4f dotPrevCur = prevT * curT + prevU * curU + prevV * curV - prevRadius * curRadius;
+			T4f dotCurCur = curSqrDistance - curRadius * curRadius;
+
+			T4f discriminant = dotPrevCur * dotPrevCur - dotCurCur * dotPrevPrev;
+			T4f sqrtD = sqrt(discriminant);
+			T4f halfB = dotPrevCur - dotPrevPrev;
+			T4f minusA = dotPrevCur - dotCurCur + halfB;
+
+			// time of impact or 0 if prevPos inside cone
+			T4f toi = recip(minusA) * min(gSimd4fZero, halfB + sqrtD);
+			T4f collisionMask = (toi < gSimd4fOne) & (halfB < sqrtD);
+
+			// skip continuous collision if the (un-clamped) particle
+			// trajectory only touches the outer skin of the cone.
+			T4f rMin = prevRadius + halfB * minusA * (curRadius - prevRadius);
+			collisionMask = collisionMask & (discriminant > minusA * rMin * rMin * sSkeletonWidth);
+
+			// a is negative when one cone is contained in the other,
+			// which is already handled by discrete collision.
+			collisionMask = collisionMask & (minusA < -static_cast<T4f>(gSimd4fEpsilon));
+
+			// test if any particle hits infinite cone (and 0<time of impact<1)
+			if (!allEqual(collisionMask, gSimd4fZero))
 			{
-				//calculate unnormalized normal delta?
-				//delta = prev - cur - (prevAxis - curScaledAxis)*scale
-				deltaX = deltaX + splat<0>(deltaScaledAxis) * scale;
-				deltaY = deltaY + splat<1>(deltaScaledAxis) * scale;
-				deltaZ = deltaZ + splat<2>(deltaScaledAxis) * scale;
-
-				oneMinusToi = oneMinusToi & cullMask;
-
-				// reduce ccd impulse if (clamped) particle trajectory stays in cone skin,
-				// i.e. scale by exp2(-k) or 1/(1+k) with k = (tmin - toi) / (1 - toi)
-				// oneMinusToi = oneMinusToi * recip(gSimd4fOne - sqrtD * recip(minusA * oneMinusToi));
-				T4f minusK = sqrtD * recip(minusA * oneMinusToi) & (oneMinusToi > gSimd4fEpsilon);
-				oneMinusToi = oneMinusToi * recip(gSimd4fOne - minusK);
-
-				//curX = cur + (prev - cur - (prevAxis - curScaledAxis)*scale)*(1-toi)
-				//curX = cur + (prev - cur)*(1-toi) - ((prevAxis - curScaledAxis)*scale)*(1-toi)
-				curX = curX + deltaX * oneMinusToi; 
-				curY = curY + deltaY * oneMinusToi;
-				curZ = curZ + deltaZ * oneMinusToi;
-
-				//save adjusted values for discrete collision detection below
-				curDot = curX * curAxisX + curY * curAxisY + curZ * curAxisZ;
-				curRadius = curDot * curSlope + splat<3>(curCenter);
-				curRadius = max(curRadius, gSimd4fZero) & ~culled;
-				curSqrDistance = curX * curX + curY * curY + curZ * curZ - curDot * curDot;
-
-				//take offset from toi and add it to the cone center at the end
-				curPos[0] = splat<0>(curCenter) + curX;
-				curPos[1] = splat<1>(curCenter) + curY;
-				curPos[2] = splat<2>(curCenter) + curZ;
+				T4f deltaX = prevX - curX;
+				T4f deltaY = prevY - curY;
+				T4f deltaZ = prevZ - curZ;
+
+				// interpolate delta at toi
+				T4f posX = prevX - deltaX * toi;
+				T4f posY = prevY - deltaY * toi;
+				T4f posZ = prevZ - deltaZ * toi;
+
+				//                                axisHalfLength
+				T4f curScaledAxis = curAxis * splat<1>(simd4f(curAuxiliary));
+				T4i prevAuxiliary = loadAligned(prevAuxiliaryPtr, offset);
+				T4f deltaScaledAxis = curScaledAxis - prevAxis * splat<1>(simd4f(prevAuxiliary));
+
+				T4f oneMinusToi = gSimd4fOne - toi;
+
+				// interpolate axis at toi
+				T4f axisX = splat<0>(curScaledAxis) - splat<0>(deltaScaledAxis) * oneMinusToi;
+				T4f axisY = splat<1>(curScaledAxis) - splat<1>(deltaScaledAxis) * oneMinusToi;
+				T4f axisZ = splat<2>(curScaledAxis) - splat<2>(deltaScaledAxis) * oneMinusToi;
+				T4f slope = (prevSlope * oneMinusToi + curSlope * toi);
+
+				T4f sqrHalfLength = axisX * axisX + axisY * axisY + axisZ * axisZ;
+				T4f invHalfLength = rsqrt(sqrHalfLength);
+				// distance along toi cone axis (from center)
+				T4f dot = (posX * axisX + posY * axisY + posZ * axisZ) * invHalfLength;
+
+				//point line distance
+				T4f sqrDistance = posX * posX + posY * posY + posZ * posZ - dot * dot;
+				T4f invDistance = rsqrt(sqrDistance) & (sqrDistance > gSimd4fZero);
+
+				//offset base to take slope in to account
+				T4f base = dot + slope * sqrDistance * invDistance;
+				T4f scale = base * invHalfLength & collisionMask;
+				// use invHalfLength to map base from [-HalfLength, +HalfLength]=inside to [-1, +1] =inside
+
+				// test if any impact position is in cone section
+				T4f cullMask = (abs(scale) < gSimd4fOne) & collisionMask;
+
+				// test if any impact position is in cone section
+				if (!allEqual(cullMask, gSimd4fZero))
+				{
+					//calculate unnormalized normal delta?
+					//delta = prev - cur - (prevAxis - curScaledAxis)*scale
+					deltaX = deltaX + splat<0>(deltaScaledAxis) * scale;
+					deltaY = deltaY + splat<1>(deltaScaledAxis) * scale;
+					deltaZ = deltaZ + splat<2>(deltaScaledAxis) * scale;
+
+					oneMinusToi = oneMinusToi & cullMask;
+
+					// reduce ccd impulse if (clamped) particle trajectory stays in cone skin,
+					// i.e. scale by exp2(-k) or 1/(1+k) with k = (tmin - toi) / (1 - toi)
+					// oneMinusToi = oneMinusToi * recip(gSimd4fOne - sqrtD * recip(minusA * oneMinusToi));
+					T4f minusK = sqrtD * recip(minusA * oneMinusToi) & (oneMinusToi > gSimd4fEpsilon);
+					oneMinusToi = oneMinusToi * recip(gSimd4fOne - minusK);
+
+					//curX = cur + (prev - cur - (prevAxis - curScaledAxis)*scale)*(1-toi)
+					//curX = cur + (prev - cur)*(1-toi) - ((prevAxis - curScaledAxis)*scale)*(1-toi)
+					curX = curX + deltaX * oneMinusToi; 
+					curY = curY + deltaY * oneMinusToi;
+					curZ = curZ + deltaZ * oneMinusToi;
+
+					//save adjusted values for discrete collision detection below
+					curDot = curX * curAxisX + curY * curAxisY + curZ * curAxisZ;
+					curRadius = curDot * curSlope + splat<3>(curCenter);
+					curRadius = max(curRadius, gSimd4fZero) & ~culled;
+					curSqrDistance = curX * curX + curY * curY + curZ * curZ - curDot * curDot;
+
+					//take offset from toi and add it to the cone center at the end
+					curPos[0] = splat<0>(curCenter) + curX;
+					curPos[1] = splat<1>(curCenter) + curY;
+					curPos[2] = splat<2>(curCenter) + curZ;
+				}
 			}
-		}
 
-		// curPos inside cone (discrete collision)
-		T4f contactMask;
-		int anyContact = anyGreater(curRadius * curRadius, curSqrDistance, contactMask);
+			// curPos inside cone (discrete collision)
+			T4f contactMask;
+			int anyContact = anyGreater(curRadius * curRadius, curSqrDistance, contactMask);
 
-		T4i bothMask = splat<3>(curAuxiliary);
+			T4i firstMask = splat<2>(curAuxiliary);
+			T4i secondMask = splat<3>(curAuxiliary);
 
-		// instead of culling continuous collision for ~collisionMask, and discrete
-		// collision for ~contactMask, disable both if ~collisionMask & ~contactMask
-		T4i cullMask = bothMask & ~simd4i(collisionMask | contactMask);
-		shapeMask.mSpheres = shapeMask.mSpheres & ~cullMask;
+			// sphere masks of the capsule ends, may be the same word
+			T4i& firstSpheres = shapeMask.mSpheres[mCurData.mCones[coneIndex].firstWord];
+			T4i& secondSpheres = shapeMask.mSpheres[mCurData.mCones[coneIndex].secondWord];
 
-		if (!anyContact)
-			continue;
+			// instead of culling continuous collision for ~collisionMask, and discrete
+			// collision for ~contactMask, disable both if ~collisionMask & ~contactMask
+			T4i noContact = ~simd4i(collisionMask | contactMask);
+			firstSpheres = firstSpheres & ~(firstMask & noContact);
+			secondSpheres = secondSpheres & ~(secondMask & noContact);
 
-		T4f invDistance = rsqrt(curSqrDistance) & (curSqrDistance > gSimd4fZero);
-		T4f base = curDot + curSlope * curSqrDistance * invDistance;
+			if (!anyContact)
+				continue;
 
-		T4f halfLength = splat<1>(simd4f(curAuxiliary));
-		T4i leftMask = simd4i(base < -halfLength);
-		T4i rightMask = simd4i(base > halfLength);
+			T4f invDistance = rsqrt(curSqrDistance) & (curSqrDistance > gSimd4fZero);
+			T4f base = curDot + curSlope * curSqrDistance * invDistance;
 
-		// can only skip continuous sphere collision if post-ccd position
-		// is on code side *and* particle had cone-ccd collision.
-		T4i firstMask = splat<2>(curAuxiliary);
-		T4i secondMask = firstMask ^ bothMask;
-		cullMask = (firstMask & ~leftMask) | (secondMask & ~rightMask);
-		shapeMask.mSpheres = shapeMask.mSpheres & ~(cullMask & simd4i(collisionMask));
+			T4f halfLength = splat<1>(simd4f(curAuxiliary));
+			T4i leftMask = simd4i(base < -halfLength);
+			T4i rightMask = simd4i(base > halfLength);
 
-		T4f deltaX = curX - base * curAxisX;
-		T4f deltaY = curY - base * curAxisY;
-		T4f deltaZ = curZ - base * curAxisZ;
+			// can only skip continuous sphere collision if post-ccd position
+			// is on code side *and* particle had cone-ccd collision.
+			firstSpheres = firstSpheres & ~(firstMask & ~leftMask & simd4i(collisionMask));
+			secondSpheres = secondSpheres & ~(secondMask & ~rightMask & simd4i(collisionMask));
 
-		T4f sqrCosine = splat<0>(simd4f(curAuxiliary));
-		T4f scale = curRadius * invDistance * sqrCosine - sqrCosine;
+			T4f deltaX = curX - base * curAxisX;
+			T4f deltaY = curY - base * curAxisY;
+			T4f deltaZ = curZ - base * curAxisZ;
 
-		contactMask = contactMask & ~simd4f(leftMask | rightMask);
+			T4f sqrCosine = splat<0>(simd4f(curAuxiliary));
+			T4f scale = curRadius * invDistance * sqrCosine - sqrCosine;
 
-		if (!anyTrue(contactMask))
-			continue;
+			contactMask = contactMask & ~simd4f(leftMask | rightMask);
 
-		accum.add(deltaX, deltaY, deltaZ, scale, contactMask);
+			if (!anyTrue(contactMask))
+				continue;
 
-		if (frictionEnabled)
-		{
-			uint32_t s0 = mClothData.mCapsuleIndices[coneIndex].first;
-			uint32_t s1 = mClothData.mCapsuleIndices[coneIndex].second;
+			accum.add(deltaX, deltaY, deltaZ, scale, contactMask);
 
-			float* prevSpheres = reinterpret_cast<float*>(mPrevData.mSpheres);
-			float* curSpheres = reinterpret_cast<float*>(mCurData.mSpheres);
+			if (frictionEnabled)
+			{
+				uint32_t s0 = mClothData.mCapsuleIndices[coneIndex].first;
+				uint32_t s1 = mClothData.mCapsuleIndices[coneIndex].second;
+
+				float* prevSpheres = reinterpret_cast<float*>(mPrevData.mSpheres);
+				float* curSpheres = reinterpret_cast<float*>(mCurData.mSpheres);
 
-			// todo: could pre-compute sphere velocities or it might be
-			// faster to compute cur/prev sphere positions directly
-			T4f s0p0 = loadAligned(prevSpheres, s0 * sizeof(SphereData));
-			T4f s0p1 = loadAligned(curSpheres, s0 * sizeof(SphereData));
+				// todo: could pre-compute sphere velocities or it might be
+				// faster to compute cur/prev sphere positions directly
+				T4f s0p0 = loadAligned(prevSpheres, s0 * sizeof(SphereData));
+				T4f s0p1 = loadAligned(curSpheres, s0 * sizeof(SphereData));
 
-			T4f s1p0 = loadAligned(prevSpheres, s1 * sizeof(SphereData));
-			T4f s1p1 = loadAligned(curSpheres, s1 * sizeof(SphereData));
+				T4f s1p0 = loadAligned(prevSpheres, s1 * sizeof(SphereData));
+				T4f s1p1 = loadAligned(curSpheres, s1 * sizeof(SphereData));
 
-			T4f v0 = s0p1 - s0p0;
-			T4f v1 = s1p1 - s1p0;
-			T4f vd = v1 - v0;
+				T4f v0 = s0p1 - s0p0;
+				T4f v1 = s1p1 - s1p0;
+				T4f vd = v1 - v0;
 
-			// dot is in the range -1 to 1, scale and bias to 0 to 1
-			curDot = curDot * gSimd4fHalf + gSimd4fHalf;
+				// dot is in the range -1 to 1, scale and bias to 0 to 1
+				curDot = curDot * gSimd4fHalf + gSimd4fHalf;
 
-			// interpolate velocity at contact points
-			T4f vx = splat<0>(v0) + curDot * splat<0>(vd);
-			T4f vy = splat<1>(v0) + curDot * splat<1>(vd);
-			T4f vz = splat<2>(v0) + curDot * splat<2>(vd);
+				// interpolate velocity at contact points
+				T4f vx = splat<0>(v0) + curDot * splat<0>(vd);
+				T4f vy = splat<1>(v0) + curDot * splat<1>(vd);
+				T4f vz = splat<2>(v0) + curDot * splat<2>(vd);
 
-			accum.addVelocity(vx, vy, vz, contactMask);
+				accum.addVelocity(vx, vy, vz, contactMask);
+			}
 		}
 	}
 
-	return shapeMask.mSpheres;
 }
 
 namespace
@@ -1268,7 +1583,7 @@ PX_INLINE void calculateFrictionImpulse(const T4f& deltaX, const T4f& deltaY, co
 } // anonymous namespace
 
 template <typename T4f>
-void cloth::SwCollision<T4f>::collideParticles()
+void cloth::SwCollision<T4f>::collideParticles(uint32_t first, uint32_t last)
 {
 	const bool massScalingEnabled = mClothData.mCollisionMassScale > 0.0f;
 	const T4f massScale = simd4f(mClothData.mCollisionMassScale);
@@ -1279,28 +1594,48 @@ void cloth::SwCollision<T4f>::collideParticles()
 	T4f curPos[4];
 	T4f prevPos[4];
 
-	float* __restrict prevIt = mClothData.mPrevParticles;
-	float* __restrict pIt = mClothData.mCurParticles;
-	float* __restrict pEnd = pIt + mClothData.mNumParticles * 4;
+#if PX_PROFILE || PX_DEBUG
+	uint32_t numCollisions = 0;
+#endif
+
+	// the particle blocks are written back whether they collide or not
+	const T4f* __restrict bIt = mParticleBlocks ? mParticleBlocks + first : 0;
+
+	float* __restrict prevIt = mClothData.mPrevParticles + first * 4;
+	float* __restrict pIt = mClothData.mCurParticles + first * 4;
+	float* __restrict pEnd = mClothData.mCurParticles + last * 4;
 	//loop over particles 4 at a time
 	for (; pIt < pEnd; pIt += 16, prevIt += 16)
 	{
-		curPos[0] = loadAligned(pIt, 0);
-		curPos[1] = loadAligned(pIt, 16);
-		curPos[2] = loadAligned(pIt, 32);
-		curPos[3] = loadAligned(pIt, 48);
-		transpose(curPos[0], curPos[1], curPos[2], curPos[3]); //group values by axis in simd structure
+		if (bIt)
+		{
+			loadBlock(bIt, curPos);
+			bIt += 4;
+		}
+		else
+		{
+			curPos[0] = loadAligned(pIt, 0);
+			curPos[1] = loadAligned(pIt, 16);
+			curPos[2] = loadAligned(pIt, 32);
+			curPos[3] = loadAligned(pIt, 48);
+			transpose(curPos[0], curPos[1], curPos[2], curPos[3]); //group values by axis in simd structure
+		}
 
 		ImpulseAccumulator accum;
 
 		//first collide cones
-		T4i sphereMask = collideCones(curPos, accum);
+		ShapeMask shapeMask;
+		collideCones(curPos, shapeMask, accum);
 		//pass on hit mask to ignore sphere parts that are inside the cones
-		collideSpheres(sphereMask, curPos, accum);
+		collideSpheres(shapeMask.mSpheres, curPos, accum);
 
 		T4f mask;
 		if (!anyGreater(accum.mNumCollisions, gSimd4fEpsilon, mask))
+		{
+			if (bIt)
+				storeTransposed(pIt, curPos);
 			continue;
+		}
 
 		T4f invNumCollisions = recip(accum.mNumCollisions);
 
@@ -1344,20 +1679,60 @@ void cloth::SwCollision<T4f>::collideParticles()
 		curPos[1] = curPos[1] + accum.mDeltaY * invNumCollisions;
 		curPos[2] = curPos[2] + accum.mDeltaZ * invNumCollisions;
 
-		transpose(curPos[0], curPos[1], curPos[2], curPos[3]);
-		storeAligned(pIt, 0, curPos[0]);
-		storeAligned(pIt, 16, curPos[1]);
-		storeAligned(pIt, 32, curPos[2]);
-		storeAligned(pIt, 48, curPos[3]);
+		storeTransposed(pIt, curPos);
 
 #if PX_PROFILE || PX_DEBUG
-		mNumCollisions += horizontalSum(accum.mNumCollisions);
+		numCollisions += uint32_t(horizontalSum(accum.mNumCollisions));
 #endif
 	}
+
+#if PX_PROFILE || PX_DEBUG
+	// ranges may be processed concurrently
+	ps::atomicAdd(reinterpret_cast<volatile int32_t*>(&mNumCollisions), int32_t(numCollisions));
+#endif
 }
 
+template <typename T4f>
+void cloth::SwCollision<T4f>::collideParticlesAvx(uint32_t first, uint32_t last)
+{
+	collideParticles(first, last);
+}
+
+#if NV_AVX
+template <>
+void cloth::SwCollision<Simd4f>::collideParticlesAvx(uint32_t first, uint32_t last)
+{
+	const float* blocks = mParticleBlocks ? array(mParticleBlocks[first]) : 0;
+
+	uint32_t numCollisions = avx::collideParticles(
+	    mClothData.mCurParticles + first * 4, mClothData.mPrevParticles + first * 4, blocks, last - first,
+	    array(mCurData.mSpheres->center), array(mPrevData.mSpheres->center), array(mCurData.mCones->center),
+	    reinterpret_cast<const uint32_t*>(mClothData.mCapsuleIndices), reinterpret_cast<const uint32_t*>(mSphereGrid),
+	    reinterpret_cast<const uint32_t*>(mConeGrid), mNumSphereWords, mNumConeWords, mNumCells, mGridScale, mGridBias,
+	    mClothData.mFrictionScale, mClothData.mCollisionMassScale);
+
+#if PX_PROFILE || PX_DEBUG
+	// ranges may be processed concurrently
+	ps::atomicAdd(reinterpret_cast<volatile int32_t*>(&mNumCollisions), int32_t(numCollisions));
+#else
+	PX_UNUSED(numCollisions);
+#endif
+}
+#endif
+
 template <typename T4f>
 void cloth::SwCollision<T4f>::collideVirtualParticles()
+{
+	// virtual particle indices, 16 bit unless the cloth has too many particles
+	if (mClothData.mVirtualParticles32Begin)
+		collideVirtualParticles(mClothData.mVirtualParticles32Begin, mClothData.mVirtualParticles32End);
+	else
+		collideVirtualParticles(mClothData.mVirtualParticlesBegin, mClothData.mVirtualParticlesEnd);
+}
+
+template <typename T4f>
+template <typename IndexT>
+void cloth::SwCollision<T4f>::collideVirtualParticles(const IndexT* __restrict vpIt, const IndexT* __restrict vpEnd)
 {
 	const bool massScalingEnabled = mClothData.mCollisionMassScale > 0.0f;
 	const T4f massScale = simd4f(mClothData.mCollisionMassScale);
@@ -1376,8 +1751,6 @@ void cloth::SwCollision<T4f>::collideVirtualParticles()
 	T4f invGridScale = recip(mGridScale) & (mGridScale > gSimd4fEpsilon);
 	dummy[0] = dummy[1] = dummy[2] = invGridScale * mGridBias - invGridScale;
 
-	const uint16_t* __restrict vpIt = mClothData.mVirtualParticlesBegin;
-	const uint16_t* __restrict vpEnd = mClothData.mVirtualParticlesEnd;
 	for (; vpIt != vpEnd; vpIt += 16)
 	{
 		// load 12 particles and 4 weights
@@ -1413,8 +1786,9 @@ void cloth::SwCollision<T4f>::collideVirtualParticles()
 		curPos[2] = pz;
 
 		ImpulseAccumulator accum;
-		T4i sphereMask = collideCones(curPos, accum);
-		collideSpheres(sphereMask, curPos, accum);
+		ShapeMask shapeMask;
+		collideCones(curPos, shapeMask, accum);
+		collideSpheres(shapeMask.mSpheres, curPos, accum);
 
 		T4f mask;
 		if (!anyGreater(accum.mNumCollisions, gSimd4fEpsilon, mask))
@@ -1577,7 +1951,7 @@ void cloth::SwCollision<T4f>::collideVirtualParticles()
 }
 
 template <typename T4f>
-void cloth::SwCollision<T4f>::collideContinuousParticles()
+void cloth::SwCollision<T4f>::collideContinuousParticles(uint32_t first, uint32_t last)
 {
 	T4f curPos[4];
 	T4f prevPos[4];
@@ -1588,9 +1962,16 @@ void cloth::SwCollision<T4f>::collideContinuousParticles()
 	const bool frictionEnabled = mClothData.mFrictionScale > 0.0f;
 	const T4f frictionScale = simd4f(mClothData.mFrictionScale);
 
-	float* __restrict prevIt = mClothData.mPrevParticles;
-	float* __restrict curIt = mClothData.mCurParticles;
-	float* __restrict curEnd = curIt + mClothData.mNumParticles * 4;
+#if PX_PROFILE || PX_DEBUG
+	uint32_t numCollisions = 0;
+#endif
+
+	// the particle blocks are written back whether they collide or not
+	const T4f* __restrict bIt = mParticleBlocks ? mParticleBlocks + first : 0;
+
+	float* __restrict prevIt = mClothData.mPrevParticles + first * 4;
+	float* __restrict curIt = mClothData.mCurParticles + first * 4;
+	float* __restrict curEnd = mClothData.mCurParticles + last * 4;
 
 	for (; curIt < curEnd; curIt += 16, prevIt += 16)
 	{
@@ -1600,19 +1981,36 @@ void cloth::SwCollision<T4f>::collideContinuousParticles()
 		prevPos[3] = loadAligned(prevIt, 48);
 		transpose(prevPos[0], prevPos[1], prevPos[2], prevPos[3]);
 
-		curPos[0] = loadAligned(curIt, 0);
-		curPos[1] = loadAligned(curIt, 16);
-		curPos[2] = loadAligned(curIt, 32);
-		curPos[3] = loadAligned(curIt, 48);
-		transpose(curPos[0], curPos[1], curPos[2], curPos[3]);
+		if (bIt)
+		{
+			loadBlock(bIt, curPos);
+			bIt += 4;
+		}
+		else
+		{
+			curPos[0] = loadAligned(curIt, 0);
+			curPos[1] = loadAligned(curIt, 16);
+			curPos[2] = loadAligned(curIt, 32);
+			curPos[3] = loadAligned(curIt, 48);
+			transpose(curPos[0], curPos[1], curPos[2], curPos[3]);
+		}
 
 		ImpulseAccumulator accum;
-		T4i sphereMask = collideCones(prevPos, curPos, accum);
-		collideSpheres(sphereMask, prevPos, curPos, accum);
+		ShapeMask shapeMask;
+		collideCones(prevPos, curPos, shapeMask, accum);
+		collideSpheres(shapeMask.mSpheres, prevPos, curPos, accum);
 
 		T4f mask;
 		if (!anyGreater(accum.mNumCollisions, gSimd4fEpsilon, mask))
+		{
+			// curPos has been moved by the continuous collision, store the staged positions instead
+			if (bIt)
+			{
+				loadBlock(bIt - 4, curPos);
+				storeTransposed(curIt, curPos);
+			}
 			continue;
+		}
 
 		T4f invNumCollisions = recip(accum.mNumCollisions);
 
@@ -1649,16 +2047,17 @@ void cloth::SwCollision<T4f>::collideContinuousParticles()
 		curPos[1] = curPos[1] + accum.mDeltaY * invNumCollisions;
 		curPos[2] = curPos[2] + accum.mDeltaZ * invNumCollisions;
 
-		transpose(curPos[0], curPos[1], curPos[2], curPos[3]);
-		storeAligned(curIt, 0, curPos[0]);
-		storeAligned(curIt, 16, curPos[1]);
-		storeAligned(curIt, 32, curPos[2]);
-		storeAligned(curIt, 48, curPos[3]);
+		storeTransposed(curIt, curPos);
 
 #if PX_PROFILE || PX_DEBUG
-		mNumCollisions += horizontalSum(accum.mNumCollisions);
+		numCollisions += uint32_t(horizontalSum(accum.mNumCollisions));
 #endif
 	}
+
+#if PX_PROFILE || PX_DEBUG
+	// ranges may be processed concurrently
+	ps::atomicAdd(reinterpret_cast<volatile int32_t*>(&mNumCollisions), int32_t(numCollisions));
+#endif
 }
 
 template <typename T4f>
@@ -1688,22 +2087,16 @@ void cloth::SwCollision<T4f>::collideConvexes(const IterationState<T4f>& state)
 		generatePlanes(planes, targetPlanes, mClothData.mNumPlanes);
 	}
 
-	T4f curPos[4], prevPos[4];
+	T4f prevPos[4];
 
 	const bool frictionEnabled = mClothData.mFrictionScale > 0.0f;
 	const T4f frictionScale = simd4f(mClothData.mFrictionScale);
 
-	float* __restrict curIt = mClothData.mCurParticles;
-	float* __restrict curEnd = curIt + mClothData.mNumParticles * 4;
+	T4f* __restrict curPos = mParticleBlocks;
+	T4f* __restrict curEnd = curPos + ((mClothData.mNumParticles + 3) & ~3);
 	float* __restrict prevIt = mClothData.mPrevParticles;
-	for (; curIt < curEnd; curIt += 16, prevIt += 16)
+	for (; curPos < curEnd; curPos += 4, prevIt += 16)
 	{
-		curPos[0] = loadAligned(curIt, 0);
-		curPos[1] = loadAligned(curIt, 16);
-		curPos[2] = loadAligned(curIt, 32);
-		curPos[3] = loadAligned(curIt, 48);
-		transpose(curPos[0], curPos[1], curPos[2], curPos[3]);
-
 		ImpulseAccumulator accum;
 		collideConvexes(planes, curPos, accum);
 
@@ -1740,12 +2133,6 @@ void cloth::SwCollision<T4f>::collideConvexes(const IterationState<T4f>& state)
 		curPos[1] = curPos[1] + accum.mDeltaY * invNumCollisions;
 		curPos[2] = curPos[2] + accum.mDeltaZ * invNumCollisions;
 
-		transpose(curPos[0], curPos[1], curPos[2], curPos[3]);
-		storeAligned(curIt, 0, curPos[0]);
-		storeAligned(curIt, 16, curPos[1]);
-		storeAligned(curIt, 32, curPos[2]);
-		storeAligned(curIt, 48, curPos[3]);
-
 #if PX_PROFILE || PX_DEBUG
 		mNumCollisions += horizontalSum(accum.mNumCollisions);
 #endif
@@ -1832,20 +2219,42 @@ void cloth::SwCollision<T4f>::collideTriangles(const IterationState<T4f>& state)
 		generateTriangles<T4f>(triangles, targetTriangles, mClothData.mNumCollisionTriangles);
 	}
 
-	T4f positions[4];
+	// rebuilt every iteration, the triangles may move arbitrarily between frames
+	TriangleNode* nodes =
+	    static_cast<TriangleNode*>(mAllocator.allocate(sizeof(TriangleNode) * mClothData.mNumCollisionTriangles));
+	uint32_t* indices =
+	    static_cast<uint32_t*>(mAllocator.allocate(sizeof(uint32_t) * mClothData.mNumCollisionTriangles));
+	buildTriangleTree(triangles, nodes, indices);
+
+#if NV_CLOTH_CHECK_TRIANGLE_TREE
+	// single leaf over all triangles in their original order, i.e. a linear search
+	TriangleNode linearNode;
+	linearNode.lower = PxVec3(-FLT_MAX);
+	linearNode.upper = PxVec3(FLT_MAX);
+	linearNode.first = 0;
+	linearNode.count = mClothData.mNumCollisionTriangles;
+	uint32_t* linearIndices =
+	    static_cast<uint32_t*>(mAllocator.allocate(sizeof(uint32_t) * mClothData.mNumCollisionTriangles));
+	for (uint32_t i = 0; i < mClothData.mNumCollisionTriangles; ++i)
+		linearIndices[i] = i;
+#endif
 
-	float* __restrict pIt = mClothData.mCurParticles;
-	float* __restrict pEnd = pIt + mClothData.mNumParticles * 4;
-	for (; pIt < pEnd; pIt += 16)
+	T4f* __restrict positions = mParticleBlocks;
+	T4f* __restrict pEnd = positions + ((mClothData.mNumParticles + 3) & ~3);
+	for (; positions < pEnd; positions += 4)
 	{
-		positions[0] = loadAligned(pIt, 0);
-		positions[1] = loadAligned(pIt, 16);
-		positions[2] = loadAligned(pIt, 32);
-		positions[3] = loadAligned(pIt, 48);
-		transpose(positions[0], positions[1], positions[2], positions[3]);
-
 		ImpulseAccumulator accum;
-		collideTriangles(triangles, positions, accum);
+		collideTriangles(triangles, nodes, indices, positions, accum);
+
+#if NV_CLOTH_CHECK_TRIANGLE_TREE
+		// the tree search has to find the same triangles as the linear search
+		ImpulseAccumulator linearAccum;
+		collideTriangles(triangles, &linearNode, linearIndices, positions, linearAccum);
+		NV_CLOTH_ASSERT(allTrue(accum.mDeltaX == linearAccum.mDeltaX));
+		NV_CLOTH_ASSERT(allTrue(accum.mDeltaY == linearAccum.mDeltaY));
+		NV_CLOTH_ASSERT(allTrue(accum.mDeltaZ == linearAccum.mDeltaZ));
+		NV_CLOTH_ASSERT(allTrue(accum.mNumCollisions == linearAccum.mNumCollisions));
+#endif
 
 		T4f mask;
 		if (!anyGreater(accum.mNumCollisions, gSimd4fEpsilon, mask))
@@ -1857,98 +2266,211 @@ void cloth::SwCollision<T4f>::collideTriangles(const IterationState<T4f>& state)
 		positions[1] = positions[1] + accum.mDeltaY * invNumCollisions;
 		positions[2] = positions[2] + accum.mDeltaZ * invNumCollisions;
 
-		transpose(positions[0], positions[1], positions[2], positions[3]);
-		storeAligned(pIt, 0, positions[0]);
-		storeAligned(pIt, 16, positions[1]);
-		storeAligned(pIt, 32, positions[2]);
-		storeAligned(pIt, 48, positions[3]);
-
 #if PX_PROFILE || PX_DEBUG
 		mNumCollisions += horizontalSum(accum.mNumCollisions);
 #endif
 	}
 
+#if NV_CLOTH_CHECK_TRIANGLE_TREE
+	mAllocator.deallocate(linearIndices);
+#endif
+
+	mAllocator.deallocate(indices);
+	mAllocator.deallocate(nodes);
 	mAllocator.deallocate(triangles);
 }
 
+// splits the triangles at the median center along the longest axis until the leaves are small enough.
+// nodes are stored breadth first with siblings next to each other, a tree of n triangles has at most n nodes.
 template <typename T4f>
-void cloth::SwCollision<T4f>::collideTriangles(const TriangleData* __restrict triangles, T4f* __restrict curPos,
+void cloth::SwCollision<T4f>::buildTriangleTree(const TriangleData* triangles, TriangleNode* nodes,
+                                                   uint32_t* indices)
+{
+	const uint32_t numTriangles = mClothData.mNumCollisionTriangles;
+
+	// lower, upper and center of each triangle
+	T4f* bounds = static_cast<T4f*>(mAllocator.allocate(sizeof(T4f) * 3 * numTriangles));
+	float* centers = reinterpret_cast<float*>(bounds + 2 * numTriangles);
+
+	for (uint32_t i = 0; i < numTriangles; ++i)
+	{
+		T4f p0 = loadAligned(&triangles[i].base.x);
+		T4f p1 = p0 + loadAligned(&triangles[i].edge0.x);
+		T4f p2 = p0 + loadAligned(&triangles[i].edge1.x);
+
+		T4f lower = min(p0, min(p1, p2));
+		T4f upper = max(p0, max(p1, p2));
+
+		bounds[i * 2] = lower;
+		bounds[i * 2 + 1] = upper;
+		storeAligned(centers + i * 4, (lower + upper) * gSimd4fHalf);
+		indices[i] = i;
+	}
+
+	nodes[0].first = 0;
+	nodes[0].count = numTriangles;
+
+	uint32_t numNodes = 1;
+	for (uint32_t n = 0; n < numNodes; ++n)
+	{
+		const uint32_t first = nodes[n].first;
+		const uint32_t count = nodes[n].count;
+		uint32_t* iBegin = indices + first;
+		uint32_t* iEnd = iBegin + count;
+
+		T4f lower = gSimd4fFloatMax, upper = -lower;
+		T4f centerLower = lower, centerUpper = upper;
+		for (const uint32_t* iIt = iBegin; iIt != iEnd; ++iIt)
+		{
+			lower = min(lower, bounds[*iIt * 2]);
+			upper = max(upper, bounds[*iIt * 2 + 1]);
+			T4f center = loadAligned(centers + *iIt * 4);
+			centerLower = min(centerLower, center);
+			centerUpper = max(centerUpper, center);
+		}
+
+		// overwrites first and count
+		storeAligned(&nodes[n].lower.x, lower);
+		storeAligned(&nodes[n].upper.x, upper);
+
+		nodes[n].first = first;
+		nodes[n].count = count;
+
+		if (count <= sTrianglesPerLeaf)
+			continue;
+
+		T4f extent4 = centerUpper - centerLower;
+		const float* extent = array(extent4);
+		uint32_t axis = extent[0] < extent[1] ? 1u : 0u;
+		axis = extent[axis] < extent[2] ? 2u : axis;
+
+		uint32_t* iMid = iBegin + count / 2;
+		std::nth_element(iBegin, iMid, iEnd, TriangleCenterLess(centers, axis));
+
+		nodes[numNodes].first = first;
+		nodes[numNodes].count = count / 2;
+		nodes[numNodes + 1].first = first + count / 2;
+		nodes[numNodes + 1].count = count - count / 2;
+
+		nodes[n].first = numNodes;
+		nodes[n].count = 0;
+		numNodes += 2;
+	}
+
+	NV_CLOTH_ASSERT(numNodes <= PxMax(numTriangles, 1u));
+
+	mAllocator.deallocate(bounds);
+}
+
+template <typename T4f>
+void cloth::SwCollision<T4f>::collideTriangles(const TriangleData* __restrict triangles,
+                                                  const TriangleNode* __restrict nodes,
+                                                  const uint32_t* __restrict indices, T4f* __restrict curPos,
                                                   ImpulseAccumulator& accum)
 {
 	T4f normalX, normalY, normalZ, normalD;
 	normalX = normalY = normalZ = normalD = gSimd4fZero;
 	T4f minSqrLength = gSimd4fFloatMax;
-
-	const TriangleData* __restrict tIt, *tEnd = triangles + mClothData.mNumCollisionTriangles;
-	for (tIt = triangles; tIt != tEnd; ++tIt)
+	T4f minIndex = gSimd4fFloatMax;
+
+	// closest triangle search, skips nodes that are further away than the closest triangle found so far.
+	// ties go to the lower triangle index, which is the triangle a linear search would have picked.
+	uint32_t stack[sMaxTriangleTreeDepth + 1];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize)
 	{
-		T4f base = loadAligned(&tIt->base.x);
-		T4f edge0 = loadAligned(&tIt->edge0.x);
-		T4f edge1 = loadAligned(&tIt->edge1.x);
-		T4f normal = loadAligned(&tIt->normal.x);
-		T4f aux = loadAligned(&tIt->det);
+		const TriangleNode* node = nodes + stack[--stackSize];
 
-		T4f dx = curPos[0] - splat<0>(base);
-		T4f dy = curPos[1] - splat<1>(base);
-		T4f dz = curPos[2] - splat<2>(base);
+		if (allGreater(sqrDistance(*node, curPos), minSqrLength))
+			continue;
 
-		T4f e0x = splat<0>(edge0);
-		T4f e0y = splat<1>(edge0);
-		T4f e0z = splat<2>(edge0);
+		if (!node->count)
+		{
+			// visit the closer child first
+			const TriangleNode* children = nodes + node->first;
+			uint32_t leftFirst = anyGreater(sqrDistance(children[1], curPos), sqrDistance(children[0], curPos)) ? 1u : 0u;
+			NV_CLOTH_ASSERT(stackSize < sMaxTriangleTreeDepth);
+			stack[stackSize++] = node->first + leftFirst;
+			stack[stackSize++] = node->first + 1 - leftFirst;
+			continue;
+		}
+
+		const uint32_t* __restrict iIt = indices + node->first;
+		const uint32_t* __restrict iEnd = iIt + node->count;
+		for (; iIt != iEnd; ++iIt)
+		{
+			const TriangleData* __restrict tIt = triangles + *iIt;
+			T4f base = loadAligned(&tIt->base.x);
+			T4f edge0 = loadAligned(&tIt->edge0.x);
+			T4f edge1 = loadAligned(&tIt->edge1.x);
+			T4f normal = loadAligned(&tIt->normal.x);
+			T4f aux = loadAligned(&tIt->det);
 
-		T4f e1x = splat<0>(edge1);
-		T4f e1y = splat<1>(edge1);
-		T4f e1z = splat<2>(edge1);
+			T4f dx = curPos[0] - splat<0>(base);
+			T4f dy = curPos[1] - splat<1>(base);
+			T4f dz = curPos[2] - splat<2>(base);
 
-		T4f nx = splat<0>(normal);
-		T4f ny = splat<1>(normal);
-		T4f nz = splat<2>(normal);
+			T4f e0x = splat<0>(edge0);
+			T4f e0y = splat<1>(edge0);
+			T4f e0z = splat<2>(edge0);
 
-		T4f deltaDotEdge0 = dx * e0x + dy * e0y + dz * e0z;
-		T4f deltaDotEdge1 = dx * e1x + dy * e1y + dz * e1z;
-		T4f deltaDotNormal = dx * nx + dy * ny + dz * nz;
+			T4f e1x = splat<0>(edge1);
+			T4f e1y = splat<1>(edge1);
+			T4f e1z = splat<2>(edge1);
 
-		T4f edge0DotEdge1 = splat<3>(base);
-		T4f edge0SqrLength = splat<3>(edge0);
-		T4f edge1SqrLength = splat<3>(edge1);
+			T4f nx = splat<0>(normal);
+			T4f ny = splat<1>(normal);
+			T4f nz = splat<2>(normal);
 
-		T4f s = edge1SqrLength * deltaDotEdge0 - edge0DotEdge1 * deltaDotEdge1;
-		T4f t = edge0SqrLength * deltaDotEdge1 - edge0DotEdge1 * deltaDotEdge0;
+			T4f deltaDotEdge0 = dx * e0x + dy * e0y + dz * e0z;
+			T4f deltaDotEdge1 = dx * e1x + dy * e1y + dz * e1z;
+			T4f deltaDotNormal = dx * nx + dy * ny + dz * nz;
 
-		T4f sPositive = s > gSimd4fZero;
-		T4f tPositive = t > gSimd4fZero;
+			T4f edge0DotEdge1 = splat<3>(base);
+			T4f edge0SqrLength = splat<3>(edge0);
+			T4f edge1SqrLength = splat<3>(edge1);
 
-		T4f det = splat<0>(aux);
+			T4f s = edge1SqrLength * deltaDotEdge0 - edge0DotEdge1 * deltaDotEdge1;
+			T4f t = edge0SqrLength * deltaDotEdge1 - edge0DotEdge1 * deltaDotEdge0;
 
-		s = select(tPositive, s * det, deltaDotEdge0 * splat<2>(aux));
-		t = select(sPositive, t * det, deltaDotEdge1 * splat<3>(aux));
+			T4f sPositive = s > gSimd4fZero;
+			T4f tPositive = t > gSimd4fZero;
 
-		T4f clamp = gSimd4fOne < s + t;
-		T4f numerator = edge1SqrLength - edge0DotEdge1 + deltaDotEdge0 - deltaDotEdge1;
+			T4f det = splat<0>(aux);
 
-		s = select(clamp, numerator * splat<1>(aux), s);
+			s = select(tPositive, s * det, deltaDotEdge0 * splat<2>(aux));
+			t = select(sPositive, t * det, deltaDotEdge1 * splat<3>(aux));
 
-		s = max(gSimd4fZero, min(gSimd4fOne, s));
-		t = max(gSimd4fZero, min(gSimd4fOne - s, t));
+			T4f clamp = gSimd4fOne < s + t;
+			T4f numerator = edge1SqrLength - edge0DotEdge1 + deltaDotEdge0 - deltaDotEdge1;
 
-		dx = dx - e0x * s - e1x * t;
-		dy = dy - e0y * s - e1y * t;
-		dz = dz - e0z * s - e1z * t;
+			s = select(clamp, numerator * splat<1>(aux), s);
 
-		T4f sqrLength = dx * dx + dy * dy + dz * dz;
+			s = max(gSimd4fZero, min(gSimd4fOne, s));
+			t = max(gSimd4fZero, min(gSimd4fOne - s, t));
 
-		// slightly increase distance for colliding triangles
-		T4f slack = (gSimd4fZero > deltaDotNormal) & simd4f(1e-4f);
-		sqrLength = sqrLength + sqrLength * slack;
+			dx = dx - e0x * s - e1x * t;
+			dy = dy - e0y * s - e1y * t;
+			dz = dz - e0z * s - e1z * t;
 
-		T4f mask = sqrLength < minSqrLength;
+			T4f sqrLength = dx * dx + dy * dy + dz * dz;
 
-		normalX = select(mask, nx, normalX);
-		normalY = select(mask, ny, normalY);
-		normalZ = select(mask, nz, normalZ);
-		normalD = select(mask, deltaDotNormal, normalD);
+			// slightly increase distance for colliding triangles
+			T4f slack = (gSimd4fZero > deltaDotNormal) & simd4f(1e-4f);
+			sqrLength = sqrLength + sqrLength * slack;
 
-		minSqrLength = min(sqrLength, minSqrLength);
+			T4f index = simd4f(float(*iIt));
+			T4f mask = (sqrLength < minSqrLength) | ((sqrLength == minSqrLength) & (index < minIndex));
+
+			normalX = select(mask, nx, normalX);
+			normalY = select(mask, ny, normalY);
+			normalZ = select(mask, nz, normalZ);
+			normalD = select(mask, deltaDotNormal, normalD);
+
+			minSqrLength = select(mask, sqrLength, minSqrLength);
+			minIndex = select(mask, index, minIndex);
+		}
 	}
 
 	T4f mask;
@@ -1958,6 +2480,295 @@ void cloth::SwCollision<T4f>::collideTriangles(const TriangleData* __restrict tr
 	accum.subtract(normalX, normalY, normalZ, normalD, mask);
 }
 
+namespace
+{
+// pose at alpha, the rotation is interpolated linearly and normalized
+PxTransform interpolatePose(const PxTransform& start, const PxTransform& target, float alpha)
+{
+	// take the shorter way around
+	PxQuat q = start.q.dot(target.q) < 0.0f ? -target.q : target.q;
+	return PxTransform(start.p + (target.p - start.p) * alpha, (start.q * (1.0f - alpha) + q * alpha).getNormalized());
+}
+
+// pose of a shape at the end of the iteration, and the transform
+// that moves points attached to the shape back to the start of the iteration
+template <typename T4f>
+void getIterationPose(const PxTransform& start, const PxTransform& target, const cloth::IterationState<T4f>& state,
+                      PxTransform& pose, PxTransform& toPrevPose)
+{
+	pose = target;
+	if (state.mRemainingIterations != 1)
+		pose = interpolatePose(start, target, state.getCurrentAlpha());
+	toPrevPose = interpolatePose(start, target, state.getPreviousAlpha()) * pose.getInverse();
+}
+
+// matrix * points + offset for 4 points
+template <typename T4f>
+void transformPoints(const PxMat33& matrix, const PxVec3& offset, const T4f* points, T4f* result)
+{
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		result[i] = simd4f(matrix(i, 0)) * points[0] + simd4f(matrix(i, 1)) * points[1] +
+		            simd4f(matrix(i, 2)) * points[2] + simd4f(offset[i]);
+	}
+}
+
+// sample at index + offset for each of the 4 particles
+template <typename T4f>
+T4f gatherSamples(const float* __restrict samples, const int* index, int offset)
+{
+	return simd4f(samples[index[0] + offset], samples[index[1] + offset], samples[index[2] + offset],
+	              samples[index[3] + offset]);
+}
+}
+
+// moves a block of 4 particles by the accumulated delta. friction acts against the offset of the shape
+// during the iteration, the shape moving rigidly with toPrevPose taking it back to the start of the iteration
+template <typename T4f>
+void cloth::SwCollision<T4f>::applyShapeImpulse(T4f* __restrict curPos, float* __restrict prevIt,
+                                                   ImpulseAccumulator& accum, const T4f& mask,
+                                                   const PxTransform& toPrevPose)
+{
+	T4f invNumCollisions = recip(accum.mNumCollisions);
+
+	if (mClothData.mFrictionScale > 0.0f)
+	{
+		const T4f frictionScale = simd4f(mClothData.mFrictionScale);
+
+		T4f prevShape[3];
+		transformPoints(PxMat33(toPrevPose.q), toPrevPose.p, curPos, prevShape);
+		accum.addVelocity(curPos[0] - prevShape[0], curPos[1] - prevShape[1], curPos[2] - prevShape[2], mask);
+
+		T4f prevPos[4];
+		prevPos[0] = loadAligned(prevIt, 0);
+		prevPos[1] = loadAligned(prevIt, 16);
+		prevPos[2] = loadAligned(prevIt, 32);
+		prevPos[3] = loadAligned(prevIt, 48);
+		transpose(prevPos[0], prevPos[1], prevPos[2], prevPos[3]);
+
+		T4f frictionImpulse[3];
+		calculateFrictionImpulse(accum.mDeltaX, accum.mDeltaY, accum.mDeltaZ, accum.mVelX, accum.mVelY, accum.mVelZ,
+		                         curPos, prevPos, invNumCollisions, frictionScale, mask, frictionImpulse);
+
+		prevPos[0] = prevPos[0] - frictionImpulse[0];
+		prevPos[1] = prevPos[1] - frictionImpulse[1];
+		prevPos[2] = prevPos[2] - frictionImpulse[2];
+
+		transpose(prevPos[0], prevPos[1], prevPos[2], prevPos[3]);
+		storeAligned(prevIt, 0, prevPos[0]);
+		storeAligned(prevIt, 16, prevPos[1]);
+		storeAligned(prevIt, 32, prevPos[2]);
+		storeAligned(prevIt, 48, prevPos[3]);
+	}
+
+	curPos[0] = curPos[0] + accum.mDeltaX * invNumCollisions;
+	curPos[1] = curPos[1] + accum.mDeltaY * invNumCollisions;
+	curPos[2] = curPos[2] + accum.mDeltaZ * invNumCollisions;
+
+#if PX_PROFILE || PX_DEBUG
+	mNumCollisions += horizontalSum(accum.mNumCollisions);
+#endif
+}
+
+template <typename T4f>
+void cloth::SwCollision<T4f>::collideDistanceField(const IterationState<T4f>& state)
+{
+	if (!mClothData.mDistanceField)
+		return;
+
+	PxTransform pose, toPrevPose;
+	getIterationPose(*mClothData.mStartDistanceFieldPose, *mClothData.mTargetDistanceFieldPose, state, pose,
+	                 toPrevPose);
+
+	// cloth space to grid space, in cells from the first sample
+	const float* lower = mClothData.mDistanceFieldLower;
+	const float invCellSize = 1.0f / mClothData.mDistanceFieldCellSize;
+	const PxMat33 rotation(pose.q);
+	const PxMat33 toGrid = rotation.getTranspose() * invCellSize;
+	const PxVec3 gridOffset = -(toGrid * pose.p + PxVec3(lower[0], lower[1], lower[2]) * invCellSize);
+
+	const float* __restrict samples = mClothData.mDistanceField;
+	const uint32_t* dims = mClothData.mDistanceFieldDims;
+	const int strideY = int(dims[0]);
+	const int strideZ = int(dims[0] * dims[1]);
+	const T4f strides = simd4f(0.0f, float(strideY), float(strideZ), 0.0f);
+
+	// coordinates of the last sample
+	const T4f upper = simd4f(float(dims[0] - 1), float(dims[1] - 1), float(dims[2] - 1), 0.0f);
+
+	T4f* __restrict positions = mParticleBlocks;
+	T4f* __restrict pEnd = positions + ((mClothData.mNumParticles + 3) & ~3);
+	float* __restrict prevIt = mClothData.mPrevParticles;
+	for (; positions < pEnd; positions += 4, prevIt += 16)
+	{
+		T4f grid[3];
+		transformPoints(toGrid, gridOffset, positions, grid);
+
+		// clamp to the sample grid, NaN coordinates end up at the upper end
+		T4f clamped[3], cell[3], frac[3];
+		clamped[0] = max(min(grid[0], splat<0>(upper)), gSimd4fZero);
+		clamped[1] = max(min(grid[1], splat<1>(upper)), gSimd4fZero);
+		clamped[2] = max(min(grid[2], splat<2>(upper)), gSimd4fZero);
+
+		T4f inside = (grid[0] == clamped[0]) & (grid[1] == clamped[1]) & (grid[2] == clamped[2]);
+		if (!anyTrue(inside))
+			continue;
+
+		cell[0] = min(floor(clamped[0]), splat<0>(upper) - gSimd4fOne);
+		cell[1] = min(floor(clamped[1]), splat<1>(upper) - gSimd4fOne);
+		cell[2] = min(floor(clamped[2]), splat<2>(upper) - gSimd4fOne);
+
+		frac[0] = clamped[0] - cell[0];
+		frac[1] = clamped[1] - cell[1];
+		frac[2] = clamped[2] - cell[2];
+
+		// index of the lower corner of the cell, exact as long as the field has less than 2^24 samples
+		int indexIt[4];
+		store(indexIt, truncate(cell[0] + cell[1] * splat<1>(strides) + cell[2] * splat<2>(strides)));
+
+		T4f d000 = gatherSamples<T4f>(samples, indexIt, 0);
+		T4f d100 = gatherSamples<T4f>(samples, indexIt, 1);
+		T4f d010 = gatherSamples<T4f>(samples, indexIt, strideY);
+		T4f d110 = gatherSamples<T4f>(samples, indexIt, strideY + 1);
+		T4f d001 = gatherSamples<T4f>(samples, indexIt, strideZ);
+		T4f d101 = gatherSamples<T4f>(samples, indexIt, strideZ + 1);
+		T4f d011 = gatherSamples<T4f>(samples, indexIt, strideZ + strideY);
+		T4f d111 = gatherSamples<T4f>(samples, indexIt, strideZ + strideY + 1);
+
+		// trilinear interpolation, x first
+		T4f dx00 = d100 - d000;
+		T4f dx10 = d110 - d010;
+		T4f dx01 = d101 - d001;
+		T4f dx11 = d111 - d011;
+
+		T4f d00 = d000 + dx00 * frac[0];
+		T4f d10 = d010 + dx10 * frac[0];
+		T4f d01 = d001 + dx01 * frac[0];
+		T4f d11 = d011 + dx11 * frac[0];
+
+		T4f dy0 = d10 - d00;
+		T4f dy1 = d11 - d01;
+
+		T4f d0 = d00 + dy0 * frac[1];
+		T4f d1 = d01 + dy1 * frac[1];
+
+		T4f distance = d0 + (d1 - d0) * frac[2];
+
+		T4f mask = inside & (distance < gSimd4fZero);
+		if (!anyTrue(mask))
+			continue;
+
+		// gradient of the interpolated field, rotated to cloth space
+		T4f gradient[3];
+		T4f dx0 = dx00 + (dx10 - dx00) * frac[1];
+		T4f dx1 = dx01 + (dx11 - dx01) * frac[1];
+		gradient[0] = dx0 + (dx1 - dx0) * frac[2];
+		gradient[1] = dy0 + (dy1 - dy0) * frac[2];
+		gradient[2] = d1 - d0;
+
+		T4f normal[3];
+		transformPoints(rotation, PxVec3(0.0f), gradient, normal);
+
+		T4f invLength = rsqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] + gSimd4fEpsilon);
+
+		ImpulseAccumulator accum;
+		accum.subtract(normal[0] * invLength, normal[1] * invLength, normal[2] * invLength, distance, mask);
+
+		applyShapeImpulse(positions, prevIt, accum, mask, toPrevPose);
+	}
+}
+
+template <typename T4f>
+void cloth::SwCollision<T4f>::collideHeightfield(const IterationState<T4f>& state)
+{
+	if (!mClothData.mHeightfield)
+		return;
+
+	PxTransform pose, toPrevPose;
+	getIterationPose(*mClothData.mStartHeightfieldPose, *mClothData.mTargetHeightfieldPose, state, pose, toPrevPose);
+
+	// cloth space to heightfield space, x and z in cells from the first sample
+	const float* lower = mClothData.mHeightfieldLower;
+	const float cellSize = mClothData.mHeightfieldCellSize;
+	const float invCellSize = 1.0f / cellSize;
+	const PxMat33 rotation(pose.q);
+	const PxMat33 toGrid = PxMat33::createDiagonal(PxVec3(invCellSize, 1.0f, invCellSize)) * rotation.getTranspose();
+	const PxVec3 gridOffset = -(toGrid * pose.p + PxVec3(lower[0] * invCellSize, lower[1], lower[2] * invCellSize));
+
+	const float* __restrict heights = mClothData.mHeightfield;
+	const uint32_t* dims = mClothData.mHeightfieldDims;
+	const int strideZ = int(dims[0]);
+
+	const T4f strides = simd4f(float(strideZ));
+	const T4f cellSizes = simd4f(cellSize);
+
+	// coordinates of the last sample
+	const T4f upper = simd4f(float(dims[0] - 1), 0.0f, float(dims[1] - 1), 0.0f);
+
+	T4f* __restrict positions = mParticleBlocks;
+	T4f* __restrict pEnd = positions + ((mClothData.mNumParticles + 3) & ~3);
+	float* __restrict prevIt = mClothData.mPrevParticles;
+	for (; positions < pEnd; positions += 4, prevIt += 16)
+	{
+		T4f grid[3];
+		transformPoints(toGrid, gridOffset, positions, grid);
+
+		// clamp to the sample grid, NaN coordinates end up at the upper end
+		T4f clampedX = max(min(grid[0], splat<0>(upper)), gSimd4fZero);
+		T4f clampedZ = max(min(grid[2], splat<2>(upper)), gSimd4fZero);
+
+		T4f inside = (grid[0] == clampedX) & (grid[2] == clampedZ);
+		if (!anyTrue(inside))
+			continue;
+
+		T4f cellX = min(floor(clampedX), splat<0>(upper) - gSimd4fOne);
+		T4f cellZ = min(floor(clampedZ), splat<2>(upper) - gSimd4fOne);
+
+		T4f fracX = clampedX - cellX;
+		T4f fracZ = clampedZ - cellZ;
+
+		// index of the lower corner of the cell, exact as long as the heightfield has less than 2^24 samples
+		int indexIt[4];
+		store(indexIt, truncate(cellX + cellZ * strides));
+
+		T4f h00 = gatherSamples<T4f>(heights, indexIt, 0);
+		T4f h10 = gatherSamples<T4f>(heights, indexIt, 1);
+		T4f h01 = gatherSamples<T4f>(heights, indexIt, strideZ);
+		T4f h11 = gatherSamples<T4f>(heights, indexIt, strideZ + 1);
+
+		// bilinear interpolation
+		T4f hx0 = h10 - h00;
+		T4f hx1 = h11 - h01;
+
+		T4f h0 = h00 + hx0 * fracX;
+		T4f h1 = h01 + hx1 * fracX;
+
+		// height above the surface
+		T4f height = grid[1] - h0 - (h1 - h0) * fracZ;
+
+		T4f mask = inside & (height < gSimd4fZero);
+		if (!anyTrue(mask))
+			continue;
+
+		// surface normal (-dh/dx, 1, -dh/dz), rotated to cloth space
+		T4f normal[3], gradient[3];
+		gradient[0] = -(hx0 + (hx1 - hx0) * fracZ);
+		gradient[1] = cellSizes;
+		gradient[2] = h0 - h1;
+		transformPoints(rotation, PxVec3(0.0f), gradient, normal);
+
+		T4f invLength = rsqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+		// distance to the plane tangent to the surface below the particle
+		T4f distance = height * cellSizes * invLength;
+
+		ImpulseAccumulator accum;
+		accum.subtract(normal[0] * invLength, normal[1] * invLength, normal[2] * invLength, distance, mask);
+
+		applyShapeImpulse(positions, prevIt, accum, mask, toPrevPose);
+	}
+}
+
 // explicit template instantiation
 #if NV_SIMD_SIMD
 template class cloth::SwCollision<Simd4f>;
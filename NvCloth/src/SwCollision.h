@@ -46,6 +46,7 @@ struct IndexPair;
 struct SphereData;
 struct ConeData;
 struct TriangleData;
+struct TriangleNode;
 
 typedef StackAllocator<16> SwKernelAllocator;
 
@@ -58,13 +59,14 @@ class SwCollision
 	typedef typename Simd4fToSimd4i<T4f>::Type T4i;
 
   public:
+	// spheres and cones are referenced by bit masks of up to sMaxShapeWords 32 bit words,
+	// shape i is bit (i & 31) of word (i >> 5). Only the words in use are processed.
+	static const uint32_t sMaxShapeWords = 8;
+
 	struct ShapeMask
 	{
-		T4i mCones;
-		T4i mSpheres;
-
-		ShapeMask& operator = (const ShapeMask&);
-		ShapeMask& operator &= (const ShapeMask&);
+		T4i mCones[sMaxShapeWords];
+		T4i mSpheres[sMaxShapeWords];
 	};
 
 	struct CollisionData
@@ -82,6 +84,15 @@ class SwCollision
 
 	void operator()(const IterationState<T4f>& state);
 
+	// operator() split into stages, collideParticleRange() may be
+	// called concurrently for disjoint ranges of 4 particle multiples
+	bool beginCollision(const IterationState<T4f>& state);
+	void collideParticleRange(uint32_t first, uint32_t last);
+	void endCollision();
+
+	// discrete collision of 8 particles at a time, requires avx support
+	void collideParticlesAvx(uint32_t first, uint32_t last);
+
 	static size_t estimateTemporaryMemory(const SwCloth& cloth);
 	static size_t estimatePersistentMemory(const SwCloth& cloth);
 
@@ -92,41 +103,67 @@ class SwCollision
 
 	void computeBounds();
 
+	// transposed copy of the current particles shared by the collision passes
+	void loadParticleBlocks();
+	void storeParticleBlocks(uint32_t first, uint32_t last);
+	void releaseParticleBlocks(bool writeBack);
+
 	void buildSphereAcceleration(const SphereData*);
 	void buildConeAcceleration();
-	static void mergeAcceleration(uint32_t*);
+	static void mergeAcceleration(uint32_t*, uint32_t numWords, uint32_t gridStride);
 	bool buildAcceleration();
 
-	static ShapeMask getShapeMask(const T4f&, const T4i*, const T4i*);
-	ShapeMask getShapeMask(const T4f*) const;
-	ShapeMask getShapeMask(const T4f*, const T4f*) const;
+	void getShapeMask(ShapeMask&, const T4f&, uint32_t axis, bool intersect) const;
+	void getShapeMask(ShapeMask&, const T4f*) const;
+	void getShapeMask(ShapeMask&, const T4f*, const T4f*) const;
 
-	void collideSpheres(const T4i&, const T4f*, ImpulseAccumulator&) const;
-	T4i collideCones(const T4f*, ImpulseAccumulator&) const;
+	void collideSpheres(const T4i*, const T4f*, ImpulseAccumulator&) const;
+	// sets shapeMask to the shapes overlapping the particles, without the spheres covered by cones
+	void collideCones(const T4f*, ShapeMask&, ImpulseAccumulator&) const;
 
-	void collideSpheres(const T4i&, const T4f*, T4f*, ImpulseAccumulator&) const;
-	T4i collideCones(const T4f*, T4f*, ImpulseAccumulator&) const;
+	void collideSpheres(const T4i*, const T4f*, T4f*, ImpulseAccumulator&) const;
+	void collideCones(const T4f*, T4f*, ShapeMask&, ImpulseAccumulator&) const;
 
-	void collideParticles();
+	void collideParticles(uint32_t first, uint32_t last);
 	void collideVirtualParticles();
-	void collideContinuousParticles();
+	template <typename IndexT>
+	void collideVirtualParticles(const IndexT* vpIt, const IndexT* vpEnd);
+	void collideContinuousParticles(uint32_t first, uint32_t last);
 
 	void collideConvexes(const IterationState<T4f>&);
 	void collideConvexes(const T4f*, T4f*, ImpulseAccumulator&);
 
 	void collideTriangles(const IterationState<T4f>&);
-	void collideTriangles(const TriangleData*, T4f*, ImpulseAccumulator&);
+	// bounding volume hierarchy of the triangles, leaves reference ranges of the returned indices
+	void buildTriangleTree(const TriangleData*, TriangleNode*, uint32_t*);
+	void collideTriangles(const TriangleData*, const TriangleNode*, const uint32_t*, T4f*, ImpulseAccumulator&);
+
+	void collideDistanceField(const IterationState<T4f>&);
+	void collideHeightfield(const IterationState<T4f>&);
+	void applyShapeImpulse(T4f*, float*, ImpulseAccumulator&, const T4f&, const physx::PxTransform&);
 
   public:
-	// acceleration structure
+	// acceleration structure, per shape mask word the (first, last) cell masks along each axis.
+	// dense shapes get up to sMaxGridSize cells per axis, in multiples of the sGridSize cells gathered at once
 	static const uint32_t sGridSize = 8;
-	T4i mSphereGrid[6 * sGridSize / 4];
-	T4i mConeGrid[6 * sGridSize / 4];
+	static const uint32_t sMaxGridSize = 32;
+	T4i mSphereGrid[sMaxShapeWords * 6 * sMaxGridSize / 4];
+	T4i mConeGrid[sMaxShapeWords * 6 * sMaxGridSize / 4];
 	T4f mGridScale, mGridBias;
+	T4f mGridLength; // slightly less than the number of cells along each axis
+	uint32_t mNumCells[3];
+	uint32_t mGridStride; // cells per axis in memory, the largest of mNumCells
+	uint32_t mNumSphereWords;
+	uint32_t mNumConeWords;
 
 	CollisionData mPrevData;
 	CollisionData mCurData;
 
+	// current particles as (x, y, z, w) vectors of 4 particles each, if convexes, triangles,
+	// a distance field or a heightfield are collided.
+	// saves transposing the particles in each pass, written back by collideParticleRange()
+	T4f* mParticleBlocks;
+
 	SwClothData& mClothData;
 	SwKernelAllocator& mAllocator;
 
@@ -135,6 +172,11 @@ class SwCollision
 	static const T4f sSkeletonWidth;
 };
 
+#if NV_AVX
+template <>
+void SwCollision<Simd4f>::collideParticlesAvx(uint32_t first, uint32_t last);
+#endif
+
 //explicit template instantiation declaration
 #if NV_SIMD_SIMD
 extern template class SwCollision<Simd4f>;
@@ -29,6 +29,7 @@
 
 #include "SwFabric.h"
 #include "SwFactory.h"
+#include "TripletScheduler.h"
 #include "ps/PsSort.h"
 #include "limits.h" // for USHRT_MAX
 #include <algorithm>
@@ -37,7 +38,7 @@
 using namespace nv;
 using namespace physx;
 
-cloth::SwTether::SwTether(uint16_t anchor, float length) : mAnchor(anchor), mLength(length)
+cloth::SwTether::SwTether(uint32_t anchor, float length) : mAnchor(anchor), mLength(length)
 {
 }
 
@@ -52,8 +53,8 @@ cloth::SwFabric::SwFabric(SwFactory& factory, uint32_t numParticles, Range<const
 	// should no longer be prefixed with 0
 	NV_CLOTH_ASSERT(sets.front() != 0);
 
-#if PX_WINDOWS_FAMILY
-	const uint32_t kSimdWidth = 8; // avx
+#if NV_CLOTH_AVX_LAYOUT
+	const uint32_t kSimdWidth = getAvxConstraintWidth(); // avx or avx-512
 #else
 	const uint32_t kSimdWidth = 4;
 #endif
@@ -63,7 +64,9 @@ cloth::SwFabric::SwFabric(SwFactory& factory, uint32_t numParticles, Range<const
 	NV_CLOTH_ASSERT(restvalues.size() * 2 == indices.size());
 	NV_CLOTH_ASSERT(restvalues.size() == stiffnessValues.size() || stiffnessValues.size() == 0);
 	NV_CLOTH_ASSERT(mNumParticles > *ps::maxElement(indices.begin(), indices.end()));
-	NV_CLOTH_ASSERT(mNumParticles + kSimdWidth - 1 <= USHRT_MAX);
+
+	// 16 bit indices unless the particles (including padding dummies) don't fit
+	bool use32BitIndices = mNumParticles + kSimdWidth - 1 > USHRT_MAX;
 
 	mPhases.assign(phaseIndices.begin(), phaseIndices.end());
 	mSets.reserve(sets.size() + 1);
@@ -95,17 +98,17 @@ cloth::SwFabric::SwFabric(SwFactory& factory, uint32_t numParticles, Range<const
 			}
 		}
 		for (; iIt != iEnd; ++iIt)
-			mIndices.pushBack(uint16_t(*iIt));
+			mIndices32.pushBack(*iIt);
 
-		// add dummy indices to make multiple of 4
+		// add dummy indices to make multiple of kSimdWidth
 		for (; numConstraints &= kSimdWidth - 1; ++numConstraints)
 		{
 			mRestvalues.pushBack(-FLT_MAX);
 			if (!stiffnessValues.empty())
 				mStiffnessValues.pushBack(-FLT_MAX);
 			uint32_t index = mNumParticles + numConstraints - 1;
-			mIndices.pushBack(uint16_t(index));
-			mIndices.pushBack(uint16_t(index));
+			mIndices32.pushBack(index);
+			mIndices32.pushBack(index);
 		}
 
 		mSets.pushBack(uint32_t(mRestvalues.size()));
@@ -114,7 +117,40 @@ cloth::SwFabric::SwFabric(SwFactory& factory, uint32_t numParticles, Range<const
 	// trim overallocations
 	RestvalueContainer(mRestvalues.begin(), mRestvalues.end()).swap(mRestvalues);
 	RestvalueContainer(mStiffnessValues.begin(), mStiffnessValues.end()).swap(mStiffnessValues);
-	Vector<uint16_t>::Type(mIndices.begin(), mIndices.end()).swap(mIndices);
+	// sets from the fabric cooker are graph colored, except for particles that
+	// were attached when cooking. the solver processes a set in parallel as long
+	// as the shared particles are still attached.
+	Vector<uint32_t>::Type setMarks(mNumParticles, uint32_t(-1));
+	Vector<uint32_t>::Type sharedMarks(mNumParticles, 0);
+	for (uint32_t i = 0; i + 1 < mSets.size(); ++i)
+	{
+		for (uint32_t j = mSets[i] * 2, jEnd = mSets[i + 1] * 2; j < jEnd; ++j)
+		{
+			uint32_t index = mIndices32[j];
+			if (index >= mNumParticles)
+				continue; // padding
+
+			if (setMarks[index] == i && !sharedMarks[index])
+			{
+				sharedMarks[index] = 1;
+				mSharedIndices.pushBack(index);
+			}
+			setMarks[index] = i;
+		}
+	}
+
+	// narrow indices to 16 bit when possible
+	if (use32BitIndices)
+	{
+		Vector<uint32_t>::Type(mIndices32.begin(), mIndices32.end()).swap(mIndices32);
+	}
+	else
+	{
+		mIndices.reserve(mIndices32.size());
+		for (iIt = mIndices32.begin(); iIt != mIndices32.end(); ++iIt)
+			mIndices.pushBack(uint16_t(*iIt));
+		Vector<uint32_t>::Type().swap(mIndices32);
+	}
 
 	// tethers
 	NV_CLOTH_ASSERT(anchors.size() == tetherLengths.size());
@@ -122,13 +158,52 @@ cloth::SwFabric::SwFabric(SwFactory& factory, uint32_t numParticles, Range<const
 	// pad to allow for direct 16 byte (unaligned) loads
 	mTethers.reserve(anchors.size() + 2);
 	for (; !anchors.empty(); anchors.popFront(), tetherLengths.popFront())
-		mTethers.pushBack(SwTether(uint16_t(anchors.front()), tetherLengths.front()));
+		mTethers.pushBack(SwTether(anchors.front(), tetherLengths.front()));
+
+	// triangles, reordered so that wind is applied to groups of 4 triangles at a time
+	Vector<Vec4u>::Type triplets;
+	triplets.reserve(triangles.size() / 3);
+	for (iIt = triangles.begin(); iIt != triangles.end(); iIt += 3)
+		triplets.pushBack(Vec4u(iIt[0], iIt[1], iIt[2], uint32_t(iIt - triangles.begin()) / 3));
+
+	TripletScheduler scheduler(Range<const uint32_t[4]>(reinterpret_cast<const uint32_t(*)[4]>(triplets.begin()),
+	                                                    reinterpret_cast<const uint32_t(*)[4]>(triplets.end())));
+	scheduler.simd(mNumParticles, 4);
 
-	// triangles
-	mTriangles.reserve(triangles.size());
-	const uint32_t* iEnd = triangles.end();
-	for (iIt = triangles.begin(); iIt != iEnd; ++iIt)
-		mTriangles.pushBack(uint16_t(*iIt));
+	// the first multiple of 4 triangles of each set don't share particles within a group,
+	// move those to the front and the rest of the set to the back
+	Vector<uint32_t>::Type batched, remainder, remainderOrder;
+	batched.reserve(triangles.size());
+	mTriangleOrder.reserve(triangles.size() / 3);
+	TripletScheduler::ConstTripletIter tIt = scheduler.mTriplets.begin();
+	for (TripletScheduler::SetIter sIt = scheduler.mSetSizes.begin(); sIt != scheduler.mSetSizes.end(); ++sIt)
+	{
+		for (uint32_t i = 0; i < *sIt; ++i, ++tIt)
+		{
+			bool isBatched = i < (*sIt & ~3u);
+			Vector<uint32_t>::Type& dst = isBatched ? batched : remainder;
+			dst.pushBack(tIt->x);
+			dst.pushBack(tIt->y);
+			dst.pushBack(tIt->z);
+			(isBatched ? mTriangleOrder : remainderOrder).pushBack(tIt->w);
+		}
+	}
+	mNumTriangleBatches = batched.size() / 12;
+	for (Vector<uint32_t>::Type::ConstIterator rIt = remainder.begin(); rIt != remainder.end(); ++rIt)
+		batched.pushBack(*rIt);
+	for (Vector<uint32_t>::Type::ConstIterator oIt = remainderOrder.begin(); oIt != remainderOrder.end(); ++oIt)
+		mTriangleOrder.pushBack(*oIt);
+
+	if (use32BitIndices)
+	{
+		batched.swap(mTriangles32);
+	}
+	else
+	{
+		mTriangles.reserve(batched.size());
+		for (Vector<uint32_t>::Type::ConstIterator bIt = batched.begin(); bIt != batched.end(); ++bIt)
+			mTriangles.pushBack(uint16_t(*bIt));
+	}
 
 	mFactory.mFabrics.pushBack(this);
 }
@@ -182,7 +257,7 @@ uint32_t cloth::SwFabric::getNumTethers() const
 
 uint32_t cloth::SwFabric::getNumTriangles() const
 {
-	return uint32_t(mTriangles.size()) / 3;
+	return uint32_t(mTriangles.size() + mTriangles32.size()) / 3;
 }
 
 void cloth::SwFabric::scaleRestvalues(float scale)
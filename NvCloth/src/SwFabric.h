@@ -32,6 +32,14 @@
 #include "NvCloth/Fabric.h"
 #include "NvCloth/Range.h"
 
+// platforms where the solver may dispatch to the 8-wide avx or 16-wide avx-512 constraint solver,
+// which need constraints padded to multiples of their width and 64 byte aligned rest values
+#if PX_WINDOWS_FAMILY || PX_LINUX && (PX_X86 || PX_X64)
+#define NV_CLOTH_AVX_LAYOUT 1
+#else
+#define NV_CLOTH_AVX_LAYOUT 0
+#endif
+
 namespace nv
 {
 
@@ -40,18 +48,24 @@ namespace cloth
 
 class SwFactory;
 
+#if NV_CLOTH_AVX_LAYOUT
+// number of constraints the widest supported avx solver processes at once (8 or 16),
+// defined in SwSolverKernel.cpp
+uint32_t getAvxConstraintWidth();
+#endif
+
 struct SwTether
 {
-	SwTether(uint16_t, float);
-	uint16_t mAnchor;
+	SwTether(uint32_t, float);
+	uint32_t mAnchor;
 	float mLength;
 };
 
 class SwFabric : public Fabric
 {
   public:
-#if PX_WINDOWS_FAMILY
-	typedef AlignedVector<float, 32>::Type RestvalueContainer; // avx
+#if NV_CLOTH_AVX_LAYOUT
+	typedef AlignedVector<float, 64>::Type RestvalueContainer; // avx-512
 #else
 	typedef AlignedVector<float, 16>::Type RestvalueContainer;
 #endif
@@ -93,11 +107,16 @@ class SwFabric : public Fabric
 	RestvalueContainer mRestvalues;  // rest values (edge length)
 	RestvalueContainer mStiffnessValues;  // constraint stiffnesses, uses phase config if empty
 	Vector<uint16_t>::Type mIndices; // particle index pairs
+	Vector<uint32_t>::Type mIndices32; // used instead of mIndices when particles don't fit 16 bit indices
+	Vector<uint32_t>::Type mSharedIndices; // particles referenced more than once within a set
 
 	Vector<SwTether>::Type mTethers;
 	float mTetherLengthScale;
 
 	Vector<uint16_t>::Type mTriangles;
+	Vector<uint32_t>::Type mTriangles32; // used instead of mTriangles, see mIndices32
+	uint32_t mNumTriangleBatches; // leading groups of 4 triangles that don't share particles
+	Vector<uint32_t>::Type mTriangleOrder; // index each triangle was created with, before batching
 
 	uint32_t mId;
 
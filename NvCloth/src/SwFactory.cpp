@@ -105,6 +105,8 @@ void cloth::SwFactory::extractFabricData(const Fabric& fabric, Range<uint32_t> p
 	RestvalueIterator rBegin = swFabric.mRestvalues.begin(), rIt = rBegin;
 	RestvalueIterator stIt = swFabric.mStiffnessValues.begin();
 	Vector<uint16_t>::Type::ConstIterator iIt = swFabric.mIndices.begin();
+	Vector<uint32_t>::Type::ConstIterator iIt32 = swFabric.mIndices32.begin();
+	bool use32BitIndices = !swFabric.mIndices32.empty();
 
 	uint32_t* sDst = sets.begin();
 	float* rDst = restvalues.begin();
@@ -117,8 +119,8 @@ void cloth::SwFactory::extractFabricData(const Fabric& fabric, Range<uint32_t> p
 		RestvalueIterator rEnd = rBegin + *sIt;
 		for (; rIt != rEnd; ++rIt, ++stIt)
 		{
-			uint16_t i0 = *iIt++;
-			uint16_t i1 = *iIt++;
+			uint32_t i0 = use32BitIndices ? *iIt32++ : *iIt++;
+			uint32_t i1 = use32BitIndices ? *iIt32++ : *iIt++;
 
 			if (std::max(i0, i1) >= swFabric.mNumParticles)
 				continue;
@@ -147,8 +149,14 @@ void cloth::SwFactory::extractFabricData(const Fabric& fabric, Range<uint32_t> p
 	for (uint32_t i = 0; !tetherLengths.empty(); ++i, tetherLengths.popFront())
 		tetherLengths.front() = swFabric.mTethers[i].mLength * swFabric.mTetherLengthScale;
 
-	for (uint32_t i = 0; !triangles.empty(); ++i, triangles.popFront())
-		triangles.front() = swFabric.mTriangles[i];
+	// return the triangles in the order they were created with, not the wind batching order
+	NV_CLOTH_ASSERT(triangles.empty() || triangles.size() == swFabric.mTriangleOrder.size() * 3);
+	for (uint32_t i = 0; !triangles.empty() && i < swFabric.mTriangleOrder.size(); ++i)
+	{
+		uint32_t* dst = triangles.begin() + swFabric.mTriangleOrder[i] * 3;
+		for (uint32_t j = i * 3; j < i * 3 + 3; ++j)
+			*dst++ = swFabric.mTriangles32.empty() ? swFabric.mTriangles[j] : swFabric.mTriangles32[j];
+	}
 }
 
 void cloth::SwFactory::extractCollisionData(const Cloth& cloth, Range<PxVec4> spheres, Range<uint32_t> capsules,
@@ -279,6 +287,14 @@ void cloth::SwFactory::extractVirtualParticles(const Cloth& cloth, Range<uint32_
 				*iDestIt++ = Vec4u(*iIt);
 		}
 
+		Vector<Vec4u>::Type::ConstIterator i32It = swCloth.mVirtualParticleIndices32.begin();
+		Vector<Vec4u>::Type::ConstIterator i32End = swCloth.mVirtualParticleIndices32.end();
+		for (; i32It != i32End; ++i32It)
+		{
+			if (i32It->x < numParticles)
+				*iDestIt++ = *i32It;
+		}
+
 		NV_CLOTH_ASSERT(&array(*iDestIt) == indices.end());
 	}
 }
@@ -36,6 +36,7 @@
 #include <algorithm>
 #include "ps/PsSort.h"
 #include "NvCloth/Allocator.h"
+#include "NvCloth/ps/PsAtomic.h"
 
 using namespace nv;
 using namespace physx;
@@ -134,7 +135,8 @@ uint32_t longestAxis(const T4f& edgeLength)
 template <typename T4f>
 cloth::SwInterCollision<T4f>::SwInterCollision(const cloth::SwInterCollisionData* instances, uint32_t n,
                                                   float colDist, float stiffness, uint32_t iterations,
-                                                  InterCollisionFilter filter, cloth::SwKernelAllocator& alloc)
+                                                  InterCollisionFilter filter, cloth::SwKernelAllocator& alloc,
+                                                  SwKernelScheduler* scheduler)
 : mInstances(instances)
 , mNumInstances(n)
 , mClothIndices(NULL)
@@ -143,8 +145,10 @@ cloth::SwInterCollision<T4f>::SwInterCollision(const cloth::SwInterCollisionData
 , mTotalParticles(0)
 , mFilter(filter)
 , mAllocator(alloc)
+, mScheduler(scheduler)
 {
 	NV_CLOTH_ASSERT(mFilter);
+	NV_CLOTH_ASSERT(n <= 0xffff); // cloth indices are stored as uint16_t
 
 	mCollisionDistance = simd4f(colDist, colDist, colDist, 0.0f);
 	mCollisionSquareDistance = mCollisionDistance * mCollisionDistance;
@@ -204,12 +208,15 @@ struct ClothSorter
 // for the given cloth array this function calculates the set of particles
 // which potentially interact, the potential colliders are returned with their
 // cloth index and particle index in clothIndices and particleIndices, the
-// function returns the number of potential colliders
+// function returns the number of potential colliders.
+// the cloths whose particles cloth i collides with are returned in
+// overlaps[overlapOffsets[i], overlapOffsets[i + 1])
 template <typename T4f>
 uint32_t calculatePotentialColliders(const cloth::SwInterCollisionData* cBegin, const cloth::SwInterCollisionData* cEnd,
                                      const T4f& colDist, uint16_t* clothIndices, uint32_t* particleIndices,
-                                     cloth::BoundingBox<T4f>& bounds, uint32_t* overlapMasks,
-                                     cloth::InterCollisionFilter filter, cloth::SwKernelAllocator& allocator)
+                                     cloth::BoundingBox<T4f>& bounds, uint32_t* overlapOffsets,
+                                     cloth::Vector<uint32_t>::Type& overlaps, cloth::InterCollisionFilter filter,
+                                     cloth::SwKernelAllocator& allocator)
 {
 	using namespace cloth;
 
@@ -255,11 +262,76 @@ uint32_t calculatePotentialColliders(const cloth::SwInterCollisionData* cBegin,
 	ClothSorter<T4f> predicate(clothBounds, numCloths, sweepAxis);
 	ps::sort(sortedIndices, numCloths, predicate, nv::cloth::ps::NonTrackingAllocator());
 
+	//----------------------------------------------------------------
+	// sweep and prune: collect the (cloth, other cloth) pairs with overlapping world bounds,
+	// both directions of a pair are added separately if they pass the filter
+
+	overlaps.resize(0);
+	memset(overlapOffsets, 0, (numCloths + 1) * sizeof(uint32_t));
+
+	for (uint32_t i = 0; i < numCloths; ++i)
+	{
+		const uint32_t aIndex = sortedIndices[i];
+		const float axisMax = array(clothBounds[aIndex].mUpper)[sweepAxis];
+
+		for (uint32_t j = i + 1; j < numCloths; ++j)
+		{
+			const uint32_t bIndex = sortedIndices[j];
+
+			// early out if no more cloths along axis intersect us
+			if (array(clothBounds[bIndex].mLower)[sweepAxis] > axisMax)
+				break;
+
+			if (isEmptyBounds(intersectBounds(clothBounds[aIndex], clothBounds[bIndex])))
+				continue;
+
+			// check if collision between these shapes is filtered
+			if (filter(cBegin[aIndex].mUserData, cBegin[bIndex].mUserData))
+			{
+				overlaps.pushBack(aIndex);
+				overlaps.pushBack(bIndex);
+				++overlapOffsets[aIndex];
+			}
+			if (filter(cBegin[bIndex].mUserData, cBegin[aIndex].mUserData))
+			{
+				overlaps.pushBack(bIndex);
+				overlaps.pushBack(aIndex);
+				++overlapOffsets[bIndex];
+			}
+		}
+	}
+
+	// group the other cloths by cloth behind the pair list
+	const uint32_t numPairs = overlaps.size() / 2;
+	uint32_t sum = 2 * numPairs;
+	for (uint32_t i = 0; i < numCloths; ++i)
+	{
+		uint32_t temp = overlapOffsets[i] + sum;
+		overlapOffsets[i] = sum;
+		sum = temp;
+	}
+	overlaps.resize(sum);
+
+	for (uint32_t i = 0; i < numPairs; ++i)
+		overlaps[overlapOffsets[overlaps[2 * i]]++] = overlaps[2 * i + 1];
+
+	// overlapOffsets[i] now is the end of cloth i, shift to get the begin offsets
+	for (uint32_t i = numCloths; i > 0; --i)
+		overlapOffsets[i] = overlapOffsets[i - 1];
+	overlapOffsets[0] = 2 * numPairs;
+
+	//----------------------------------------------------------------
+	// cull all particles to overlapping bounds and transform particles to world space
+
 	for (uint32_t i = 0; i < numCloths; ++i)
 	{
-		NV_CLOTH_ASSERT(sortedIndices[i] < numCloths);
+		const uint32_t clothIndex = sortedIndices[i];
+		const SwInterCollisionData& a = cBegin[clothIndex];
 
-		const SwInterCollisionData& a = cBegin[sortedIndices[i]];
+		const uint32_t* oBegin = overlaps.begin() + overlapOffsets[clothIndex];
+		const uint32_t* oEnd = overlaps.begin() + overlapOffsets[clothIndex + 1];
+		if (oBegin == oEnd)
+			continue;
 
 		// local bounds
 		const T4f aCenter = load(reinterpret_cast<const float*>(&a.mBoundsCenter));
@@ -269,36 +341,12 @@ uint32_t calculatePotentialColliders(const cloth::SwInterCollisionData* cBegin,
 		const PxMat44 aToWorld = PxMat44(a.mGlobalPose);
 		const PxTransform aToLocal = a.mGlobalPose.getInverse();
 
-		const float axisMin = array(clothBounds[sortedIndices[i]].mLower)[sweepAxis];
-		const float axisMax = array(clothBounds[sortedIndices[i]].mUpper)[sweepAxis];
-
-		uint32_t overlapMask = 0;
 		uint32_t numOverlaps = 0;
 
-		// scan forward to skip non intersecting bounds
-		uint32_t startIndex = 0;
-		while(startIndex < numCloths && array(clothBounds[sortedIndices[startIndex]].mUpper)[sweepAxis] < axisMin)
-			startIndex++;
-
 		// compute all overlapping bounds
-		for (uint32_t j = startIndex; j < numCloths; ++j)
+		for (const uint32_t* oIt = oBegin; oIt != oEnd; ++oIt)
 		{
-			// ignore self-collision
-			if (i == j)
-				continue;
-
-			// early out if no more cloths along axis intersect us
-			if (array(clothBounds[sortedIndices[j]].mLower)[sweepAxis] > axisMax)
-				break;
-
-			const SwInterCollisionData& b = cBegin[sortedIndices[j]];
-
-			// check if collision between these shapes is filtered
-			if (!filter(a.mUserData, b.mUserData))
-				continue;
-
-			// set mask bit for this cloth
-			overlapMask |= 1 << sortedIndices[j];
+			const SwInterCollisionData& b = cBegin[*oIt];
 
 			// transform bounds from b local space to local space of a
 			PxBounds3 lcBounds = PxBounds3::centerExtents(b.mBoundsCenter, b.mBoundsHalfExtent + PxVec3(array(colDist)[0]));
@@ -319,12 +367,6 @@ uint32_t calculatePotentialColliders(const cloth::SwInterCollisionData* cBegin,
 				overlapBounds[numOverlaps++] = iBounds;
 		}
 
-		//----------------------------------------------------------------
-		// cull all particles to overlapping bounds and transform particles to world space
-
-		const uint32_t clothIndex = sortedIndices[i];
-		overlapMasks[clothIndex] = overlapMask;
-
 		T4f* pBegin = reinterpret_cast<T4f*>(a.mParticles);
 		T4f* qBegin = reinterpret_cast<T4f*>(a.mPrevParticles);
 
@@ -399,7 +441,7 @@ void cloth::SwInterCollision<T4f>::operator()()
 
 	mClothIndices = static_cast<uint16_t*>(mAllocator.allocate(sizeof(uint16_t) * mTotalParticles));
 	mParticleIndices = static_cast<uint32_t*>(mAllocator.allocate(sizeof(uint32_t) * mTotalParticles));
-	mOverlapMasks = static_cast<uint32_t*>(mAllocator.allocate(sizeof(uint32_t*) * mNumInstances));
+	mOverlapOffsets = static_cast<uint32_t*>(mAllocator.allocate(sizeof(uint32_t) * (mNumInstances + 1)));
 
 	for (uint32_t k = 0; k < mNumIterations; ++k)
 	{
@@ -412,7 +454,7 @@ void cloth::SwInterCollision<T4f>::operator()()
 
 			mNumParticles =
 			    calculatePotentialColliders(mInstances, mInstances + mNumInstances, mCollisionDistance, mClothIndices,
-			                                mParticleIndices, bounds, mOverlapMasks, mFilter, mAllocator);
+			                                mParticleIndices, bounds, mOverlapOffsets, mOverlaps, mFilter, mAllocator);
 		}
 
 		// collide
@@ -460,15 +502,17 @@ void cloth::SwInterCollision<T4f>::operator()()
 				// pushes particles outside of their original bounds
 				Simd4i indexi = intFloor(max(one, min(indexf, gridSize)));
 
-				const int32_t* ptr = array(indexi);
+				// store instead of array() so the compiler can't drop the write under strict aliasing
+				int32_t ptr[4];
+				store(ptr, indexi);
 				keys[i] = uint32_t(ptr[sweepAxis] | (ptr[hashAxis0] << 16) | (ptr[hashAxis1] << 24));
 			}
 
 			// compute sorted keys indices
 			radixSort(keys, keys + mNumParticles, sortedIndices);
 
-			// snoop histogram: offset of first index with 8 msb > 1 (0 is sentinel)
-			uint32_t firstColumnSize = sortedIndices[2 * mNumParticles + 769];
+			// snoop histogram: end offsets of the 256 rows with the same 8 msb
+			mRowEnds = sortedIndices + 2 * mNumParticles + 768;
 
 			// sort keys
 			for (uint32_t i = 0; i < mNumParticles; ++i)
@@ -476,11 +520,14 @@ void cloth::SwInterCollision<T4f>::operator()()
 			sortedKeys[mNumParticles] = uint32_t(-1); // sentinel
 
 			// calculate the number of buckets we need to search forward
-			const Simd4i data = intFloor(gridScale * mCollisionDistance);
-			uint32_t collisionDistance = uint32_t(2 + array(data)[sweepAxis]);
+			int32_t data[4];
+			store(data, intFloor(gridScale * mCollisionDistance));
+			mCollisionCells = uint32_t(2 + data[sweepAxis]);
 
 			// collide particles
-			collideParticles(sortedKeys, firstColumnSize, sortedIndices, mNumParticles, collisionDistance);
+			mSortedKeys = sortedKeys;
+			mSortedIndices = sortedIndices;
+			collideParticles();
 
 			mAllocator.deallocate(buffer);
 		}
@@ -492,7 +539,8 @@ void cloth::SwInterCollision<T4f>::operator()()
 
 		for (uint32_t i = 0; i < mNumParticles; ++i)
 		    for (uint32_t j = i + 1; j < mNumParticles; ++j)
-		        if (mOverlapMasks[mClothIndices[i]] & (1 << mClothIndices[j]))
+		        if (std::count(mOverlaps.begin() + mOverlapOffsets[mClothIndices[i]],
+		                       mOverlaps.begin() + mOverlapOffsets[mClothIndices[i] + 1], mClothIndices[j]))
 		            collideParticles(getParticle(i), getParticle(j));
 
 		static uint32_t iter = 0; ++iter;
@@ -538,7 +586,7 @@ void cloth::SwInterCollision<T4f>::operator()()
 		}
 	}
 
-	mAllocator.deallocate(mOverlapMasks);
+	mAllocator.deallocate(mOverlapOffsets);
 	mAllocator.deallocate(mParticleIndices);
 	mAllocator.deallocate(mClothIndices);
 }
@@ -554,9 +602,9 @@ size_t cloth::SwInterCollision<T4f>::estimateTemporaryMemory(SwInterCollisionDat
 	uint32_t boundsSize = 2 * n * sizeof(BoundingBox<T4f>) + n * sizeof(uint32_t);
 	uint32_t clothIndicesSize = numParticles * sizeof(uint16_t);
 	uint32_t particleIndicesSize = numParticles * sizeof(uint32_t);
-	uint32_t masksSize = n * sizeof(uint32_t);
+	uint32_t offsetsSize = (n + 1) * sizeof(uint32_t);
 
-	return boundsSize + clothIndicesSize + particleIndicesSize + masksSize + getBufferSize(numParticles);
+	return boundsSize + clothIndicesSize + particleIndicesSize + offsetsSize + getBufferSize(numParticles);
 }
 
 template <typename T4f>
@@ -570,12 +618,19 @@ size_t cloth::SwInterCollision<T4f>::getBufferSize(uint32_t numParticles)
 }
 
 template <typename T4f>
-void cloth::SwInterCollision<T4f>::collideParticle(uint32_t index)
+void cloth::SwInterCollision<T4f>::collideParticle(uint32_t index, Collider& collider)
 {
-	// The other particle is passed through member variables (mParticle)
+	// The other particle is passed through the collider
 	uint16_t clothIndex = mClothIndices[index];
 
-	if ((1 << clothIndex) & ~mClothMask)
+	// the overlap lists are short and consecutive particles mostly belong to the same cloth
+	if (clothIndex != collider.mOtherCloth)
+	{
+		collider.mOtherCloth = clothIndex;
+		collider.mOtherClothOverlaps = std::find(collider.mOverlapsBegin, collider.mOverlapsEnd, clothIndex) != collider.mOverlapsEnd;
+	}
+
+	if (!collider.mOtherClothOverlaps)
 		return;
 
 	const SwInterCollisionData* instance = mInstances + clothIndex;
@@ -585,40 +640,59 @@ void cloth::SwInterCollision<T4f>::collideParticle(uint32_t index)
 
 
 	//very similar to cloth::SwSelfCollision<T4f>::collideParticles
-	T4f diff = particle - mParticle;
+	T4f diff = particle - collider.mParticle;
 	T4f distSqr = dot3(diff, diff);
 
 #if PX_DEBUG
-	++mNumTests;
+	++collider.mNumTests;
 #endif
 
 	if (allGreater(distSqr, mCollisionSquareDistance))
 		return;
 
-	T4f w0 = splat<3>(mParticle);
+	T4f w0 = splat<3>(collider.mParticle);
 	T4f w1 = splat<3>(particle);
 
 	T4f ratio = mCollisionDistance * rsqrt<1>(distSqr);
 	T4f scale = mStiffness * recip<1>(sEpsilon + w0 + w1);
 	T4f delta = (scale * (diff - diff * ratio)) & sMaskXYZ;
 
-	mParticle = mParticle + delta * w0;
+	collider.mParticle = collider.mParticle + delta * w0;
 	particle = particle - delta * w1;
 
 	T4f& impulse = reinterpret_cast<T4f&>(instance->mPrevParticles[particleIndex]);
 
-	mImpulse = mImpulse + delta * w0;
+	collider.mImpulse = collider.mImpulse + delta * w0;
 	impulse = impulse - delta * w1;
 
 #if PX_DEBUG || PX_PROFILE
-	++mNumCollisions;
+	++collider.mNumCollisions;
 #endif
 }
 
 template <typename T4f>
-void cloth::SwInterCollision<T4f>::collideParticles(const uint32_t* keys, uint32_t firstColumnSize,
-                                                       const uint32_t* indices, uint32_t numParticles,
-                                                       uint32_t collisionDistance)
+void cloth::SwInterCollision<T4f>::collideParticles()
+{
+	// the neighbor cells searched below are in the same row or the next one (see keyOffsets),
+	// so rows of the same parity never touch the same particles. processing the even rows
+	// before the odd ones gives the same result no matter how the rows are distributed.
+	for (mRowParity = 0; mRowParity < 2; ++mRowParity)
+	{
+		if (mScheduler)
+			mScheduler->parallelFor(&executeRowRange, this, 128, 1);
+		else
+			collideRowRange(0, 128);
+	}
+}
+
+template <typename T4f>
+void cloth::SwInterCollision<T4f>::executeRowRange(void* collider, uint32_t first, uint32_t last)
+{
+	static_cast<SwInterCollision<T4f>*>(collider)->collideRowRange(first, last);
+}
+
+template <typename T4f>
+void cloth::SwInterCollision<T4f>::collideRowRange(uint32_t first, uint32_t last)
 {
 	//very similar to cloth::SwSelfCollision<T4f>::collideParticles
 
@@ -626,96 +700,118 @@ void cloth::SwInterCollision<T4f>::collideParticles(const uint32_t* keys, uint32
 
 	const uint32_t keyOffsets[] = { 0, 0x00010000, 0x00ff0000, 0x01000000, 0x01010000 };
 
-	const uint32_t* __restrict kFirst[5];
-	const uint32_t* __restrict kLast[5];
+	const uint32_t* __restrict keys = mSortedKeys;
+	const uint32_t* __restrict indices = mSortedIndices;
+	const uint32_t collisionDistance = mCollisionCells;
 
-	{
-		// optimization: scan forward iterator starting points once instead of 9 times
-		const uint32_t* __restrict kIt = keys;
+	Collider collider;
+	collider.mNumTests = collider.mNumCollisions = 0;
 
-		uint32_t key = *kIt;
-		uint32_t firstKey = key - std::min(collisionDistance, key & bucketMask);
-		uint32_t lastKey = std::min(key + collisionDistance, key | bucketMask);
+	for (uint32_t row = 2 * first + mRowParity, rowEnd = 2 * last + mRowParity; row < rowEnd; row += 2)
+	{
+		uint32_t begin = row ? mRowEnds[row - 1] : 0;
+		uint32_t end = mRowEnds[row];
+		if (begin == end)
+			continue;
 
-		kFirst[0] = kIt;
-		while (*kIt < lastKey)
-			++kIt;
-		kLast[0] = kIt;
+		const uint32_t* __restrict kFirst[5];
+		const uint32_t* __restrict kLast[5];
 
-		for (uint32_t k = 1; k < 5; ++k)
 		{
-			for (uint32_t n = firstKey + keyOffsets[k]; *kIt < n;)
-				++kIt;
-			kFirst[k] = kIt;
+			// optimization: scan forward iterator starting points once instead of 9 times
+			const uint32_t* __restrict kIt = keys + begin;
+
+			uint32_t key = *kIt;
+			uint32_t firstKey = key - std::min(collisionDistance, key & bucketMask);
+			uint32_t lastKey = std::min(key + collisionDistance, key | bucketMask);
 
-			for (uint32_t n = lastKey + keyOffsets[k]; *kIt < n;)
+			kFirst[0] = kIt;
+			while (*kIt < lastKey)
 				++kIt;
-			kLast[k] = kIt;
+			kLast[0] = kIt;
 
-			// jump forward once to second column to go from cell offset 1 to 2 quickly
-			if(firstColumnSize)
-				kIt = keys + firstColumnSize;
-			firstColumnSize = 0;
-		}
-	}
+			for (uint32_t k = 1; k < 5; ++k)
+			{
+				for (uint32_t n = firstKey + keyOffsets[k]; *kIt < n;)
+					++kIt;
+				kFirst[k] = kIt;
 
-	const uint32_t* __restrict iIt = indices;
-	const uint32_t* __restrict iEnd = indices + numParticles;
+				for (uint32_t n = lastKey + keyOffsets[k]; *kIt < n;)
+					++kIt;
+				kLast[k] = kIt;
 
-	const uint32_t* __restrict jIt;
-	const uint32_t* __restrict jEnd;
+				// jump forward once to the next row to go from cell offset 1 to 2 quickly
+				if (k == 1)
+					kIt = std::max(kIt, keys + end);
+			}
+		}
 
-	for (; iIt != iEnd; ++iIt, ++kFirst[0])
-	{
-		// load current particle once outside of inner loop
-		uint32_t index = *iIt;
-		NV_CLOTH_ASSERT(index < mNumParticles);
-		mClothIndex = mClothIndices[index];
-		NV_CLOTH_ASSERT(mClothIndex < mNumInstances);
-		mClothMask = mOverlapMasks[mClothIndex];
+		const uint32_t* __restrict iIt = indices + begin;
+		const uint32_t* __restrict iEnd = indices + end;
 
-		const SwInterCollisionData* instance = mInstances + mClothIndex;
+		const uint32_t* __restrict jIt;
+		const uint32_t* __restrict jEnd;
 
-		mParticleIndex = mParticleIndices[index];
-		mParticle = reinterpret_cast<const T4f&>(instance->mParticles[mParticleIndex]);
-		mImpulse = reinterpret_cast<const T4f&>(instance->mPrevParticles[mParticleIndex]);
+		for (; iIt != iEnd; ++iIt, ++kFirst[0])
+		{
+			// load current particle once outside of inner loop
+			uint32_t index = *iIt;
+			NV_CLOTH_ASSERT(index < mNumParticles);
+			uint16_t clothIndex = mClothIndices[index];
+			NV_CLOTH_ASSERT(clothIndex < mNumInstances);
+			collider.mOverlapsBegin = mOverlaps.begin() + mOverlapOffsets[clothIndex];
+			collider.mOverlapsEnd = mOverlaps.begin() + mOverlapOffsets[clothIndex + 1];
+			collider.mOtherCloth = clothIndex; // a cloth never overlaps itself
+			collider.mOtherClothOverlaps = false;
 
-		uint32_t key = *kFirst[0];
+			const SwInterCollisionData* instance = mInstances + clothIndex;
 
-		// range of keys we need to check against for this particle
-		uint32_t firstKey = key - std::min(collisionDistance, key & bucketMask);
-		uint32_t lastKey = std::min(key + collisionDistance, key | bucketMask);
+			uint32_t particleIndex = mParticleIndices[index];
+			collider.mParticle = reinterpret_cast<const T4f&>(instance->mParticles[particleIndex]);
+			collider.mImpulse = reinterpret_cast<const T4f&>(instance->mPrevParticles[particleIndex]);
 
-		// scan forward end point
-		while (*kLast[0] < lastKey)
-			++kLast[0];
+			uint32_t key = *kFirst[0];
 
-		// process potential colliders of same cell
-		jEnd = indices + (kLast[0] - keys);
-		for (jIt = iIt + 1; jIt != jEnd; ++jIt)
-			collideParticle(*jIt);
-
-		// process neighbor cells
-		for (uint32_t k = 1; k < 5; ++k)
-		{
-			// scan forward start point
-			for (uint32_t n = firstKey + keyOffsets[k]; *kFirst[k] < n;)
-				++kFirst[k];
+			// range of keys we need to check against for this particle
+			uint32_t firstKey = key - std::min(collisionDistance, key & bucketMask);
+			uint32_t lastKey = std::min(key + collisionDistance, key | bucketMask);
 
 			// scan forward end point
-			for (uint32_t n = lastKey + keyOffsets[k]; *kLast[k] < n;)
-				++kLast[k];
+			while (*kLast[0] < lastKey)
+				++kLast[0];
 
-			// process potential colliders
-			jEnd = indices + (kLast[k] - keys);
-			for (jIt = indices + (kFirst[k] - keys); jIt != jEnd; ++jIt)
-				collideParticle(*jIt);
-		}
+			// process potential colliders of same cell
+			jEnd = indices + (kLast[0] - keys);
+			for (jIt = iIt + 1; jIt != jEnd; ++jIt)
+				collideParticle(*jIt, collider);
+
+			// process neighbor cells
+			for (uint32_t k = 1; k < 5; ++k)
+			{
+				// scan forward start point
+				for (uint32_t n = firstKey + keyOffsets[k]; *kFirst[k] < n;)
+					++kFirst[k];
+
+				// scan forward end point
+				for (uint32_t n = lastKey + keyOffsets[k]; *kLast[k] < n;)
+					++kLast[k];
+
+				// process potential colliders
+				jEnd = indices + (kLast[k] - keys);
+				for (jIt = indices + (kFirst[k] - keys); jIt != jEnd; ++jIt)
+					collideParticle(*jIt, collider);
+			}
 
-		// write back particle and impulse
-		reinterpret_cast<T4f&>(instance->mParticles[mParticleIndex]) = mParticle;
-		reinterpret_cast<T4f&>(instance->mPrevParticles[mParticleIndex]) = mImpulse;
+			// write back particle and impulse
+			reinterpret_cast<T4f&>(instance->mParticles[particleIndex]) = collider.mParticle;
+			reinterpret_cast<T4f&>(instance->mPrevParticles[particleIndex]) = collider.mImpulse;
+		}
 	}
+
+#if PX_DEBUG || PX_PROFILE
+	ps::atomicAdd(reinterpret_cast<volatile int32_t*>(&mNumTests), int32_t(collider.mNumTests));
+	ps::atomicAdd(reinterpret_cast<volatile int32_t*>(&mNumCollisions), int32_t(collider.mNumCollisions));
+#endif
 }
 
 // explicit template instantiation
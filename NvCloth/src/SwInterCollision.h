@@ -30,6 +30,8 @@
 #pragma once
 
 #include "StackAllocator.h"
+#include "SwKernelScheduler.h"
+#include "NvCloth/Allocator.h"
 #include "Simd.h"
 #include <foundation/PxVec4.h>
 #include <foundation/PxVec3.h>
@@ -84,7 +86,8 @@ class SwInterCollision
 
   public:
 	SwInterCollision(const SwInterCollisionData* cloths, uint32_t n, float colDist, float stiffness,
-	                 uint32_t iterations, InterCollisionFilter filter, cloth::SwKernelAllocator& alloc);
+	                 uint32_t iterations, InterCollisionFilter filter, cloth::SwKernelAllocator& alloc,
+	                 SwKernelScheduler* scheduler = NULL);
 
 	~SwInterCollision();
 
@@ -97,40 +100,58 @@ class SwInterCollision
 
 	static size_t getBufferSize(uint32_t);
 
-	void collideParticles(const uint32_t* keys, uint32_t firstColumnSize, const uint32_t* sortedIndices,
-	                      uint32_t numParticles, uint32_t collisionDistance);
+	// particle colliding with its neighbors, one per row so rows can be processed in parallel
+	struct Collider
+	{
+		T4f mParticle;
+		T4f mImpulse;
+		const uint32_t* mOverlapsBegin; // cloths the particle's cloth collides with
+		const uint32_t* mOverlapsEnd;
+		uint32_t mOtherCloth; // cloth of the last tested particle
+		bool mOtherClothOverlaps;
+		uint32_t mNumTests;
+		uint32_t mNumCollisions;
+	};
+
+	void collideParticles();
+
+	// collides the particles of rows [first, last) with the current parity,
+	// executed through the scheduler to share the rows with other chunks
+	void collideRowRange(uint32_t first, uint32_t last);
+	static void executeRowRange(void* collider, uint32_t first, uint32_t last);
 
 	T4f& getParticle(uint32_t index);
 
-	// better wrap these in a struct
-	void collideParticle(uint32_t index);
-
-	T4f mParticle;
-	T4f mImpulse;
+	void collideParticle(uint32_t index, Collider& collider);
 
 	T4f mCollisionDistance;
 	T4f mCollisionSquareDistance;
 	T4f mStiffness;
 
-	uint16_t mClothIndex;
-	uint32_t mClothMask;
-	uint32_t mParticleIndex;
-
 	uint32_t mNumIterations;
 
+	// sorted potential colliders of the current iteration
+	const uint32_t* mSortedKeys;
+	const uint32_t* mSortedIndices;
+	const uint32_t* mRowEnds; // end offset of each row (8 msb of the keys)
+	uint32_t mCollisionCells; // number of buckets to search forward along the sweep axis
+	uint32_t mRowParity;
+
 	const SwInterCollisionData* mInstances;
 	uint32_t mNumInstances;
 
 	uint16_t* mClothIndices;
 	uint32_t* mParticleIndices;
 	uint32_t mNumParticles;
-	uint32_t* mOverlapMasks;
+	uint32_t* mOverlapOffsets; // begin of each cloth's overlap list in mOverlaps
+	Vector<uint32_t>::Type mOverlaps; // overlapping cloth pairs, followed by the overlap lists
 
 	uint32_t mTotalParticles;
 
 	InterCollisionFilter mFilter;
 
 	SwKernelAllocator& mAllocator;
+	SwKernelScheduler* mScheduler;
 
   public:
 	mutable uint32_t mNumTests;
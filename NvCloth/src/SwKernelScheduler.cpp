@@ -0,0 +1,168 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2020 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#include "SwKernelScheduler.h"
+#include "Simd.h"
+#include "NvCloth/ps/PsAtomic.h"
+#include <algorithm>
+#include <thread>
+
+using namespace nv;
+
+namespace
+{
+const int32_t sIdle = 0;
+const int32_t sRunning = 1;
+const int32_t sFinished = 2;
+
+// the cursor stores (generation << 24 | numBatches << 12 | nextBatch)
+const uint32_t sMaxBatches = 0xfff;
+
+const uint32_t sMaxSpinCount = 64;
+
+// helpers give up after waiting this many spins for the next loop, a longer
+// serial phase of the kernel is better spent on the chunks of other cloths
+const uint32_t sMaxIdleSpinCount = 16 * sMaxSpinCount;
+
+// gives up the time slice after spinning for a while, the thread
+// we are waiting on might not be running (e.g. more chunks than cores)
+inline void spinWait(uint32_t& spinCount)
+{
+	if (++spinCount < sMaxSpinCount)
+	{
+#if NV_SIMD_SSE2
+		_mm_pause();
+#endif
+		return;
+	}
+
+	spinCount = 0;
+	std::this_thread::yield();
+}
+}
+
+cloth::SwKernelScheduler::SwKernelScheduler()
+: mState(sIdle)
+, mCursor(0)
+, mPendingBatches(0)
+, mNumHelpers(0)
+, mTask(NULL)
+, mContext(NULL)
+, mCount(0)
+, mBatchSize(0)
+{
+}
+
+void cloth::SwKernelScheduler::reset()
+{
+	NV_CLOTH_ASSERT(!mNumHelpers);
+	mState = sIdle;
+}
+
+bool cloth::SwKernelScheduler::acquire()
+{
+	return ps::atomicCompareExchange(&mState, sRunning, sIdle) == sIdle;
+}
+
+void cloth::SwKernelScheduler::release()
+{
+	ps::atomicExchange(&mState, sFinished);
+}
+
+void cloth::SwKernelScheduler::help()
+{
+	ps::atomicIncrement(&mNumHelpers);
+
+	uint32_t spinCount = 0, idleSpinCount = 0;
+	while (mState != sFinished && idleSpinCount < sMaxIdleSpinCount)
+	{
+		if (executeBatch())
+		{
+			spinCount = idleSpinCount = 0;
+			continue;
+		}
+
+		spinWait(spinCount);
+		++idleSpinCount;
+	}
+
+	ps::atomicDecrement(&mNumHelpers);
+}
+
+void cloth::SwKernelScheduler::parallelFor(Task task, void* context, uint32_t count, uint32_t batchSize)
+{
+	// nobody to share the work with
+	if (!mNumHelpers || count <= batchSize)
+		return task(context, 0, count);
+
+	uint32_t numBatches = (count + batchSize - 1) / batchSize;
+	if (numBatches > sMaxBatches)
+	{
+		// grow batches (by a multiple to keep their alignment) until the count fits
+		batchSize *= (numBatches + sMaxBatches - 1) / sMaxBatches;
+		numBatches = (count + batchSize - 1) / batchSize;
+	}
+
+	mTask = task;
+	mContext = context;
+	mCount = count;
+	mBatchSize = batchSize;
+	mPendingBatches = int32_t(numBatches);
+
+	// publish the loop under a new generation (full barrier)
+	uint32_t generation = (uint32_t(mCursor) >> 24) + 1;
+	ps::atomicExchange(&mCursor, int32_t(generation << 24 | numBatches << 12));
+
+	while (executeBatch())
+		;
+
+	// wait for the batches still running on helpers
+	uint32_t spinCount = 0;
+	while (ps::atomicCompareExchange(&mPendingBatches, 0, 0))
+		spinWait(spinCount);
+}
+
+bool cloth::SwKernelScheduler::executeBatch()
+{
+	uint32_t cursor = uint32_t(mCursor);
+	uint32_t batch = cursor & sMaxBatches;
+	if (batch >= (cursor >> 12 & sMaxBatches))
+		return false;
+
+	// claim batch, the generation in the cursor makes sure we don't claim a batch of an earlier loop
+	if (ps::atomicCompareExchange(&mCursor, int32_t(cursor + 1), int32_t(cursor)) != int32_t(cursor))
+		return true;
+
+	// loop parameters are not modified until all batches have completed
+	uint32_t first = batch * mBatchSize;
+	mTask(mContext, first, std::min(first + mBatchSize, mCount));
+
+	ps::atomicDecrement(&mPendingBatches);
+	return true;
+}
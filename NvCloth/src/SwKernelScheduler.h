@@ -0,0 +1,88 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2020 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#pragma once
+
+#include <foundation/Px.h>
+
+namespace nv
+{
+namespace cloth
+{
+
+/**
+   Shares the work of a single cloth between multiple SwSolver chunks.
+   The first chunk to arrive runs the solver kernel, every other chunk of
+   the same cloth joins in and executes batches of the kernel's parallel
+   loops. Helpers leave when the kernel runs a longer serial phase, so
+   their threads can take other chunks instead of waiting. No chunk ever
+   waits for another chunk to arrive, so simulating the chunks
+   sequentially is still valid.
+ */
+class SwKernelScheduler
+{
+  public:
+	typedef void (*Task)(void* context, uint32_t first, uint32_t last);
+
+	SwKernelScheduler();
+
+	// prepare for the next frame
+	void reset();
+
+	// returns true if the caller should run the kernel
+	bool acquire();
+	// called by the kernel owner when done, returns helpers from help()
+	void release();
+
+	// called by all other chunks, executes batches until release()
+	// or until no new loop has been started for a while
+	void help();
+
+	// executes task over [0, count) in batches of batchSize (last one may be smaller),
+	// returns when all batches have completed
+	void parallelFor(Task task, void* context, uint32_t count, uint32_t batchSize);
+
+  private:
+	bool executeBatch();
+
+	// kernel owner state (idle, running, finished)
+	volatile int32_t mState;
+	// generation, batch count and next batch index of the current loop
+	volatile int32_t mCursor;
+	volatile int32_t mPendingBatches;
+	volatile int32_t mNumHelpers;
+
+	Task mTask;
+	void* mContext;
+	uint32_t mCount;
+	uint32_t mBatchSize;
+};
+
+} // namespace cloth
+} // namespace nv
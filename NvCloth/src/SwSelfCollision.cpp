@@ -43,17 +43,18 @@ namespace
 {
 
 // returns sorted indices, output needs to be at least 2*(last - first) + 1024
-void radixSort(const uint32_t* first, const uint32_t* last, uint16_t* out)
+template <typename IndexT>
+void radixSort(const uint32_t* first, const uint32_t* last, IndexT* out)
 {
 	// Note: This function is almost exactly duplicated in SwInterCollision.cpp
 	// this sort uses a radix (bin) size of 256, requiring 4 bins to sort the 32 bit keys
-	uint16_t n = uint16_t(last - first);
+	IndexT n = IndexT(last - first);
 
-	uint16_t* buffer = out + 2 * n;
-	uint16_t* __restrict histograms[] = { buffer, buffer + 256, buffer + 512, buffer + 768 };
+	IndexT* buffer = out + 2 * n;
+	IndexT* __restrict histograms[] = { buffer, buffer + 256, buffer + 512, buffer + 768 };
 
 	//zero the buffer memory used for the 4 buckets
-	memset(buffer, 0, 1024 * sizeof(uint16_t));
+	memset(buffer, 0, 1024 * sizeof(IndexT));
 
 	// build 4 histograms in one pass
 	for (const uint32_t* __restrict it = first; it != last; ++it)
@@ -66,48 +67,48 @@ void radixSort(const uint32_t* first, const uint32_t* last, uint16_t* out)
 	}
 
 	// convert histograms to offset tables in-place
-	uint16_t sums[4] = {0, 0, 0, 0};
+	IndexT sums[4] = {0, 0, 0, 0};
 	for (uint32_t i = 0; i < 256; ++i)
 	{
-		uint16_t temp0 = uint16_t(histograms[0][i] + sums[0]);
+		IndexT temp0 = IndexT(histograms[0][i] + sums[0]);
 		histograms[0][i] = sums[0]; sums[0] = temp0;
 
-		uint16_t temp1 = uint16_t(histograms[1][i] + sums[1]);
+		IndexT temp1 = IndexT(histograms[1][i] + sums[1]);
 		histograms[1][i] = sums[1]; sums[1] = temp1;
 
-		uint16_t temp2 = uint16_t(histograms[2][i] + sums[2]);
+		IndexT temp2 = IndexT(histograms[2][i] + sums[2]);
 		histograms[2][i] = sums[2]; sums[2] = temp2;
 
-		uint16_t temp3 = uint16_t(histograms[3][i] + sums[3]);
+		IndexT temp3 = IndexT(histograms[3][i] + sums[3]);
 		histograms[3][i] = sums[3]; sums[3] = temp3;
 	}
 
 	NV_CLOTH_ASSERT(sums[0] == n && sums[1] == n && sums[2] == n && sums[3] == n);
 
 #if PX_DEBUG
-	memset(out, 0xff, 2 * n * sizeof(uint16_t));
+	memset(out, 0xff, 2 * n * sizeof(IndexT));
 #endif
 
 	// sort 8 bits per pass
 
-	uint16_t* __restrict indices[] = { out, out + n };
+	IndexT* __restrict indices[] = { out, out + n };
 
-	for (uint16_t i = 0; i != n; ++i)
+	for (IndexT i = 0; i != n; ++i)
 		indices[1][histograms[0][0xff & first[i]]++] = i;
 
-	for (uint16_t i = 0, index; i != n; ++i)
+	for (IndexT i = 0, index; i != n; ++i)
 	{
 		index = indices[1][i];
 		indices[0][histograms[1][0xff & (first[index] >> 8)]++] = index;
 	}
 
-	for (uint16_t i = 0, index; i != n; ++i)
+	for (IndexT i = 0, index; i != n; ++i)
 	{
 		index = indices[0][i];
 		indices[1][histograms[2][0xff & (first[index] >> 16)]++] = index;
 	
 	}
-	for (uint16_t i = 0, index; i != n; ++i)
+	for (IndexT i = 0, index; i != n; ++i)
 	{
 		index = indices[1][i];
 		indices[0][histograms[3][first[index] >> 24]++] = index;
@@ -141,6 +142,12 @@ inline uint32_t align2(uint32_t x)
 	return (x + 1) & ~1;
 }
 
+// particles are sorted with 16 bit indices unless they don't fit
+inline bool use32BitIndices(uint32_t numIndices, uint32_t numParticles)
+{
+	return std::max(numIndices, numParticles) > 0xffff;
+}
+
 } // anonymous namespace
 
 template <typename T4f>
@@ -186,12 +193,10 @@ void cloth::SwSelfCollision<T4f>::operator()()
 	T4f gridBias = -lowerBound * gridScale + one;
 
 	uint32_t numIndices = mClothData.mNumSelfCollisionIndices;
-	void* buffer = mAllocator.allocate(getBufferSize(numIndices));
+	void* buffer = mAllocator.allocate(getBufferSize(numIndices, mClothData.mNumParticles));
 
 	const uint32_t* __restrict indices = mClothData.mSelfCollisionIndices;
 	uint32_t* __restrict keys = reinterpret_cast<uint32_t*>(buffer);
-	uint16_t* __restrict sortedIndices = reinterpret_cast<uint16_t*>(keys + numIndices);
-	uint32_t* __restrict sortedKeys = reinterpret_cast<uint32_t*>(sortedIndices + align2(numIndices));
 
 	const T4f* particles = reinterpret_cast<const T4f*>(mClothData.mCurParticles);
 
@@ -208,43 +213,20 @@ void cloth::SwSelfCollision<T4f>::operator()()
 		// pushes particles outside of their original bounds
 		Simd4i keyi = intFloor(max(one, min(keyf, gridSize)));
 
-		const int32_t* ptr = array(keyi);
+		int32_t ptr[4];
+		store(ptr, keyi);
 		keys[i] = uint32_t(ptr[sweepAxis] | (ptr[hashAxis0] << 16) | (ptr[hashAxis1] << 24));
 	}
 
-	// compute sorted key indices
-	radixSort(keys, keys + numIndices, sortedIndices);
-
-	// snoop histogram: offset of first index with 8 msb > 1 (0 is sentinel)
-	// sortedIndices[2 * numIndices + 768 + 1] is actually histograms[3]+1 from radixSort
-	uint16_t firstColumnSize = sortedIndices[2 * numIndices + 768 + 1];
-
-	// sort keys using the sortedIndices
-	for (uint32_t i = 0; i < numIndices; ++i)
-		sortedKeys[i] = keys[sortedIndices[i]];
-	sortedKeys[numIndices] = uint32_t(-1); // sentinel
-
-	// do user provided index array indirection here if we have one
-	//  so we don't need to keep branching for this condition later
-	if (indices)
-	{
-		// sort indices (into no-longer-needed keys array)
-		// the keys array is no longer used so we can reuse it to store indices[sortedIndices[i]]
-		const uint16_t* __restrict oldSortedIndices = sortedIndices;
-		sortedIndices = reinterpret_cast<uint16_t*>(keys);
-		for (uint32_t i = 0; i < numIndices; ++i)
-			sortedIndices[i] = uint16_t(indices[oldSortedIndices[i]]);
-	}
-
 	// calculate the number of buckets we need to search forward
-	const Simd4i data = intFloor(gridScale * mCollisionDistance); //equal to or larger than floor(mCollisionDistance)
-	uint32_t collisionDistance = 2 + static_cast<uint32_t>(array(data)[sweepAxis]);
+	int32_t data[4];
+	store(data, intFloor(gridScale * mCollisionDistance)); //equal to or larger than floor(mCollisionDistance)
+	uint32_t collisionDistance = 2 + static_cast<uint32_t>(data[sweepAxis]);
 
-	// collide particles
-	if (mClothData.mRestPositions)
-		collideParticles<true>(sortedKeys, firstColumnSize, sortedIndices, collisionDistance);
+	if (use32BitIndices(numIndices, mClothData.mNumParticles))
+		sortAndCollideParticles<uint32_t>(keys, collisionDistance);
 	else
-		collideParticles<false>(sortedKeys, firstColumnSize, sortedIndices, collisionDistance);
+		sortAndCollideParticles<uint16_t>(keys, collisionDistance);
 
 	mAllocator.deallocate(buffer);
 
@@ -271,20 +253,63 @@ void cloth::SwSelfCollision<T4f>::operator()()
 	*/
 }
 
+template <typename T4f>
+template <typename IndexT>
+void cloth::SwSelfCollision<T4f>::sortAndCollideParticles(uint32_t* keys, uint32_t collisionDistance)
+{
+	uint32_t numIndices = mClothData.mNumSelfCollisionIndices;
+
+	const uint32_t* __restrict indices = mClothData.mSelfCollisionIndices;
+	IndexT* __restrict sortedIndices = reinterpret_cast<IndexT*>(keys + numIndices);
+	uint32_t* __restrict sortedKeys = reinterpret_cast<uint32_t*>(sortedIndices + align2(numIndices));
+
+	// compute sorted key indices
+	radixSort(keys, keys + numIndices, sortedIndices);
+
+	// snoop histogram: offset of first index with 8 msb > 1 (0 is sentinel)
+	// sortedIndices[2 * numIndices + 768 + 1] is actually histograms[3]+1 from radixSort
+	uint32_t firstColumnSize = sortedIndices[2 * numIndices + 768 + 1];
+
+	// sort keys using the sortedIndices
+	for (uint32_t i = 0; i < numIndices; ++i)
+		sortedKeys[i] = keys[sortedIndices[i]];
+	sortedKeys[numIndices] = uint32_t(-1); // sentinel
+
+	// do user provided index array indirection here if we have one
+	//  so we don't need to keep branching for this condition later
+	if (indices)
+	{
+		// sort indices (into no-longer-needed keys array)
+		// the keys array is no longer used so we can reuse it to store indices[sortedIndices[i]]
+		const IndexT* __restrict oldSortedIndices = sortedIndices;
+		sortedIndices = reinterpret_cast<IndexT*>(keys);
+		for (uint32_t i = 0; i < numIndices; ++i)
+			sortedIndices[i] = IndexT(indices[oldSortedIndices[i]]);
+	}
+
+	// collide particles
+	if (mClothData.mRestPositions)
+		collideParticles<true>(sortedKeys, firstColumnSize, sortedIndices, collisionDistance);
+	else
+		collideParticles<false>(sortedKeys, firstColumnSize, sortedIndices, collisionDistance);
+}
+
 template <typename T4f>
 size_t cloth::SwSelfCollision<T4f>::estimateTemporaryMemory(const SwCloth& cloth)
 {
 	uint32_t numIndices =
 	    uint32_t(cloth.mSelfCollisionIndices.empty() ? cloth.mCurParticles.size() : cloth.mSelfCollisionIndices.size());
-	return isSelfCollisionEnabled(cloth) ? getBufferSize(numIndices) : 0;
+	uint32_t numParticles = uint32_t(cloth.mCurParticles.size());
+	return isSelfCollisionEnabled(cloth) ? getBufferSize(numIndices, numParticles) : 0;
 }
 
 template <typename T4f>
-size_t cloth::SwSelfCollision<T4f>::getBufferSize(uint32_t numIndices)
+size_t cloth::SwSelfCollision<T4f>::getBufferSize(uint32_t numIndices, uint32_t numParticles)
 {
+	uint32_t indexSize = use32BitIndices(numIndices, numParticles) ? sizeof(uint32_t) : sizeof(uint16_t);
 	uint32_t keysSize = numIndices * sizeof(uint32_t);
-	uint32_t indicesSize = align2(numIndices) * sizeof(uint16_t);
-	uint32_t radixSize = (numIndices + 1024) * sizeof(uint16_t);
+	uint32_t indicesSize = align2(numIndices) * indexSize;
+	uint32_t radixSize = (numIndices + 1024) * indexSize;
 	return keysSize + indicesSize + std::max(radixSize, keysSize + uint32_t(sizeof(uint32_t)));
 }
 
@@ -330,9 +355,9 @@ void cloth::SwSelfCollision<T4f>::collideParticles(T4f& pos0, T4f& pos1, const T
 }
 
 template <typename T4f>
-template <bool useRestParticles>
-void cloth::SwSelfCollision<T4f>::collideParticles(const uint32_t* keys, uint16_t firstColumnSize,
-                                                      const uint16_t* indices, uint32_t collisionDistance)
+template <bool useRestParticles, typename IndexT>
+void cloth::SwSelfCollision<T4f>::collideParticles(const uint32_t* keys, uint32_t firstColumnSize,
+                                                      const IndexT* indices, uint32_t collisionDistance)
 {
 	//keys is an array of bucket keys for the particles
 	//indices is an array of particle indices
@@ -403,11 +428,11 @@ void cloth::SwSelfCollision<T4f>::collideParticles(const uint32_t* keys, uint16_
 		}
 	}
 
-	const uint16_t* __restrict iIt = indices;
-	const uint16_t* __restrict iEnd = indices + mClothData.mNumSelfCollisionIndices;
+	const IndexT* __restrict iIt = indices;
+	const IndexT* __restrict iEnd = indices + mClothData.mNumSelfCollisionIndices;
 
-	const uint16_t* __restrict jIt;
-	const uint16_t* __restrict jEnd;
+	const IndexT* __restrict jIt;
+	const IndexT* __restrict jEnd;
 
 	//loop through all indices
 	for (; iIt < iEnd; ++iIt, ++kFirst[0])
@@ -58,13 +58,16 @@ class SwSelfCollision
 
   private:
 	SwSelfCollision& operator = (const SwSelfCollision&); // not implemented
-	static size_t getBufferSize(uint32_t);
+	static size_t getBufferSize(uint32_t numIndices, uint32_t numParticles);
+
+	template <typename IndexT>
+	void sortAndCollideParticles(uint32_t*, uint32_t);
 
 	template <bool useRestParticles>
 	void collideParticles(T4f&, T4f&, const T4f&, const T4f&);
 
-	template <bool useRestParticles>
-	void collideParticles(const uint32_t*, uint16_t, const uint16_t*, uint32_t);
+	template <bool useRestParticles, typename IndexT>
+	void collideParticles(const uint32_t*, uint32_t, const IndexT*, uint32_t);
 
 	T4f mCollisionDistance;
 	T4f mCollisionSquareDistance;
@@ -38,6 +38,9 @@
 #include "SwInterCollision.h"
 #include "ps/PsFPU.h"
 #include "ps/PsSort.h"
+#include "ps/PsTime.h"
+#include "NvCloth/ps/PsAtomic.h"
+#include <thread>
 
 using namespace physx;
 
@@ -45,25 +48,32 @@ namespace nv
 {
 namespace cloth
 {
-bool neonSolverKernel(SwCloth const&, SwClothData&, SwKernelAllocator&, IterationStateFactory&);
+bool neonSolverKernel(SwCloth const&, SwClothData&, SwKernelAllocator&, const IterationState<Simd4f>&);
 }
 }
 
 using namespace nv;
 using namespace cloth;
-#if NV_SIMD_SIMD
-typedef Simd4f Simd4fType;
-#else
-typedef Scalar4f Simd4fType;
-#endif
 
 cloth::SwSolver::SwSolver()
-: mInterCollisionDistance(0.0f)
+: mNumAwakeCloths(0)
+, mMinParticlesPerChunk(0)
+, mTargetChunkCount(0)
+, mNumPendingCloths(0)
+, mInterCollisionDistance(0.0f)
 , mInterCollisionStiffness(1.0f)
 , mInterCollisionIterations(1)
 , mInterCollisionFilter(nullptr)
+, mInterCollisionTime(0.0f)
+, mInterCollisionCost(0.0f)
 , mInterCollisionScratchMem(nullptr)
 , mInterCollisionScratchMemSize(0)
+, mFrameCount(0)
+, mNextUpdatePhase(0)
+, mSubmittedFrame(0)
+, mCompletedFrame(0)
+, mAsyncExecutor(nullptr)
+, mOutputBuffering(false)
 , mSimulateProfileEventData(nullptr)
 {
 }
@@ -79,22 +89,93 @@ cloth::SwSolver::~SwSolver()
 namespace
 {
 template <typename T>
-bool clothSizeGreater(const T& t0, const T& t1)
+struct ClothCostGreater
+{
+	explicit ClothCostGreater(const T* tasks) : mTasks(tasks)
+	{
+	}
+
+	// compares the cost per chunk, ties are broken by index to be deterministic
+	bool operator()(uint32_t i, uint32_t j) const
+	{
+		float iCost = mTasks[i].mCost / float(mTasks[i].mNumChunks);
+		float jCost = mTasks[j].mCost / float(mTasks[j].mNumChunks);
+		return iCost > jCost || (iCost == jCost && i < j);
+	}
+
+	const T* mTasks;
+};
+
+template <typename T>
+void sortCloths(ps::Array<uint32_t, nv::cloth::ps::NonTrackingAllocator>& cloths,
+                const ps::Array<T, nv::cloth::ps::NonTrackingAllocator>& tasks)
 {
-	return t0.mCloth->mCurParticles.size() > t1.mCloth->mCurParticles.size();
+	ps::sort(cloths.begin(), cloths.size(), ClothCostGreater<T>(tasks.begin()), nv::cloth::ps::NonTrackingAllocator());
 }
 
+// ties are broken by the first cloth to keep the chunks of a cloth adjacent
 template <typename T>
-void sortTasks(ps::Array<T, nv::cloth::ps::NonTrackingAllocator>& tasks)
+bool chunkCostGreater(const T& c0, const T& c1)
 {
-	ps::sort(tasks.begin(), tasks.size(), &clothSizeGreater<T>, nv::cloth::ps::NonTrackingAllocator());
+	return c0.mCost > c1.mCost || (c0.mCost == c1.mCost && c0.mFirst < c1.mFirst);
+}
+
+template <typename T>
+void sortChunks(ps::Array<T, nv::cloth::ps::NonTrackingAllocator>& chunks)
+{
+	ps::sort(chunks.begin(), chunks.size(), &chunkCostGreater<T>, nv::cloth::ps::NonTrackingAllocator());
+}
+
+// rough estimate of the time it takes to simulate the cloth for dt,
+// in units of the time it takes to integrate a particle
+float estimateCost(const SwCloth& cloth, float dt)
+{
+	const SwFabric& fabric = cloth.mFabric;
+
+	const uint32_t numParticles = cloth.mCurParticles.size();
+	const int numIterations = std::max(1, int(dt * cloth.mSolverFrequency + 0.5f));
+
+	// integration, motion and separation constraints
+	float cost = float(numParticles);
+
+	// distance constraints
+	cost += float(fabric.mIndices.size() + fabric.mIndices32.size()) * 0.5f;
+
+	if (cloth.mTetherConstraintLogStiffness != 0.0f)
+		cost += float(fabric.mTethers.size());
+
+	// shapes are collided against 4 particles at once, continuous collision about doubles the work
+	uint32_t numShapes = cloth.mStartCollisionSpheres.size() + cloth.mCapsuleIndices.size() +
+	                     cloth.mStartCollisionPlanes.size() + cloth.mStartCollisionTriangles.size() / 3;
+	cost += float(numParticles * numShapes) * (cloth.mEnableContinuousCollision ? 0.5f : 0.25f);
+
+	// trilinear distance field lookup, 8 gathered samples per particle
+	if (!cloth.mDistanceField.empty())
+		cost += 2.0f * float(numParticles);
+
+	// bilinear heightfield lookup, 4 gathered samples per particle
+	if (!cloth.mHeightfield.empty())
+		cost += float(numParticles);
+
+	// grid build, sort, and neighbor search
+	if (cloth.mSelfCollisionDistance > 0.0f)
+	{
+		uint32_t numSelfCollisionParticles =
+		    cloth.mSelfCollisionIndices.empty() ? numParticles : cloth.mSelfCollisionIndices.size();
+		cost += 4.0f * float(numSelfCollisionParticles);
+	}
+
+	if (cloth.mDragLogCoefficient != 0.0f || cloth.mLiftLogCoefficient != 0.0f)
+		cost += float(fabric.getNumTriangles());
+
+	return float(numIterations) * cost;
 }
 }
 
 void cloth::SwSolver::addCloth(Cloth* cloth)
 {
 	addClothAppend(cloth);
-	sortTasks(mSimulatedCloths);
+	updateChunks();
 }
 
 void cloth::SwSolver::addCloths(Range<Cloth*> cloths)
@@ -103,7 +184,7 @@ void cloth::SwSolver::addCloths(Range<Cloth*> cloths)
 	{
 		addClothAppend(*(cloths.begin() + i));
 	}
-	sortTasks(mSimulatedCloths);
+	updateChunks();
 }
 
 void cloth::SwSolver::removeCloth(Cloth* cloth)
@@ -119,9 +200,10 @@ void cloth::SwSolver::removeCloth(Cloth* cloth)
 
 		if(tIt != tEnd)
 		{
+			swCloth.mSolver = NULL;
 			NV_CLOTH_FREE(tIt->mScratchMemory);
 			mSimulatedCloths.replaceWithLast(tIt);
-			sortTasks(mSimulatedCloths);
+			updateChunks();
 		}
 	}
 
@@ -154,27 +236,255 @@ bool cloth::SwSolver::beginSimulation(float dt)
 	if (mSimulatedCloths.empty())
 		return false;
 
-	mCurrentDt = dt;
 	beginFrame();
 
+	for (uint32_t i = 0; i < mSimulatedCloths.size(); ++i)
+	{
+		// sleeping cloths don't accumulate time to catch up on when woken
+		SimulatedCloth& cloth = mSimulatedCloths[i];
+		cloth.mIsAwake = !cloth.mCloth->isSleeping();
+		cloth.mDt = cloth.mIsAwake ? cloth.mDt + dt : 0.0f;
+	}
+
+	// the chunks were built by endSimulation() or notifyWakeUp(), callers may have read the chunk count already
+	updateCosts();
+	updateChunkCosts();
+
+	for (uint32_t i = 0; i < mSimulatedCloths.size(); ++i)
+		mSimulatedCloths[i].mScheduler.reset();
+
+	mInterCollisionScheduler.reset();
+	mNumPendingCloths = int32_t(mNumAwakeCloths);
+
 	return true;
 }
 void cloth::SwSolver::simulateChunk(int idx)
 {
 	NV_CLOTH_ASSERT(!mSimulatedCloths.empty());
-	mSimulatedCloths[idx].Simulate();
-	mSimulatedCloths[idx].Destroy();
+
+	ps::SIMDGuard simdGuard;
+
+	if (uint32_t(idx) < mChunks.size())
+	{
+		const Chunk& chunk = mChunks[idx];
+		for (uint32_t i = 0; i < chunk.mNumCloths; ++i)
+			simulateCloth(mSimulatedCloths[mChunkCloths[chunk.mFirst + i]]);
+		return;
+	}
+
+	// inter-collision chunk: inter-collision can't start before all cloths
+	// are done, so help with the cloths first instead of waiting for them
+	for (uint32_t i = 0; i < mChunkCloths.size(); ++i)
+		simulateCloth(mSimulatedCloths[mChunkCloths[i]]);
+
+	mInterCollisionScheduler.help();
+}
+void cloth::SwSolver::simulateCloth(SimulatedCloth& cloth)
+{
+	// the first chunk of a cloth to arrive simulates it, the others help out if the
+	// cloth is split up. unsplit cloths have no work to share, so move on to the next one
+	if (!cloth.mScheduler.acquire())
+	{
+		if (cloth.mNumChunks > 1)
+			cloth.mScheduler.help();
+		return;
+	}
+
+	// cloth may have been put to sleep since the chunks were built
+	if (!cloth.mCloth->isSleeping())
+		cloth.Simulate();
+
+	cloth.mScheduler.release();
+	cloth.Destroy();
+
+	// the chunk finishing the last cloth runs inter-collision
+	if (!ps::atomicDecrement(&mNumPendingCloths) && mInterCollisionScheduler.acquire())
+	{
+		interCollision();
+		mInterCollisionScheduler.release();
+	}
 }
 void cloth::SwSolver::endSimulation()
 {
 	NV_CLOTH_ASSERT(!mSimulatedCloths.empty());
-	interCollision();
+
+	// only left to do if there were no awake cloths to simulate
+	if (mInterCollisionScheduler.acquire())
+	{
+		interCollision();
+		mInterCollisionScheduler.release();
+	}
+
+	bool interCollisionEnabled = isInterCollisionEnabled();
+	for (uint32_t i = 0; i < mSimulatedCloths.size(); ++i)
+	{
+		SimulatedCloth& cloth = mSimulatedCloths[i];
+		if (cloth.isUpdateFrame(mFrameCount))
+			cloth.mDt = 0.0f;
+
+		// sleeping cloths keep their snapshot, unless still interpolated or inter-collision moved their particles
+		if (mOutputBuffering && (cloth.mIsAwake || !cloth.mStartParticles.empty() || interCollisionEnabled))
+			publishParticles(cloth);
+	}
+
+	++mFrameCount;
+
+	// drop cloths that went to sleep this frame
+	updateChunks();
+
 	endFrame();
 }
 
+void cloth::SwSolver::publishParticles(SimulatedCloth& cloth)
+{
+	// frames since the last update, the last frame of the interval publishes the update itself
+	uint32_t frame = (mFrameCount + cloth.mUpdatePhase) % cloth.mUpdateInterval;
+
+	if (cloth.mStartParticles.empty())
+	{
+		cloth.mCloth->publishParticles();
+	}
+	else if (frame + 1 < cloth.mUpdateInterval)
+	{
+		float t = float(frame + 1) / float(cloth.mUpdateInterval);
+		cloth.mCloth->publishParticles(cloth.mStartParticles.begin(), t);
+	}
+	else
+	{
+		cloth.mCloth->publishParticles();
+		cloth.mStartParticles.resize(0);
+	}
+}
+
+uint32_t cloth::SwSolver::simulateAsync(float dt, Executor& executor)
+{
+	NV_CLOTH_ASSERT(isSimulationComplete(mSubmittedFrame));
+
+	if (!beginSimulation(dt))
+		return 0;
+
+	// skip 0, which is returned if there is nothing to simulate
+	if (!++mSubmittedFrame)
+		++mSubmittedFrame;
+
+	mAsyncExecutor = &executor;
+	executor.submit(&simulateFrameTask, this);
+
+	return mSubmittedFrame;
+}
+
+void cloth::SwSolver::simulateFrameTask(void* solver, uint32_t)
+{
+	SwSolver* self = static_cast<SwSolver*>(solver);
+	self->mAsyncExecutor->parallelFor(&simulateChunkTask, solver, uint32_t(self->getSimulationChunkCount()));
+	self->endSimulation();
+	self->mCompletedFrame.store(self->mSubmittedFrame, std::memory_order_release);
+}
+
+bool cloth::SwSolver::isSimulationComplete(uint32_t fence) const
+{
+	// only the last submitted frame can still be running
+	return !fence || fence != mSubmittedFrame || mCompletedFrame.load(std::memory_order_acquire) == fence;
+}
+
+void cloth::SwSolver::waitForSimulation(uint32_t fence)
+{
+	while (!isSimulationComplete(fence))
+	{
+		if (!mAsyncExecutor->runPendingTask())
+			std::this_thread::yield();
+	}
+}
+
+void cloth::SwSolver::enableOutputBuffering(bool enable)
+{
+	NV_CLOTH_ASSERT(isSimulationComplete(mSubmittedFrame));
+
+	mOutputBuffering = enable;
+	for (uint32_t i = 0; i < mCloths.size(); ++i)
+	{
+		if (enable)
+			mCloths[i]->publishParticles();
+		else
+			mCloths[i]->clearPublishedParticles();
+	}
+}
+
 int cloth::SwSolver::getSimulationChunkCount() const
 {
-	return static_cast<int>(mSimulatedCloths.size());
+	// one inter-collision chunk for every cloth chunk
+	uint32_t numInterCollisionChunks = isInterCollisionEnabled() ? mChunks.size() : 0;
+	return static_cast<int>(mChunks.size() + numInterCollisionChunks);
+}
+
+float cloth::SwSolver::getSimulationChunkCost(int idx) const
+{
+	if (uint32_t(idx) < mChunks.size())
+		return mChunks[idx].mCost;
+
+	// inter-collision chunks share the inter-collision work
+	return mInterCollisionCost / float(mChunks.size());
+}
+
+void cloth::SwSolver::setMinParticlesPerChunk(uint32_t numParticles)
+{
+	mMinParticlesPerChunk = numParticles;
+	updateChunks();
+}
+
+void cloth::SwSolver::setTargetSimulationChunkCount(uint32_t count)
+{
+	mTargetChunkCount = count;
+	updateChunks();
+}
+
+void cloth::SwSolver::setClothUpdateInterval(Cloth& cloth, uint32_t interval)
+{
+	uint32_t index = findSimulatedCloth(cloth);
+	NV_CLOTH_ASSERT(index < mSimulatedCloths.size());
+	NV_CLOTH_ASSERT(isSimulationComplete(mSubmittedFrame));
+	if (index == mSimulatedCloths.size())
+		return;
+
+	SimulatedCloth& simulatedCloth = mSimulatedCloths[index];
+	interval = std::max(1u, interval);
+	if (interval == simulatedCloth.mUpdateInterval)
+		return;
+
+	// stagger the updates of cloths with the same interval
+	simulatedCloth.mUpdateInterval = interval;
+	simulatedCloth.mUpdatePhase = mNextUpdatePhase++;
+	simulatedCloth.mStartParticles.reset();
+
+	updateChunks();
+}
+
+uint32_t cloth::SwSolver::getClothUpdateInterval(const Cloth& cloth) const
+{
+	uint32_t index = findSimulatedCloth(cloth);
+	return index < mSimulatedCloths.size() ? mSimulatedCloths[index].mUpdateInterval : 1;
+}
+
+float cloth::SwSolver::getClothSimulationTime(const Cloth& cloth) const
+{
+	uint32_t index = findSimulatedCloth(cloth);
+	if (index == mSimulatedCloths.size())
+		return 0.0f;
+
+	return mSimulatedCloths[index].mMeasuredTime * 1000.0f / float(ps::getCounterFrequency());
+}
+
+uint32_t cloth::SwSolver::findSimulatedCloth(const Cloth& cloth) const
+{
+	uint32_t i = 0;
+	while (i < mSimulatedCloths.size() && mSimulatedCloths[i].mCloth != &cloth)
+		++i;
+	return i;
+}
+
+bool cloth::SwSolver::isInterCollisionEnabled() const
+{
+	return mInterCollisionIterations && mInterCollisionDistance != 0.0f && mInterCollisionFilter != nullptr;
 }
 
 void cloth::SwSolver::interCollision()
@@ -218,12 +528,16 @@ void cloth::SwSolver::interCollision()
 
 	SwKernelAllocator allocator(mInterCollisionScratchMem, mInterCollisionScratchMemSize);
 
+	uint64_t startTime = ps::getCurrentCounterValue();
+
 	// run inter-collision
 	SwInterCollision<Simd4fType> collider(mInterCollisionInstances.begin(), mInterCollisionInstances.size(),
 	                                      mInterCollisionDistance, mInterCollisionStiffness, mInterCollisionIterations,
-	                                      mInterCollisionFilter, allocator);
+	                                      mInterCollisionFilter, allocator, &mInterCollisionScheduler);
 
 	collider();
+
+	mInterCollisionTime = float(ps::getCurrentCounterValue() - startTime);
 }
 
 void cloth::SwSolver::addClothAppend(Cloth* cloth)
@@ -232,10 +546,111 @@ void cloth::SwSolver::addClothAppend(Cloth* cloth)
 	NV_CLOTH_ASSERT(mCloths.find(&swCloth) == mCloths.end());
 
 	mSimulatedCloths.pushBack(SimulatedCloth(swCloth, this));
+	swCloth.mSolver = this;
+
+	if (mOutputBuffering)
+		swCloth.publishParticles();
 
 	mCloths.pushBack(&swCloth);
 }
 
+void cloth::SwSolver::notifyWakeUp()
+{
+	// the chunk count has to be final before beginSimulation()
+	updateChunks();
+}
+
+void cloth::SwSolver::updateChunks()
+{
+	mChunks.resize(0);
+	mChunkCloths.resize(0);
+
+	float totalCost = 0.0f;
+	for (uint32_t i = 0; i < mSimulatedCloths.size(); ++i)
+	{
+		SimulatedCloth& cloth = mSimulatedCloths[i];
+		if (cloth.mCloth->isSleeping() || !cloth.isUpdateFrame(mFrameCount))
+			continue;
+
+		uint32_t numParticles = cloth.mCloth->mCurParticles.size();
+		cloth.mNumChunks = mMinParticlesPerChunk ? std::max(1u, numParticles / mMinParticlesPerChunk) : 1;
+
+		mChunkCloths.pushBack(i);
+		totalCost += cloth.mCost;
+	}
+	mNumAwakeCloths = mChunkCloths.size();
+
+	// most expensive cloths first
+	sortCloths(mChunkCloths, mSimulatedCloths);
+
+	// cloths cheaper than the target cost share a chunk with the next cheaper ones
+	float targetCost = mTargetChunkCount ? totalCost / float(mTargetChunkCount) : 0.0f;
+
+	for (uint32_t i = 0, n = mChunkCloths.size(); i < n;)
+	{
+		const SimulatedCloth& cloth = mSimulatedCloths[mChunkCloths[i]];
+		Chunk chunk = { i++, 1, cloth.mCost / float(cloth.mNumChunks) };
+
+		// keep chunks of a cloth adjacent so they are likely to run at the same time
+		if (cloth.mNumChunks > 1)
+		{
+			for (uint32_t j = 0; j < cloth.mNumChunks; ++j)
+				mChunks.pushBack(chunk);
+			continue;
+		}
+
+		for (; i < n && chunk.mCost < targetCost && mSimulatedCloths[mChunkCloths[i]].mNumChunks == 1; ++i)
+		{
+			chunk.mCost += mSimulatedCloths[mChunkCloths[i]].mCost;
+			++chunk.mNumCloths;
+		}
+
+		mChunks.pushBack(chunk);
+	}
+
+	// start the most expensive chunks first
+	sortChunks(mChunks);
+}
+
+void cloth::SwSolver::updateChunkCosts()
+{
+	for (uint32_t i = 0; i < mChunks.size(); ++i)
+	{
+		Chunk& chunk = mChunks[i];
+		const SimulatedCloth& cloth = mSimulatedCloths[mChunkCloths[chunk.mFirst]];
+		chunk.mCost = cloth.mCost / float(cloth.mNumChunks);
+		for (uint32_t j = 1; j < chunk.mNumCloths; ++j)
+			chunk.mCost += mSimulatedCloths[mChunkCloths[chunk.mFirst + j]].mCost;
+	}
+
+	sortChunks(mChunks);
+}
+
+void cloth::SwSolver::updateCosts()
+{
+	// average measured time per unit of estimated cost
+	float measuredTime = 0.0f, measuredCost = 0.0f;
+	for (uint32_t i = 0; i < mSimulatedCloths.size(); ++i)
+	{
+		measuredTime += mSimulatedCloths[i].mMeasuredTime;
+		measuredCost += mSimulatedCloths[i].mMeasuredCost;
+	}
+	float timePerCost = measuredCost > 0.0f ? measuredTime / measuredCost : 0.0f;
+
+	for (uint32_t i = 0; i < mSimulatedCloths.size(); ++i)
+	{
+		SimulatedCloth& cloth = mSimulatedCloths[i];
+		cloth.mEstimatedCost = estimateCost(*cloth.mCloth, cloth.mDt / float(cloth.mUpdateInterval));
+
+		// correct by how much faster or slower than average the cloth was the last time
+		cloth.mCost = cloth.mEstimatedCost;
+		if (cloth.mMeasuredCost > 0.0f && cloth.mMeasuredTime > 0.0f)
+			cloth.mCost *= cloth.mMeasuredTime / (cloth.mMeasuredCost * timePerCost);
+	}
+
+	mInterCollisionCost = timePerCost > 0.0f ? mInterCollisionTime / timePerCost : 0.0f;
+}
+
 void cloth::SwSolver::beginFrame() const
 {
 	mSimulateProfileEventData = NV_CLOTH_PROFILE_START_CROSSTHREAD("cloth::SwSolver::simulate", 0);
@@ -247,7 +662,9 @@ void cloth::SwSolver::endFrame() const
 }
 
 cloth::SwSolver::SimulatedCloth::SimulatedCloth(SwCloth& cloth, SwSolver* parent)
-	: mCloth(&cloth), mScratchMemorySize(0), mScratchMemory(0), mInvNumIterations(0.0f), mParent(parent)
+	: mCloth(&cloth), mScratchMemorySize(0), mScratchMemory(0), mInvNumIterations(0.0f), mEstimatedCost(0.0f), mCost(0.0f)
+	, mMeasuredTime(0.0f), mMeasuredCost(0.0f), mNumChunks(1), mUpdateInterval(1), mUpdatePhase(0), mDt(0.0f)
+	, mIsAwake(false), mParent(parent)
 {
 
 }
@@ -274,6 +691,9 @@ void cloth::SwSolver::SimulatedCloth::Destroy()
 		swap(mCloth->mStartCollisionTriangles, mCloth->mTargetCollisionTriangles);
 		mCloth->mTargetCollisionTriangles.resize(0);
 	}
+
+	mCloth->mStartDistanceFieldPose = mCloth->mTargetDistanceFieldPose;
+	mCloth->mStartHeightfieldPose = mCloth->mTargetHeightfieldPose;
 }
 void cloth::SwSolver::SimulatedCloth::Simulate()
 {
@@ -289,27 +709,39 @@ void cloth::SwSolver::SimulatedCloth::Simulate()
 		mScratchMemorySize = requiredTempMemorySize;
 	}
 
-	if (mParent->mCurrentDt == 0.0f)
+	if (mDt == 0.0f)
 		return;
 
-	IterationStateFactory factory(*mCloth, mParent->mCurrentDt);
-	mInvNumIterations = factory.mInvNumIterations;
+	uint64_t startTime = ps::getCurrentCounterValue();
 
-	ps::SIMDGuard simdGuard;
+	// keep the particles before the update to interpolate the published particles from
+	if (mParent->mOutputBuffering && mUpdateInterval > 1)
+	{
+		mStartParticles.assign(mCloth->mCurParticles.begin(), mCloth->mCurParticles.end());
+	}
+
+	// the skipped frames are caught up with larger iterations, not more of them
+	IterationStateFactory factory(*mCloth, mDt, mUpdateInterval);
+	mInvNumIterations = factory.mInvNumIterations;
+	const IterationState<Simd4fType>& state = mIterationState.get(factory, *mCloth);
 
 	SwClothData data(*mCloth, mCloth->mFabric);
 	SwKernelAllocator allocator(mScratchMemory, uint32_t(mScratchMemorySize));
 
 	// construct kernel functor and execute
 #if NV_ANDROID
-	if (!neonSolverKernel(*mCloth, data, allocator, factory))
+	if (!neonSolverKernel(*mCloth, data, allocator, state))
 	{
 		//NV_CLOTH_LOG_WARNING("No NEON CPU support detected. Falling back to scalar types.");
-		SwSolverKernel<Scalar4f>(*mCloth, data, allocator, factory)();
+		SwSolverKernel<Scalar4f>(*mCloth, data, allocator, factory.create<Scalar4f>(*mCloth))();
 	}
 #else
-	SwSolverKernel<Simd4fType>(*mCloth, data, allocator, factory)();
+	SwSolverKernel<Simd4fType>(*mCloth, data, allocator, state, mNumChunks > 1 ? &mScheduler : NULL)();
 #endif
 
 	data.reconcile(*mCloth); // update cloth
+
+	// helping chunks share the work, so count the time once per chunk
+	mMeasuredTime = float(ps::getCurrentCounterValue() - startTime) * float(mNumChunks);
+	mMeasuredCost = mEstimatedCost;
 }
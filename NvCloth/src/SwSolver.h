@@ -31,6 +31,9 @@
 
 #include "NvCloth/Solver.h"
 #include "SwInterCollision.h"
+#include "SwKernelScheduler.h"
+#include "IterationState.h"
+#include <atomic>
 
 namespace nv
 {
@@ -44,17 +47,53 @@ class SwFactory;
 /// CPU/SSE based cloth solver
 class SwSolver : public Solver
 {
+#if NV_SIMD_SIMD
+	typedef Simd4f Simd4fType;
+#else
+	typedef Scalar4f Simd4fType;
+#endif
+
 	struct SimulatedCloth
 	{
 		SimulatedCloth(SwCloth& cloth, SwSolver* parent);
 		void Destroy();
 		void Simulate();
 
+		// true if the cloth is updated this frame, false if the frame is interpolated
+		bool isUpdateFrame(uint32_t frame) const
+		{
+			return (frame + mUpdatePhase) % mUpdateInterval == 0;
+		}
+
 		SwCloth* mCloth;
 		uint32_t mScratchMemorySize;
 		void* mScratchMemory;
 		float mInvNumIterations;
 
+		// iteration state of the last frame, reused if dt and the cloth motion and parameters are unchanged
+		IterationStateCache<Simd4fType> mIterationState;
+
+		// estimated cost of the current frame, and the estimate corrected with the measured timings
+		float mEstimatedCost;
+		float mCost;
+
+		// measured time and estimated cost of the last simulated frame, zero if never simulated
+		float mMeasuredTime;
+		float mMeasuredCost;
+
+		// shares the kernel work with the other chunks of this cloth
+		SwKernelScheduler mScheduler;
+		uint32_t mNumChunks;
+
+		// simulated every mUpdateInterval frames with the delta time accumulated since the last update
+		uint32_t mUpdateInterval;
+		uint32_t mUpdatePhase;
+		float mDt;
+		bool mIsAwake; // at the start of the frame
+
+		// particles before the last update, the published particles are interpolated from them
+		Vector<physx::PxVec4>::Type mStartParticles;
+
 		SwSolver* mParent;
 	};
 	friend struct SimulatedCloth;
@@ -74,6 +113,17 @@ class SwSolver : public Solver
 	virtual void simulateChunk(int idx) override;
 	virtual void endSimulation() override;
 	virtual int getSimulationChunkCount() const override;
+	virtual float getSimulationChunkCost(int idx) const override;
+
+	virtual uint32_t simulateAsync(float dt, Executor& executor) override;
+	virtual bool isSimulationComplete(uint32_t fence) const override;
+	virtual void waitForSimulation(uint32_t fence) override;
+
+	virtual void enableOutputBuffering(bool enable) override;
+	virtual bool isOutputBufferingEnabled() const override
+	{
+		return mOutputBuffering;
+	}
 
 	virtual void setInterCollisionDistance(float distance) override
 	{
@@ -107,19 +157,61 @@ class SwSolver : public Solver
 		mInterCollisionFilter = filter;
 	}
 
+	virtual void setMinParticlesPerChunk(uint32_t numParticles) override;
+	virtual uint32_t getMinParticlesPerChunk() const override
+	{
+		return mMinParticlesPerChunk;
+	}
+
+	virtual void setTargetSimulationChunkCount(uint32_t count) override;
+	virtual uint32_t getTargetSimulationChunkCount() const override
+	{
+		return mTargetChunkCount;
+	}
+
+	virtual void setClothUpdateInterval(Cloth& cloth, uint32_t interval) override;
+	virtual uint32_t getClothUpdateInterval(const Cloth& cloth) const override;
+	virtual float getClothSimulationTime(const Cloth& cloth) const override;
+
 	virtual bool hasError() const override
 	{
 		return false;
 	}
 
+	// re-adds a sleeping cloth to the simulated chunks
+	void notifyWakeUp();
+
   private:
 	// add cloth helper functions
 	void addClothAppend(Cloth* cloth);
 
+	// rebuild the chunk to cloth mapping, skipping sleeping cloths
+	// and grouping cheap cloths to approach the target chunk count
+	void updateChunks();
+
+	// estimate the cost of each cloth for the current frame
+	void updateCosts();
+
+	// re-derive the chunk costs from updated cloth costs and reorder the chunks, keeps the chunk count
+	void updateChunkCosts();
+
+	// simulates the cloth if no other chunk does yet, otherwise helps out
+	void simulateCloth(SimulatedCloth& cloth);
+
+	// publishes the particles of the cloth, interpolated between updates
+	void publishParticles(SimulatedCloth& cloth);
+
+	// returns the index into mSimulatedCloths, or its size if the cloth is not in this solver
+	uint32_t findSimulatedCloth(const Cloth& cloth) const;
+
 	// simulate helper functions
 	void beginFrame() const;
 	void endFrame() const;
 
+	// runs the chunks and endSimulation() of a frame started by simulateAsync()
+	static void simulateFrameTask(void* solver, uint32_t);
+
+	bool isInterCollisionEnabled() const;
 	void interCollision();
 
   private:
@@ -127,17 +219,49 @@ class SwSolver : public Solver
 	typedef Vector<SwCloth*>::Type ClothVector;
 	ClothVector mCloths;
 
-	
+	// run of cloths in mChunkCloths simulated by one chunk,
+	// a cloth split into several chunks is referenced by each of them
+	struct Chunk
+	{
+		uint32_t mFirst;
+		uint32_t mNumCloths;
+		float mCost;
+	};
+
+	Vector<Chunk>::Type mChunks;
+	Vector<uint32_t>::Type mChunkCloths; // index into mSimulatedCloths of the awake cloths updated this frame
+	uint32_t mNumAwakeCloths;
+	uint32_t mMinParticlesPerChunk;
+	uint32_t mTargetChunkCount;
+
+	// inter-collision is started by the chunk finishing the last cloth,
+	// the chunks following the cloth chunks share its work
+	SwKernelScheduler mInterCollisionScheduler;
+	volatile int32_t mNumPendingCloths;
+
 	float mInterCollisionDistance;
 	float mInterCollisionStiffness;
 	uint32_t mInterCollisionIterations;
 	InterCollisionFilter mInterCollisionFilter;
 
+	// measured time of the last inter-collision, and converted to units of estimated cost
+	float mInterCollisionTime;
+	float mInterCollisionCost;
+
 	void* mInterCollisionScratchMem;
 	uint32_t mInterCollisionScratchMemSize;
 	Vector<SwInterCollisionData>::Type mInterCollisionInstances;
 
-	float mCurrentDt; //The delta time for the current simulated frame
+	// frames simulated so far, and the stagger of the next cloth given an update interval
+	uint32_t mFrameCount;
+	uint32_t mNextUpdatePhase;
+
+	// fences of the last frame started by simulateAsync() and the last one completed
+	uint32_t mSubmittedFrame;
+	std::atomic<uint32_t> mCompletedFrame;
+	Executor* mAsyncExecutor;
+
+	bool mOutputBuffering;
 
 	mutable void* mSimulateProfileEventData;
 };
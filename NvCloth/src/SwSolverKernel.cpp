@@ -32,17 +32,21 @@
 #include "SwClothData.h"
 #include "SwFabric.h"
 #include "SwFactory.h"
+#include "SwKernelScheduler.h"
 #include "PointInterpolator.h"
 #include "BoundingBox.h"
 #include <foundation/PxProfiler.h>
 
 using namespace physx;
 
-#define NV_AVX (NV_SIMD_SIMD&&(PX_WIN32 || PX_WIN64) && PX_VC >= 10)
 #ifdef _MSC_VER 
 #pragma warning(disable : 4127) // conditional expression is constant
 #endif
 
+#if NV_AVX && PX_GCC_FAMILY
+#include <cpuid.h>
+#endif
+
 #if NV_AVX
 namespace avx
 {
@@ -50,11 +54,22 @@ namespace avx
 
 void initialize();
 
-template <bool, uint32_t>
+template <bool, uint32_t, typename IndexT>
 void solveConstraints(float* __restrict posIt, const float* __restrict rIt, const float* __restrict stIt, const float* __restrict rEnd,
-                      const uint16_t* __restrict iIt, const __m128& stiffnessEtc, const __m128& stiffnessExponent);
+                      const IndexT* __restrict iIt, const __m128& stiffnessEtc);
 }
 
+#if NV_AVX512
+namespace avx512
+{
+// defined in SwSolveConstraintsAvx512.cpp
+
+template <bool, typename IndexT>
+void solveConstraints(float* __restrict posIt, const float* __restrict rIt, const float* __restrict stIt, const float* __restrict rEnd,
+                      const IndexT* __restrict iIt, const __m128& stiffnessEtc);
+}
+#endif
+
 namespace
 {
 uint32_t getAvxSupport()
@@ -64,7 +79,38 @@ uint32_t getAvxSupport()
 // 2) CPUID indicates support for AVX
 // 3) XGETBV indicates registers are saved and restored on context switch
 
-#if _MSC_FULL_VER < 160040219 || !defined(_XCR_XFEATURE_ENABLED_MASK)
+#if PX_GCC_FAMILY
+	unsigned int cpuInfo[4];
+	if (!__get_cpuid(1, &cpuInfo[0], &cpuInfo[1], &cpuInfo[2], &cpuInfo[3]))
+		return 0;
+	unsigned int avxFlags = 3 << 27; // checking 1) and 2) above
+	if ((cpuInfo[2] & avxFlags) != avxFlags)
+		return 0; // xgetbv not enabled or no AVX support
+
+	unsigned int xcr0, xcr0Hi;
+	__asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0Hi) : "c"(0));
+	if ((xcr0 & 0x6) != 0x6)
+		return 0; // OS does not save YMM registers
+
+	avx::initialize();
+
+	unsigned int fmaFlags = 1 << 12;
+	if ((cpuInfo[2] & fmaFlags) != fmaFlags)
+		return 1; // no FMA3 support
+
+	// exp2<2>() uses avx2 integer instructions
+	if (!__get_cpuid_count(7, 0, &cpuInfo[0], &cpuInfo[1], &cpuInfo[2], &cpuInfo[3]))
+		return 1;
+	unsigned int avx2Flags = 1 << 5;
+	if ((cpuInfo[1] & avx2Flags) != avx2Flags)
+		return 1; // no AVX2 support
+
+	unsigned int avx512Flags = 1 << 16;
+	if ((cpuInfo[1] & avx512Flags) != avx512Flags || (xcr0 & 0xe6) != 0xe6)
+		return 2; // no AVX-512F support, or OS does not save ZMM and mask registers
+
+	return 3;
+#elif _MSC_FULL_VER < 160040219 || !defined(_XCR_XFEATURE_ENABLED_MASK)
 	// need at least VC10 SP1 and compile on at least Win7 SP1
 	return 0;
 #else
@@ -86,25 +132,89 @@ uint32_t getAvxSupport()
 	if ((cpuInfo[2] & fmaFlags) != fmaFlags)
 		return 1; // no FMA3 support
 
-	/* only using fma at the moment, don't lock out AMD's piledriver by requiring avx2
-	__cpuid(cpuInfo, 7);
+	// exp2<2>() uses avx2 integer instructions
+	__cpuidex(cpuInfo, 7, 0);
 	int avx2Flags = 1 << 5;
 	if ((cpuInfo[1] & avx2Flags) != avx2Flags)
-	    return 1; // no AVX2 support
-	*/
+		return 1; // no AVX2 support
+
+#if NV_AVX512
+	int avx512Flags = 1 << 16;
+	if ((cpuInfo[1] & avx512Flags) != avx512Flags || (_xgetbv(_XCR_XFEATURE_ENABLED_MASK) & 0xe6) != 0xe6)
+		return 2; // no AVX-512F support, or OS does not save ZMM and mask registers
 
+	return 3;
+#else
 	return 2;
+#endif
 #endif // _MSC_VER
 #endif // _MSC_FULL_VER
 }
 
-const uint32_t sAvxSupport = getAvxSupport(); // 0: no AVX, 1: AVX, 2: AVX+FMA
+const uint32_t sAvxSupport = getAvxSupport(); // 0: no AVX, 1: AVX, 2: AVX2+FMA, 3: AVX-512F
 }
 #endif
 
 using namespace nv;
 using namespace cloth;
 
+#if NV_CLOTH_AVX_LAYOUT
+uint32_t cloth::getAvxConstraintWidth()
+{
+#if NV_AVX512
+	return sAvxSupport == 3 ? 16u : 8u;
+#else
+	return 8u;
+#endif
+}
+#endif
+
+#if NV_AVX
+namespace
+{
+// the AVX solvers take __m128 arguments, other T4f always use the generic solver
+template <typename T4f, typename IndexT>
+bool solveConstraintsAvx(bool, bool, float* __restrict, const float* __restrict, const float* __restrict,
+                         const float* __restrict, const IndexT* __restrict, const T4f&)
+{
+	return false;
+}
+
+template <typename IndexT>
+bool solveConstraintsAvx(bool independent, bool neutralMultiplier, float* __restrict pIt, const float* __restrict rIt,
+                         const float* __restrict stIt, const float* __restrict rEnd, const IndexT* __restrict iIt,
+                         const Simd4f& stiffness)
+{
+	switch(sAvxSupport)
+	{
+	case 3:
+#if NV_AVX512
+		// 16 constraints are solved at once, like the chunks of a split up set
+		if (independent)
+		{
+			neutralMultiplier ? avx512::solveConstraints<false>(pIt, rIt, stIt, rEnd, iIt, stiffness)
+			                  : avx512::solveConstraints<true>(pIt, rIt, stIt, rEnd, iIt, stiffness);
+			return true;
+		}
+#endif
+		// fall through
+	case 2:
+#if _MSC_VER >= 1700 || PX_GCC_FAMILY
+		neutralMultiplier ? avx::solveConstraints<false, 2>(pIt, rIt, stIt, rEnd, iIt, stiffness)
+		                  : avx::solveConstraints<true, 2>(pIt, rIt, stIt, rEnd, iIt, stiffness);
+		return true;
+#endif
+	case 1:
+		neutralMultiplier ? avx::solveConstraints<false, 1>(pIt, rIt, stIt, rEnd, iIt, stiffness)
+		                  : avx::solveConstraints<true, 1>(pIt, rIt, stIt, rEnd, iIt, stiffness);
+		return true;
+	default:
+		return false;
+	}
+}
+}
+#endif
+
 namespace
 {
 /* simd constants */
@@ -117,6 +227,10 @@ const Simd4fTupleFactory sMinusOneXYZOneW = simd4f(-1.0f, -1.0f, -1.0f, 1.0f);
 const Simd4fTupleFactory sFloatMaxW = simd4f(0.0f, 0.0f, 0.0f, FLT_MAX);
 const Simd4fTupleFactory sMinusFloatMaxXYZ = simd4f(-FLT_MAX, -FLT_MAX, -FLT_MAX, 0.0f);
 
+// batch sizes of loops shared with other chunks (multiples of the simd width)
+const uint32_t sParticleBatchSize = 256;
+const uint32_t sConstraintBatchSize = 512;
+
 /* static worker functions */
 
 /**
@@ -281,9 +395,9 @@ void constrainSeparation(T4f* __restrict curIt, const T4f* __restrict curEnd, co
 /**
     traditional gauss-seidel internal constraint solver
  */
-template <bool useMultiplier, typename T4f>
+template <bool useMultiplier, typename T4f, typename IndexT>
 void solveConstraints(float* __restrict posIt, const float* __restrict rIt, const float* __restrict stIt, const float* __restrict rEnd,
-                      const uint16_t* __restrict iIt, const T4f& stiffnessEtc, const T4f& stiffnessExponent)
+                      const IndexT* __restrict iIt, const T4f& stiffnessEtc)
 {
 	//posIt		particle position (and invMass) iterator
 	//rIt,rEnd	edge rest length iterator
@@ -337,8 +451,8 @@ void solveConstraints(float* __restrict posIt, const float* __restrict rIt, cons
 		//load rest lengths
 		T4f rij = loadAligned(rIt);
 
-		//Load/calculate the constraint stiffness
-		T4f stij = useStiffnessPerConstraint ? gSimd4fOne - exp2(stiffnessExponent * static_cast<T4f>(loadAligned(stIt))) : stiffness;
+		//Load the constraint stiffness
+		T4f stij = useStiffnessPerConstraint ? static_cast<T4f>(loadAligned(stIt)) : stiffness;
 
 		//squared distance between particles: e2 = epsilon + |h|^2
 		T4f e2ij = gSimd4fEpsilon + hxij * hxij + hyij * hyij + hzij * hzij;
@@ -388,10 +502,31 @@ T4f calculateMaxDelta(const T4f* prevIt, const T4f* curIt, const T4f* curEnd)
 	return maxDelta & sMaskXYZ;
 }
 
-template <bool IsTurning, typename T4f>
-void applyWind(T4f* __restrict curIt, const T4f* __restrict prevIt, const uint16_t* __restrict tIt,
-               const uint16_t* __restrict tEnd, float itrDtf, float dragCoefficientf, float liftCoefficientf, float fluidDensityf, T4f wind,
-               const T4f (&rotation)[3])
+// load one vertex of 4 triangles, transposed
+template <typename T4f, typename IndexT>
+void gatherVertices(const T4f* __restrict particles, const IndexT* __restrict tIt, T4f (&vertices)[4])
+{
+	vertices[0] = particles[tIt[0]];
+	vertices[1] = particles[tIt[3]];
+	vertices[2] = particles[tIt[6]];
+	vertices[3] = particles[tIt[9]];
+	transpose(vertices[0], vertices[1], vertices[2], vertices[3]);
+}
+
+template <typename T4f, typename IndexT>
+void scatterVertices(T4f* __restrict particles, const IndexT* __restrict tIt, T4f (&vertices)[4])
+{
+	transpose(vertices[0], vertices[1], vertices[2], vertices[3]);
+	particles[tIt[0]] = vertices[0];
+	particles[tIt[3]] = vertices[1];
+	particles[tIt[6]] = vertices[2];
+	particles[tIt[9]] = vertices[3];
+}
+
+template <bool IsTurning, typename T4f, typename IndexT>
+void applyWind(T4f* __restrict curIt, const T4f* __restrict prevIt, const IndexT* __restrict tIt,
+               const IndexT* __restrict tBatchEnd, const IndexT* __restrict tEnd, float itrDtf, float dragCoefficientf,
+               float liftCoefficientf, float fluidDensityf, T4f wind, const T4f (&rotation)[3])
 {
 	// Note: Enabling wind can amplify bad behavior since the impulse scales with area,
 	//  and the area of triangles increases when constraints are violated.
@@ -404,12 +539,105 @@ void applyWind(T4f* __restrict curIt, const T4f* __restrict prevIt, const uint16
 	const T4f itrDt = simd4f(itrDtf);
 	const T4f oneThird = simd4f(1.0f / 3.0f);
 
+	// same as the loop below for 4 triangles at a time, one triangle per simd lane.
+	// the triangles of a group don't share particles, so the order of the updates doesn't matter
+	const T4f windX = splat<0>(wind), windY = splat<1>(wind), windZ = splat<2>(wind);
+	for (; tIt < tBatchEnd; tIt += 12)
+	{
+		T4f c0[4], c1[4], c2[4];
+		gatherVertices(curIt, tIt + 0, c0);
+		gatherVertices(curIt, tIt + 1, c1);
+		gatherVertices(curIt, tIt + 2, c2);
+
+		T4f p0[4], p1[4], p2[4];
+		gatherVertices(prevIt, tIt + 0, p0);
+		gatherVertices(prevIt, tIt + 1, p1);
+		gatherVertices(prevIt, tIt + 2, p2);
+
+		T4f currentX = oneThird * (c0[0] + c1[0] + c2[0]);
+		T4f currentY = oneThird * (c0[1] + c1[1] + c2[1]);
+		T4f currentZ = oneThird * (c0[2] + c1[2] + c2[2]);
+
+		T4f previousX = oneThird * (p0[0] + p1[0] + p2[0]);
+		T4f previousY = oneThird * (p0[1] + p1[1] + p2[1]);
+		T4f previousZ = oneThird * (p0[2] + p1[2] + p2[2]);
+
+		T4f deltaX = currentX - previousX + windX;
+		T4f deltaY = currentY - previousY + windY;
+		T4f deltaZ = currentZ - previousZ + windZ;
+
+		if (IsTurning)
+		{
+			T4f x = deltaX - currentX, y = deltaY - currentY, z = deltaZ - currentZ;
+			deltaX = currentX + x * splat<0>(rotation[0]) + y * splat<0>(rotation[1]) + z * splat<0>(rotation[2]);
+			deltaY = currentY + x * splat<1>(rotation[0]) + y * splat<1>(rotation[1]) + z * splat<1>(rotation[2]);
+			deltaZ = currentZ + x * splat<2>(rotation[0]) + y * splat<2>(rotation[1]) + z * splat<2>(rotation[2]);
+		}
+
+		T4f edge0X = c2[0] - c0[0], edge0Y = c2[1] - c0[1], edge0Z = c2[2] - c0[2];
+		T4f edge1X = c1[0] - c0[0], edge1Y = c1[1] - c0[1], edge1Z = c1[2] - c0[2];
+		T4f normalX = edge0Y * edge1Z - edge0Z * edge1Y;
+		T4f normalY = edge0Z * edge1X - edge0X * edge1Z;
+		T4f normalZ = edge0X * edge1Y - edge0Y * edge1X;
+
+		T4f doubleArea = sqrt(normalX * normalX + normalY * normalY + normalZ * normalZ);
+		normalX = normalX / doubleArea;
+		normalY = normalY / doubleArea;
+		normalZ = normalZ / doubleArea;
+
+		T4f invSqrScale = deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ;
+		T4f isZero = invSqrScale < gSimd4fEpsilon;
+		T4f scale = rsqrt(invSqrScale);
+		T4f deltaLength = sqrt(invSqrScale);
+
+		T4f cosTheta = (normalX * deltaX + normalY * deltaY + normalZ * deltaZ) * scale;
+		T4f sinTheta = sqrt(max(gSimd4fZero, gSimd4fOne - cosTheta * cosTheta));
+
+		// liftDir = cross3(cross3(delta, normal), delta * scale)
+		T4f tX = deltaY * normalZ - deltaZ * normalY;
+		T4f tY = deltaZ * normalX - deltaX * normalZ;
+		T4f tZ = deltaX * normalY - deltaY * normalX;
+		T4f sX = deltaX * scale, sY = deltaY * scale, sZ = deltaZ * scale;
+		T4f liftDirX = tY * sZ - tZ * sY;
+		T4f liftDirY = tZ * sX - tX * sZ;
+		T4f liftDirZ = tX * sY - tY * sX;
+
+		// sin(theta) * cos(theta) = 0.5 * sin(2 * theta)
+		T4f lift = liftCoefficient * cosTheta * sinTheta;
+		T4f drag = dragCoefficient * abs(cosTheta);
+
+		T4f liftX = lift * liftDirX * deltaLength / itrDt;
+		T4f liftY = lift * liftDirY * deltaLength / itrDt;
+		T4f liftZ = lift * liftDirZ * deltaLength / itrDt;
+		T4f dragX = drag * deltaX * deltaLength / itrDt;
+		T4f dragY = drag * deltaY * deltaLength / itrDt;
+		T4f dragZ = drag * deltaZ * deltaLength / itrDt;
+
+		T4f impulseX = (dragX + liftX) * fluidDensity * doubleArea & ~isZero;
+		T4f impulseY = (dragY + liftY) * fluidDensity * doubleArea & ~isZero;
+		T4f impulseZ = (dragZ + liftZ) * fluidDensity * doubleArea & ~isZero;
+
+		c0[0] = c0[0] - impulseX * c0[3];
+		c0[1] = c0[1] - impulseY * c0[3];
+		c0[2] = c0[2] - impulseZ * c0[3];
+		c1[0] = c1[0] - impulseX * c1[3];
+		c1[1] = c1[1] - impulseY * c1[3];
+		c1[2] = c1[2] - impulseZ * c1[3];
+		c2[0] = c2[0] - impulseX * c2[3];
+		c2[1] = c2[1] - impulseY * c2[3];
+		c2[2] = c2[2] - impulseZ * c2[3];
+
+		scatterVertices(curIt, tIt + 0, c0);
+		scatterVertices(curIt, tIt + 1, c1);
+		scatterVertices(curIt, tIt + 2, c2);
+	}
+
 	for (; tIt < tEnd; tIt += 3)
 	{
 		//Get the triangle vertex indices
-		uint16_t i0 = tIt[0];
-		uint16_t i1 = tIt[1];
-		uint16_t i2 = tIt[2];
+		IndexT i0 = tIt[0];
+		IndexT i1 = tIt[1];
+		IndexT i2 = tIt[2];
 
 		//Get the current particle positions
 		T4f c0 = curIt[i0];
@@ -468,15 +696,31 @@ void applyWind(T4f* __restrict curIt, const T4f* __restrict prevIt, const uint16
 
 template <typename T4f>
 cloth::SwSolverKernel<T4f>::SwSolverKernel(SwCloth const& cloth, SwClothData& clothData,
-                                              SwKernelAllocator& allocator, IterationStateFactory& factory)
+                                              SwKernelAllocator& allocator, const IterationState<T4f>& state,
+                                              SwKernelScheduler* scheduler)
 : mCloth(cloth)
 , mClothData(clothData)
 , mAllocator(allocator)
+, mScheduler(scheduler)
 , mCollision(clothData, allocator)
 , mSelfCollision(clothData, allocator)
-, mState(factory.create<T4f>(cloth))
+, mState(state)
+, mNumIterations(0)
+, mFuseMotion(false)
+, mStiffnessValues(0)
 {
 	mClothData.verify();
+
+	// iterations can only be skipped if nothing is moved towards a target this frame,
+	// the previous position bias is only non-zero if the frame accelerates
+	mTestConvergence = cloth.mConvergenceThreshold > 0.0f && !state.mIsTurning &&
+	                   cloth.mLinearVelocity.isZero() && allEqual(state.mPrevBias, gSimd4fZero) &&
+	                   !clothData.mTargetMotionConstraints && !clothData.mTargetSeparationConstraints &&
+	                   clothData.mTargetCollisionSpheres == clothData.mStartCollisionSpheres &&
+	                   clothData.mTargetCollisionPlanes == clothData.mStartCollisionPlanes &&
+	                   clothData.mTargetCollisionTriangles == clothData.mStartCollisionTriangles &&
+	                   clothData.mTargetDistanceFieldPose == clothData.mStartDistanceFieldPose &&
+	                   clothData.mTargetHeightfieldPose == clothData.mStartHeightfieldPose;
 }
 
 template <typename T4f>
@@ -494,6 +738,9 @@ size_t cloth::SwSolverKernel<T4f>::estimateTemporaryMemory(const SwCloth& cloth)
 	size_t tempMemory = std::max(collisionTempMemory, selfCollisionTempMemory);
 	size_t persistentMemory = SwCollision<T4f>::estimatePersistentMemory(cloth);
 
+	// converted per-constraint stiffness lives through the frame
+	persistentMemory += sizeof(float) * cloth.mFabric.mStiffnessValues.size();
+
 	// account for any allocator overhead (this could be exposed in the allocator)
 	size_t maxAllocs = 32;
 	size_t maxPerAllocationOverhead = 32;
@@ -502,13 +749,31 @@ size_t cloth::SwSolverKernel<T4f>::estimateTemporaryMemory(const SwCloth& cloth)
 	return maxAllocatorOverhead + persistentMemory + tempMemory;
 }
 
+template <typename T4f>
+template <void (cloth::SwSolverKernel<T4f>::*Range)(uint32_t, uint32_t)>
+void cloth::SwSolverKernel<T4f>::executeRange(void* kernel, uint32_t first, uint32_t last)
+{
+	(static_cast<SwSolverKernel<T4f>*>(kernel)->*Range)(first, last);
+}
+
+template <typename T4f>
+template <void (cloth::SwSolverKernel<T4f>::*Range)(uint32_t, uint32_t)>
+void cloth::SwSolverKernel<T4f>::parallelFor(uint32_t count, uint32_t batchSize)
+{
+	if (mScheduler)
+		mScheduler->parallelFor(&executeRange<Range>, this, count, batchSize);
+	else
+		(this->*Range)(0, count);
+}
+
 template <typename T4f>
 template <typename AccelerationIterator>
-void cloth::SwSolverKernel<T4f>::integrateParticles(AccelerationIterator& accelIt, const T4f& prevBias)
+void cloth::SwSolverKernel<T4f>::integrateParticles(AccelerationIterator& accelIt, const T4f& prevBias,
+                                                       uint32_t first, uint32_t last)
 {
-	T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles);
-	T4f* curEnd = curIt + mClothData.mNumParticles;
-	T4f* prevIt = reinterpret_cast<T4f*>(mClothData.mPrevParticles);
+	T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles) + first;
+	T4f* curEnd = reinterpret_cast<T4f*>(mClothData.mCurParticles) + last;
+	T4f* prevIt = reinterpret_cast<T4f*>(mClothData.mPrevParticles) + first;
 
 	if (!mState.mIsTurning)
 	{
@@ -526,6 +791,12 @@ void cloth::SwSolverKernel<T4f>::integrateParticles()
 {
 	NV_CLOTH_PROFILE_ZONE("cloth::SwSolverKernel::integrateParticles", /*ProfileContext::None*/ 0);
 
+	parallelFor<&SwSolverKernel<T4f>::integrateParticleRange>(mClothData.mNumParticles, sParticleBatchSize);
+}
+
+template <typename T4f>
+void cloth::SwSolverKernel<T4f>::integrateParticleRange(uint32_t first, uint32_t last)
+{
 	const T4f* startAccelIt = reinterpret_cast<const T4f*>(mClothData.mParticleAccelerations);
 
 	// dt^2 (todo: should this be the smoothed dt used for gravity?)
@@ -535,14 +806,18 @@ void cloth::SwSolverKernel<T4f>::integrateParticles()
 	{
 		// no per-particle accelerations, use a constant
 		ConstantIterator<T4f> accelIt(mState.mCurBias);
-		integrateParticles(accelIt, mState.mPrevBias);
+		integrateParticles(accelIt, mState.mPrevBias, first, last);
 	}
 	else
 	{
 		// iterator implicitly scales by dt^2 and adds gravity
-		ScaleBiasIterator<T4f, const T4f*> accelIt(startAccelIt, sqrIterDt, mState.mCurBias);
-		integrateParticles(accelIt, mState.mPrevBias);
+		ScaleBiasIterator<T4f, const T4f*> accelIt(startAccelIt + first, sqrIterDt, mState.mCurBias);
+		integrateParticles(accelIt, mState.mPrevBias, first, last);
 	}
+
+	// constrain the range while it is still in cache
+	if (mFuseMotion)
+		constrainMotionRange(first, last);
 }
 
 template <typename T4f>
@@ -553,26 +828,85 @@ void cloth::SwSolverKernel<T4f>::constrainTether()
 
 	NV_CLOTH_PROFILE_ZONE("cloth::SwSolverKernel::solveTethers", /*ProfileContext::None*/ 0);
 
+	NV_CLOTH_ASSERT(0 == mClothData.mNumTethers % mClothData.mNumParticles); // the particles can have multiple tethers, but each particle has the same amount
+
+	// tether anchors are expected to be static, so particles can be processed in any order
+	parallelFor<&SwSolverKernel<T4f>::constrainTetherRange>(mClothData.mNumParticles, sParticleBatchSize);
+}
+
+template <typename T4f>
+void cloth::SwSolverKernel<T4f>::constrainTetherRange(uint32_t first, uint32_t last)
+{
 	uint32_t numParticles = mClothData.mNumParticles;
 	uint32_t numTethers = mClothData.mNumTethers;
-	NV_CLOTH_ASSERT(0 == numTethers % numParticles); // the particles can have multiple tethers, but each particle has the same amount
 
 	//particle iterators
-	float* __restrict curIt = mClothData.mCurParticles;
-	const float* __restrict curFirst = curIt;
-	const float* __restrict curEnd = curIt + 4 * numParticles;
+	float* __restrict curIt = mClothData.mCurParticles + 4 * first;
+	const float* __restrict curFirst = mClothData.mCurParticles;
+	const float* __restrict curEnd = mClothData.mCurParticles + 4 * last;
 
 	//Tether iterators
 	typedef const SwTether* __restrict TetherIter;
-	TetherIter tFirst = mClothData.mTethers;
-	TetherIter tEnd = tFirst + numTethers;
+	TetherIter tFirst = mClothData.mTethers + first;
+	TetherIter tEnd = mClothData.mTethers + numTethers;
 
 	//Tether properties
-	T4f stiffness =
-	    static_cast<T4f>(sMaskXYZ) & simd4f(numParticles * mClothData.mTetherConstraintStiffness / numTethers);
+	T4f stiffness = simd4f(numParticles * mClothData.mTetherConstraintStiffness / numTethers);
 	T4f scale = simd4f(mClothData.mTetherConstraintScale);
 
-	//Loop through all particles
+	//Loop through 4 particles at a time, the tethers of consecutive particles are stored next to each other
+	for (; curEnd - curIt >= 16; curIt += 16, tFirst += 4)
+	{
+		T4f position[4];
+		position[0] = loadAligned(curIt, 0);
+		position[1] = loadAligned(curIt, 16);
+		position[2] = loadAligned(curIt, 32);
+		position[3] = loadAligned(curIt, 48);
+		transpose(position[0], position[1], position[2], position[3]);
+
+		T4f offsetX = gSimd4fZero, offsetY = gSimd4fZero, offsetZ = gSimd4fZero;
+
+		for (TetherIter tIt = tFirst; tIt < tEnd; tIt += numParticles)
+		{
+			NV_CLOTH_ASSERT(tIt[0].mAnchor < numParticles && tIt[1].mAnchor < numParticles);
+			NV_CLOTH_ASSERT(tIt[2].mAnchor < numParticles && tIt[3].mAnchor < numParticles);
+
+			//Gather the particles on the other end of the tethers
+			T4f anchor[4];
+			anchor[0] = loadAligned(curFirst, tIt[0].mAnchor * sizeof(PxVec4));
+			anchor[1] = loadAligned(curFirst, tIt[1].mAnchor * sizeof(PxVec4));
+			anchor[2] = loadAligned(curFirst, tIt[2].mAnchor * sizeof(PxVec4));
+			anchor[3] = loadAligned(curFirst, tIt[3].mAnchor * sizeof(PxVec4));
+			transpose(anchor[0], anchor[1], anchor[2], anchor[3]);
+
+			T4f deltaX = anchor[0] - position[0];
+			T4f deltaY = anchor[1] - position[1];
+			T4f deltaZ = anchor[2] - position[2];
+			T4f sqrLength = gSimd4fEpsilon + (deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+
+			T4f tetherLength = simd4f(tIt[0].mLength, tIt[1].mLength, tIt[2].mLength, tIt[3].mLength);
+
+			T4f radius = tetherLength * scale;
+			T4f slack = max(gSimd4fOne - radius * rsqrt(sqrLength), gSimd4fZero);
+
+			offsetX = offsetX + deltaX * slack;
+			offsetY = offsetY + deltaY * slack;
+			offsetZ = offsetZ + deltaZ * slack;
+		}
+
+		position[0] = position[0] + offsetX * stiffness;
+		position[1] = position[1] + offsetY * stiffness;
+		position[2] = position[2] + offsetZ * stiffness;
+
+		transpose(position[0], position[1], position[2], position[3]);
+		storeAligned(curIt, 0, position[0]);
+		storeAligned(curIt, 16, position[1]);
+		storeAligned(curIt, 32, position[2]);
+		storeAligned(curIt, 48, position[3]);
+	}
+
+	//Loop through the remaining particles, leaving w unchanged
+	stiffness = static_cast<T4f>(sMaskXYZ) & stiffness;
 	for (; curIt != curEnd; curIt += 4, ++tFirst)
 	{
 		T4f position = loadAligned(curIt); //Get the first particle
@@ -606,38 +940,38 @@ void cloth::SwSolverKernel<T4f>::solveFabric()
 {
 	NV_CLOTH_PROFILE_ZONE("cloth::SwSolverKernel::solveFabric", /*ProfileContext::None*/ 0);
 
-	float* pIt = mClothData.mCurParticles;
-
 	//Phase configuration
 	const PhaseConfig* cIt = mClothData.mConfigBegin;
 	const PhaseConfig* cEnd = mClothData.mConfigEnd;
 
 	const uint32_t* pBegin = mClothData.mPhases;
 	const float* rBegin = mClothData.mRestvalues;
-	const float* stBegin = mClothData.mStiffnessValues;
+	const float* stBegin = mStiffnessValues;
 
 	const uint32_t* sBegin = mClothData.mSets;
 	const uint16_t* iBegin = mClothData.mIndices;
+	const uint32_t* iBegin32 = mClothData.mIndices32;
 
 	uint32_t totalConstraints = 0;
 
 	T4f stiffnessExponent = simd4f(mCloth.mStiffnessFrequency * mState.mIterDt);
 
+	// particles referenced more than once within a set need to be attached
+	// for the constraints of a set to be split up or solved 16 at a time
+	bool independent = true;
+	const uint32_t* shIt = mCloth.mFabric.mSharedIndices.begin();
+	const uint32_t* shEnd = mCloth.mFabric.mSharedIndices.end();
+	for (; independent && shIt != shEnd; ++shIt)
+		independent = mClothData.mCurParticles[*shIt * 4 + 3] == 0.0f;
+
 	//Loop through all phase configs
 	for (; cIt != cEnd; ++cIt)
 	{
 		//Get the set for this config
 		const uint32_t* sIt = sBegin + pBegin[cIt->mPhaseIndex];
+		uint32_t numConstraints = sIt[1] - sIt[0]; //start of next set is the end of ours
 
-		//Get rest value iterators from set
-		const float* rIt = rBegin + sIt[0];
-		const float* rEnd = rBegin + sIt[1]; //start of next set is the end of ours
-		const float* stIt = stBegin?stBegin + sIt[0]:nullptr;
-
-		//Constraint particle indices
-		const uint16_t* iIt = iBegin + sIt[0] * 2; //x2 as we have 2 indices for every rest length
-
-		totalConstraints += uint32_t(rEnd - rIt);
+		totalConstraints += numConstraints;
 
 		// (stiffness, multiplier, compressionLimit, stretchLimit)
 		T4f config = load(&cIt->mStiffness);
@@ -645,30 +979,51 @@ void cloth::SwSolverKernel<T4f>::solveFabric()
 		T4f scaledConfig = gSimd4fOne - exp2(config * stiffnessExponent);
 		T4f stiffness = select(sMaskXY, scaledConfig, config);
 
-		int neutralMultiplier = allEqual(sMaskYZW & stiffness, gSimd4fZero);
+		mConstraintSet.mStiffness = stiffness;
+		mConstraintSet.mRestvalues = rBegin + sIt[0];
+		mConstraintSet.mStiffnessValues = stBegin ? stBegin + sIt[0] : nullptr;
+		mConstraintSet.mIndices = iBegin + sIt[0] * 2; //x2 as we have 2 indices for every rest length
+		mConstraintSet.mIndices32 = iBegin32 ? iBegin32 + sIt[0] * 2 : 0;
+		mConstraintSet.mNeutralMultiplier = allEqual(sMaskYZW & stiffness, gSimd4fZero) != 0;
+		mConstraintSet.mIndependent = independent;
+
+		if (independent)
+			parallelFor<&SwSolverKernel<T4f>::solveConstraintRange>(numConstraints, sConstraintBatchSize);
+		else
+			solveConstraintRange(0, numConstraints);
+	}
+}
+
+template <typename T4f>
+void cloth::SwSolverKernel<T4f>::solveConstraintRange(uint32_t first, uint32_t last)
+{
+	//Constraint particle indices, 16 bit unless the fabric has too many particles
+	if (mConstraintSet.mIndices32)
+		solveConstraintRange(mConstraintSet.mIndices32 + first * 2, first, last);
+	else
+		solveConstraintRange(mConstraintSet.mIndices + first * 2, first, last);
+}
+
+template <typename T4f>
+template <typename IndexT>
+void cloth::SwSolverKernel<T4f>::solveConstraintRange(const IndexT* iIt, uint32_t first, uint32_t last)
+{
+	float* pIt = mClothData.mCurParticles;
+
+	//Get rest value iterators from set
+	const float* rIt = mConstraintSet.mRestvalues + first;
+	const float* rEnd = mConstraintSet.mRestvalues + last;
+	const float* stIt = mConstraintSet.mStiffnessValues ? mConstraintSet.mStiffnessValues + first : nullptr;
+
+	const T4f& stiffness = mConstraintSet.mStiffness;
+	bool neutralMultiplier = mConstraintSet.mNeutralMultiplier;
 
 #if NV_AVX
-		switch(sAvxSupport)
-		{
-		case 2:
-#if _MSC_VER >= 1700
-			neutralMultiplier ? avx::solveConstraints<false, 2>(pIt, rIt, stIt, rEnd, iIt, stiffness, stiffnessExponent)
-			                  : avx::solveConstraints<true, 2>(pIt, rIt, stIt, rEnd, iIt, stiffness, stiffnessExponent);
-			break;
-#endif
-		case 1:
-			neutralMultiplier ? avx::solveConstraints<false, 1>(pIt, rIt, stIt, rEnd, iIt, stiffness, stiffnessExponent)
-			                  : avx::solveConstraints<true, 1>(pIt, rIt, stIt, rEnd, iIt, stiffness, stiffnessExponent);
-			break;
-		default:
-#endif
-			neutralMultiplier ? solveConstraints<false>(pIt, rIt, stIt, rEnd, iIt, stiffness, stiffnessExponent)
-			                  : solveConstraints<true>(pIt, rIt, stIt, rEnd, iIt, stiffness, stiffnessExponent);
-#if NV_AVX
-			break;
-		}
+	if (solveConstraintsAvx(mConstraintSet.mIndependent, neutralMultiplier, pIt, rIt, stIt, rEnd, iIt, stiffness))
+		return;
 #endif
-	}
+	neutralMultiplier ? solveConstraints<false>(pIt, rIt, stIt, rEnd, iIt, stiffness)
+	                  : solveConstraints<true>(pIt, rIt, stIt, rEnd, iIt, stiffness);
 }
 
 template <typename T4f>
@@ -679,20 +1034,29 @@ void cloth::SwSolverKernel<T4f>::applyWind()
 
 	NV_CLOTH_PROFILE_ZONE("cloth::SwSolverKernel::applyWind", /*ProfileContext::None*/ 0);
 
+	uint32_t numBatched = 12 * mClothData.mNumTriangleBatches;
+	uint32_t numIndices = 3 * mClothData.mNumTriangles;
+	if (mClothData.mTriangles32)
+		applyWind(mClothData.mTriangles32, mClothData.mTriangles32 + numBatched, mClothData.mTriangles32 + numIndices);
+	else
+		applyWind(mClothData.mTriangles, mClothData.mTriangles + numBatched, mClothData.mTriangles + numIndices);
+}
+
+template <typename T4f>
+template <typename IndexT>
+void cloth::SwSolverKernel<T4f>::applyWind(const IndexT* tIt, const IndexT* tBatchEnd, const IndexT* tEnd)
+{
 	T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles);
 	T4f* prevIt = reinterpret_cast<T4f*>(mClothData.mPrevParticles);
 
-	const uint16_t* tIt = mClothData.mTriangles;
-	const uint16_t* tEnd = tIt + 3 * mClothData.mNumTriangles;
-
 	if (mState.mIsTurning)
 	{
-		::applyWind<true>(curIt, prevIt, tIt, tEnd, mState.mIterDt, mClothData.mDragCoefficient, mClothData.mLiftCoefficient, mClothData.mFluidDensity, mState.mWind,
+		::applyWind<true>(curIt, prevIt, tIt, tBatchEnd, tEnd, mState.mIterDt, mClothData.mDragCoefficient, mClothData.mLiftCoefficient, mClothData.mFluidDensity, mState.mWind,
 		                  mState.mRotationMatrix);
 	}
 	else
 	{
-		::applyWind<false>(curIt, prevIt, tIt, tEnd, mState.mIterDt, mClothData.mDragCoefficient, mClothData.mLiftCoefficient, mClothData.mFluidDensity, mState.mWind,
+		::applyWind<false>(curIt, prevIt, tIt, tBatchEnd, tEnd, mState.mIterDt, mClothData.mDragCoefficient, mClothData.mLiftCoefficient, mClothData.mFluidDensity, mState.mWind,
 		                   mState.mRotationMatrix);
 	}
 }
@@ -700,27 +1064,35 @@ void cloth::SwSolverKernel<T4f>::applyWind()
 template <typename T4f>
 void cloth::SwSolverKernel<T4f>::constrainMotion()
 {
-	if (!mClothData.mStartMotionConstraints)
+	if (!mClothData.mStartMotionConstraints || mFuseMotion)
 		return;
 
 	NV_CLOTH_PROFILE_ZONE("cloth::SwSolverKernel::constrainMotion", /*ProfileContext::None*/ 0);
 
-	T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles);
-	T4f* curEnd = curIt + mClothData.mNumParticles;
+	parallelFor<&SwSolverKernel<T4f>::constrainMotionRange>(mClothData.mNumParticles, sParticleBatchSize);
+}
+
+template <typename T4f>
+void cloth::SwSolverKernel<T4f>::constrainMotionRange(uint32_t first, uint32_t last)
+{
+	T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles) + first;
+	T4f* curEnd = reinterpret_cast<T4f*>(mClothData.mCurParticles) + last;
 
-	const T4f* startIt = reinterpret_cast<const T4f*>(mClothData.mStartMotionConstraints);
+	const T4f* startIt = reinterpret_cast<const T4f*>(mClothData.mStartMotionConstraints) + first;
 	const T4f* targetIt = reinterpret_cast<const T4f*>(mClothData.mTargetMotionConstraints);
 
 	T4f scaleBias = load(&mCloth.mMotionConstraintScale);
 	T4f stiffness = simd4f(mClothData.mMotionConstraintStiffness);
 	T4f scaleBiasStiffness = select(sMaskXYZ, scaleBias, stiffness);
 
-	if (!mClothData.mTargetMotionConstraints)
+	if (!targetIt)
 	{
 		// no interpolation, use the start positions
 		return ::constrainMotion(curIt, curEnd, startIt, scaleBiasStiffness);
 	}
 
+	targetIt += first;
+
 	if (mState.mRemainingIterations == 1)
 	{
 		// use the target positions on last iteration
@@ -740,18 +1112,26 @@ void cloth::SwSolverKernel<T4f>::constrainSeparation()
 
 	NV_CLOTH_PROFILE_ZONE("cloth::SwSolverKernel::constrainSeparation", /*ProfileContext::None*/ 0);
 
-	T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles);
-	T4f* curEnd = curIt + mClothData.mNumParticles;
+	parallelFor<&SwSolverKernel<T4f>::constrainSeparationRange>(mClothData.mNumParticles, sParticleBatchSize);
+}
+
+template <typename T4f>
+void cloth::SwSolverKernel<T4f>::constrainSeparationRange(uint32_t first, uint32_t last)
+{
+	T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles) + first;
+	T4f* curEnd = reinterpret_cast<T4f*>(mClothData.mCurParticles) + last;
 
-	const T4f* startIt = reinterpret_cast<const T4f*>(mClothData.mStartSeparationConstraints);
+	const T4f* startIt = reinterpret_cast<const T4f*>(mClothData.mStartSeparationConstraints) + first;
 	const T4f* targetIt = reinterpret_cast<const T4f*>(mClothData.mTargetSeparationConstraints);
 
-	if (!mClothData.mTargetSeparationConstraints)
+	if (!targetIt)
 	{
 		// no interpolation, use the start positions
 		return ::constrainSeparation(curIt, curEnd, startIt);
 	}
 
+	targetIt += first;
+
 	if (mState.mRemainingIterations == 1)
 	{
 		// use the target positions on last iteration
@@ -767,7 +1147,26 @@ void cloth::SwSolverKernel<T4f>::collideParticles()
 {
 	NV_CLOTH_PROFILE_ZONE("cloth::SwSolverKernel::collideParticles", /*ProfileContext::None*/ 0);
 
-	mCollision(mState);
+	if (!mCollision.beginCollision(mState))
+		return;
+
+	parallelFor<&SwSolverKernel<T4f>::collideParticleRange>(mClothData.mNumParticles, sParticleBatchSize);
+
+	mCollision.endCollision();
+}
+
+template <typename T4f>
+void cloth::SwSolverKernel<T4f>::collideParticleRange(uint32_t first, uint32_t last)
+{
+#if NV_AVX
+	// continuous collision is only implemented for 4 particles at a time
+	if (sAvxSupport && !mClothData.mEnableContinuousCollision)
+	{
+		mCollision.collideParticlesAvx(first, last);
+		return;
+	}
+#endif
+	mCollision.collideParticleRange(first, last);
 }
 
 template <typename T4f>
@@ -802,6 +1201,46 @@ void cloth::SwSolverKernel<T4f>::updateSleepState()
 	}
 }
 
+template <typename T4f>
+bool cloth::SwSolverKernel<T4f>::hasConverged()
+{
+	if (!mTestConvergence || ++mNumIterations < mCloth.mConvergenceMinIterations)
+		return false;
+
+	NV_CLOTH_PROFILE_ZONE("cloth::SwSolverKernel::hasConverged", /*ProfileContext::None*/ 0);
+
+	const T4f* prevIt = reinterpret_cast<T4f*>(mClothData.mPrevParticles);
+	const T4f* curIt = reinterpret_cast<T4f*>(mClothData.mCurParticles);
+	const T4f* curEnd = curIt + mClothData.mNumParticles;
+
+	// max particle delta of the last iteration
+	T4f maxDelta = calculateMaxDelta(prevIt, curIt, curEnd);
+
+	T4f threshold = simd4f(mCloth.mConvergenceThreshold * mState.mIterDt);
+	return !anyGreaterEqual(maxDelta, threshold);
+}
+
+template <typename T4f>
+void cloth::SwSolverKernel<T4f>::computeStiffnessValues()
+{
+	const float* stIt = mClothData.mStiffnessValues;
+	if (!stIt)
+		return;
+
+	// the exponent only depends on the iteration dt, so the conversion
+	// is done once per frame instead of in every solveConstraints() call
+	uint32_t numValues = mCloth.mFabric.mStiffnessValues.size();
+	mStiffnessValues = static_cast<float*>(mAllocator.allocate(sizeof(float) * numValues));
+
+	// stiffness specified as fraction of constraint error per-millisecond
+	T4f stiffnessExponent = simd4f(mCloth.mStiffnessFrequency * mState.mIterDt);
+
+	float* dIt = mStiffnessValues;
+	float* dEnd = dIt + numValues;
+	for (; dIt < dEnd; dIt += 4, stIt += 4)
+		storeAligned(dIt, gSimd4fOne - exp2(stiffnessExponent * static_cast<T4f>(loadAligned(stIt))));
+}
+
 template <typename T4f>
 void cloth::SwSolverKernel<T4f>::iterateCloth()
 {
@@ -818,6 +1257,11 @@ void cloth::SwSolverKernel<T4f>::iterateCloth()
 	//   - previous.w: original invMass as set by user
 	//   - current.w: zeroed by motion constraints and mass-scaled by collision
 
+	// motion constraints only depend on the particle itself, so they can be applied while
+	// integrating unless wind runs in between. separation constraints have to see the result of solveFabric().
+	bool hasWind = mClothData.mDragCoefficient != 0.0f || mClothData.mLiftCoefficient != 0.0f;
+	mFuseMotion = mClothData.mStartMotionConstraints && !hasWind;
+
 	// integrate positions
 	integrateParticles();
 
@@ -849,11 +1293,19 @@ void cloth::SwSolverKernel<T4f>::iterateCloth()
 template <typename T4f>
 void cloth::SwSolverKernel<T4f>::simulateCloth()
 {
+	computeStiffnessValues();
+
 	while (mState.mRemainingIterations)
 	{
 		iterateCloth();
 		mState.update();
+
+		if (mState.mRemainingIterations && hasConverged())
+			break;
 	}
+
+	mAllocator.deallocate(mStiffnessValues);
+	mStiffnessValues = 0;
 }
 
 // explicit template instantiation
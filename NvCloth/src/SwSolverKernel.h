@@ -40,12 +40,14 @@ namespace cloth
 
 class SwCloth;
 struct SwClothData;
+class SwKernelScheduler;
 
 template <typename T4f>
 class SwSolverKernel
 {
   public:
-	SwSolverKernel(SwCloth const&, SwClothData&, SwKernelAllocator&, IterationStateFactory&);
+	SwSolverKernel(SwCloth const&, SwClothData&, SwKernelAllocator&, const IterationState<T4f>&,
+	               SwKernelScheduler* scheduler = NULL);
 
 	void operator()();
 
@@ -63,22 +65,66 @@ class SwSolverKernel
 	void collideParticles();
 	void selfCollideParticles();
 	void updateSleepState();
+	bool hasConverged();
 
+	void computeStiffnessValues();
 	void iterateCloth();
 	void simulateCloth();
 
+	// loop bodies over [first, last) particles or constraints of the current set,
+	// executed through parallelFor() to share them with other chunks of the cloth
+	void integrateParticleRange(uint32_t first, uint32_t last);
+	void constrainTetherRange(uint32_t first, uint32_t last);
+	void solveConstraintRange(uint32_t first, uint32_t last);
+	void constrainMotionRange(uint32_t first, uint32_t last);
+	void constrainSeparationRange(uint32_t first, uint32_t last);
+	void collideParticleRange(uint32_t first, uint32_t last);
+
+	template <void (SwSolverKernel<T4f>::*)(uint32_t, uint32_t)>
+	void parallelFor(uint32_t count, uint32_t batchSize);
+	template <void (SwSolverKernel<T4f>::*)(uint32_t, uint32_t)>
+	static void executeRange(void* kernel, uint32_t first, uint32_t last);
+
+	// constraint set currently processed by solveConstraintRange()
+	struct ConstraintSet
+	{
+		T4f mStiffness; // (stiffness, multiplier, compressionLimit, stretchLimit)
+		const float* mRestvalues;
+		const float* mStiffnessValues;
+		const uint16_t* mIndices;
+		const uint32_t* mIndices32; // non-null instead of mIndices for fabrics with 32 bit indices
+		bool mNeutralMultiplier;
+		bool mIndependent; // constraints only share attached particles
+	};
+
 	SwCloth const& mCloth;
 	SwClothData& mClothData;
 	SwKernelAllocator& mAllocator;
+	SwKernelScheduler* mScheduler;
 
 	SwCollision<T4f> mCollision;
 	SwSelfCollision<T4f> mSelfCollision;
 	IterationState<T4f> mState;
+	ConstraintSet mConstraintSet;
+
+	// iterations run so far, only counted if the cloth may stop iterating early
+	uint32_t mNumIterations;
+	bool mTestConvergence;
+
+	// motion constraints applied by integrateParticleRange() of this iteration
+	bool mFuseMotion;
+
+	// per-constraint stiffness of the fabric converted for this frame's iteration dt, or null
+	float* mStiffnessValues;
 
   private:
 	SwSolverKernel<T4f>& operator = (const SwSolverKernel<T4f>&);
 	template <typename AccelerationIterator>
-	void integrateParticles(AccelerationIterator& accelIt, const T4f&);
+	void integrateParticles(AccelerationIterator& accelIt, const T4f&, uint32_t first, uint32_t last);
+	template <typename IndexT>
+	void solveConstraintRange(const IndexT* iIt, uint32_t first, uint32_t last);
+	template <typename IndexT>
+	void applyWind(const IndexT* tIt, const IndexT* tBatchEnd, const IndexT* tEnd);
 };
 
 //explicit template instantiation declaration
@@ -142,12 +142,13 @@ void cloth::TripletScheduler::simd(uint32_t numParticles, uint32_t simdWidth)
 		mSetSizes.pushBack(setSize);
 		amountOfPaddingNeeded += (static_cast<int>(simdWidth) - (setSize % static_cast<int>(simdWidth)))% static_cast<int>(simdWidth);
 	}
+	delete[] particlesInBatch;
 
 	// Padding code used to live in SwCloth::setVirtualParticles, now we do it here directly 
 	mPaddedTriplets.reserve(mTriplets.size() + amountOfPaddingNeeded);
 
 	{
-		Vec4us paddingDummy(static_cast<uint16_t>(numParticles), static_cast<uint16_t>(numParticles) + 1, static_cast<uint16_t>(numParticles) + 2, 0);
+		Vec4u paddingDummy(numParticles, numParticles + 1, numParticles + 2, 0);
 
 		TripletIter tIt = mTriplets.begin();
 		//TripletIter tEnd = mTriplets.end();
@@ -51,7 +51,7 @@ struct TripletScheduler
 
 	Vector<Vec4u>::Type mTriplets;
 	Vector<uint32_t>::Type mSetSizes;
-	Vector<Vec4us>::Type mPaddedTriplets;
+	Vector<Vec4u>::Type mPaddedTriplets;
 };
 }
 }
@@ -0,0 +1,621 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2020 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#ifdef _MSC_VER
+
+#pragma warning(push)
+#pragma warning(disable : 4668) //'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
+#pragma warning(disable : 4987) // nonstandard extension used: 'throw (...)'
+#include <intrin.h>
+#pragma warning(pop)
+
+typedef unsigned __int32 uint32_t;
+
+#else
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#endif
+
+// Discrete sphere and capsule collision for 8 particles at a time, see SwCollision<Simd4f>::collideParticles().
+// Operations are performed in the same order as the sse2 version (and without fma), so both produce the same
+// results. Shape masks are still combined per group of 4 particles to cull the same spheres.
+
+namespace avx
+{
+// defined in SwSolveConstraints.cpp
+extern __m256 sOne, sEpsilon;
+
+// internal linkage, so helpers compiled with different instruction sets don't get merged
+namespace
+{
+uint32_t findBitSet(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long result;
+	_BitScanForward(&result, (unsigned long)mask);
+	return result;
+#else
+	return __builtin_ffs(mask) - 1;
+#endif
+}
+
+__m256 combine(const __m128& lo, const __m128& hi)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+__m256 combine(const __m128i& lo, const __m128i& hi)
+{
+	return combine(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi));
+}
+
+__m128i lowerHalf(const __m256& v)
+{
+	return _mm_castps_si128(_mm256_castps256_ps128(v));
+}
+
+__m128i upperHalf(const __m256& v)
+{
+	return _mm_castps_si128(_mm256_extractf128_ps(v, 1));
+}
+
+__m256 splat(uint32_t bits)
+{
+	return _mm256_castsi256_ps(_mm256_set1_epi32(int(bits)));
+}
+
+__m256 negate(const __m256& v)
+{
+	return _mm256_xor_ps(splat(0x80000000), v);
+}
+
+// per group of 4 particles, bit 0 for the lower and bit 1 for the upper half
+__m256 groupMask(uint32_t groups)
+{
+	return combine(_mm_set1_epi32(-int(groups & 1)), _mm_set1_epi32(-int(groups >> 1)));
+}
+
+uint32_t horizontalOr(const __m128i& mask)
+{
+	__m128i tmp = _mm_or_si128(mask, _mm_shuffle_epi32(mask, 0xb1));
+	return uint32_t(_mm_cvtsi128_si32(_mm_or_si128(tmp, _mm_shuffle_epi32(tmp, 0x4e))));
+}
+
+// lanes without any of the bits set
+__m256 isZero(const __m256& mask, const __m256& bits)
+{
+	__m256 v = _mm256_and_ps(mask, bits);
+	__m128i zero = _mm_setzero_si128();
+	return combine(_mm_cmpeq_epi32(lowerHalf(v), zero), _mm_cmpeq_epi32(upperHalf(v), zero));
+}
+
+__m128i intFloor(const __m128& v)
+{
+	__m128i i = _mm_cvttps_epi32(v);
+	return _mm_sub_epi32(i, _mm_srli_epi32(_mm_castps_si128(v), 31));
+}
+
+struct Gather
+{
+	Gather(const __m256& position)
+	{
+		__m128i lo = intFloor(_mm256_castps256_ps128(position));
+		__m128i hi = intFloor(_mm256_extractf128_ps(position, 1));
+
+		// permutevar selects with the 2 least significant bits, blendv with the sign bit
+		mIndex = _mm256_castps_si256(combine(lo, hi));
+		mSelectHi = combine(_mm_slli_epi32(lo, 29), _mm_slli_epi32(hi, 29));
+
+		// true if index is outside the grid = (index > 0x7 || index < 0x0)
+		__m128i signBit = _mm_set1_epi32(int(0x80000000)), signedMask = _mm_set1_epi32(int(0x80000007));
+		mOutOfRange = combine(_mm_cmpgt_epi32(_mm_xor_si128(lo, signBit), signedMask),
+		                      _mm_cmpgt_epi32(_mm_xor_si128(hi, signBit), signedMask));
+	}
+
+	// grid points to the 8 cells along one axis
+	__m256 operator()(const uint32_t* grid) const
+	{
+		__m256 lo = _mm256_permutevar_ps(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(grid)), mIndex);
+		__m256 hi = _mm256_permutevar_ps(_mm256_broadcast_ps(reinterpret_cast<const __m128*>(grid + 4)), mIndex);
+		return _mm256_andnot_ps(mOutOfRange, _mm256_blendv_ps(lo, hi, mSelectHi));
+	}
+
+	__m256i mIndex;
+	__m256 mSelectHi;
+	__m256 mOutOfRange;
+};
+
+struct ImpulseAccumulator
+{
+	ImpulseAccumulator()
+	: mDeltaX(_mm256_setzero_ps())
+	, mDeltaY(mDeltaX)
+	, mDeltaZ(mDeltaX)
+	, mVelX(mDeltaX)
+	, mVelY(mDeltaX)
+	, mVelZ(mDeltaX)
+	, mNumCollisions(sEpsilon)
+	{
+	}
+
+	void add(const __m256& x, const __m256& y, const __m256& z, const __m256& scale, const __m256& mask)
+	{
+		__m256 maskedScale = _mm256_and_ps(scale, mask);
+		mDeltaX = _mm256_add_ps(mDeltaX, _mm256_mul_ps(x, maskedScale));
+		mDeltaY = _mm256_add_ps(mDeltaY, _mm256_mul_ps(y, maskedScale));
+		mDeltaZ = _mm256_add_ps(mDeltaZ, _mm256_mul_ps(z, maskedScale));
+		mNumCollisions = _mm256_add_ps(mNumCollisions, _mm256_and_ps(sOne, mask));
+	}
+
+	void addVelocity(const __m256& vx, const __m256& vy, const __m256& vz, const __m256& mask)
+	{
+		mVelX = _mm256_add_ps(mVelX, _mm256_and_ps(vx, mask));
+		mVelY = _mm256_add_ps(mVelY, _mm256_and_ps(vy, mask));
+		mVelZ = _mm256_add_ps(mVelZ, _mm256_and_ps(vz, mask));
+	}
+
+	void subtract(const __m256& x, const __m256& y, const __m256& z, const __m256& scale, const __m256& mask)
+	{
+		__m256 maskedScale = _mm256_and_ps(scale, mask);
+		mDeltaX = _mm256_sub_ps(mDeltaX, _mm256_mul_ps(x, maskedScale));
+		mDeltaY = _mm256_sub_ps(mDeltaY, _mm256_mul_ps(y, maskedScale));
+		mDeltaZ = _mm256_sub_ps(mDeltaZ, _mm256_mul_ps(z, maskedScale));
+		mNumCollisions = _mm256_add_ps(mNumCollisions, _mm256_and_ps(sOne, mask));
+	}
+
+	__m256 mDeltaX, mDeltaY, mDeltaZ;
+	__m256 mVelX, mVelY, mVelZ;
+	__m256 mNumCollisions;
+};
+
+// particles as (x, y, z, w) vectors of 8 particles each
+void load(const float* ptr, const float* blocks, bool bothGroups, __m256 (&pos)[4])
+{
+	__m128 lo[4], hi[4];
+	if (blocks)
+	{
+		for (int i = 0; i < 4; ++i)
+			lo[i] = _mm_load_ps(blocks + i * 4);
+		for (int i = 0; i < 4; ++i)
+			hi[i] = bothGroups ? _mm_load_ps(blocks + i * 4 + 16) : lo[i];
+	}
+	else
+	{
+		for (int i = 0; i < 4; ++i)
+			lo[i] = _mm_load_ps(ptr + i * 4);
+		_MM_TRANSPOSE4_PS(lo[0], lo[1], lo[2], lo[3]);
+		for (int i = 0; i < 4; ++i)
+			hi[i] = bothGroups ? _mm_load_ps(ptr + i * 4 + 16) : lo[i];
+		if (bothGroups)
+			_MM_TRANSPOSE4_PS(hi[0], hi[1], hi[2], hi[3]);
+	}
+	for (int i = 0; i < 4; ++i)
+		pos[i] = combine(lo[i], hi[i]);
+}
+
+void store(float* ptr, bool bothGroups, const __m256 (&pos)[4])
+{
+	__m128 lo[4], hi[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		lo[i] = _mm256_castps256_ps128(pos[i]);
+		hi[i] = _mm256_extractf128_ps(pos[i], 1);
+	}
+	_MM_TRANSPOSE4_PS(lo[0], lo[1], lo[2], lo[3]);
+	for (int i = 0; i < 4; ++i)
+		_mm_store_ps(ptr + i * 4, lo[i]);
+	if (!bothGroups)
+		return;
+	_MM_TRANSPOSE4_PS(hi[0], hi[1], hi[2], hi[3]);
+	for (int i = 0; i < 4; ++i)
+		_mm_store_ps(ptr + i * 4 + 16, hi[i]);
+}
+
+// same as SwCollision::sMaxShapeWords, shape i is bit (i & 31) of word (i >> 5)
+const uint32_t sMaxShapeWords = 8;
+// floats per cone, same layout as ConeData
+const uint32_t sConeSize = 16;
+// same as SwCollision::sGridSize, cells gathered at once
+const uint32_t sGridSize = 8;
+
+struct ShapeMask
+{
+	__m256 mCones[sMaxShapeWords];
+	__m256 mSpheres[sMaxShapeWords];
+};
+
+struct CollisionShapes
+{
+	const float* mSpheres;
+	const float* mPrevSpheres;
+	const float* mCones;
+	const uint32_t* mCapsuleIndices;
+	const uint32_t* mSphereGrid;
+	const uint32_t* mConeGrid;
+	uint32_t mNumSphereWords;
+	uint32_t mNumConeWords;
+	uint32_t mNumCells[3];
+	uint32_t mGridStride; // cells per axis in memory, the largest of mNumCells
+	__m256 mGridScale[3];
+	__m256 mGridBias[3];
+	bool mFrictionEnabled;
+};
+
+// same as the sse2 gatherCells(), finer grids are gathered sGridSize cells at a time
+__m256 gatherCells(const Gather& gather, const uint32_t* cells, const __m256& position, uint32_t numCells)
+{
+	__m256 result = gather(cells);
+	for (uint32_t i = sGridSize; i < numCells; i += sGridSize)
+		result = _mm256_or_ps(result, Gather(_mm256_sub_ps(position, _mm256_set1_ps(float(i))))(cells + i));
+	return result;
+}
+
+void getShapeMask(const CollisionShapes& shapes, const __m256* positions, ShapeMask& result)
+{
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		__m256 position = _mm256_add_ps(_mm256_mul_ps(positions[i], shapes.mGridScale[i]), shapes.mGridBias[i]);
+		Gather gather(position);
+		for (uint32_t word = 0; word < shapes.mNumConeWords; ++word)
+		{
+			const uint32_t* cells = shapes.mConeGrid + (word * 6 + i) * shapes.mGridStride;
+			__m256 cones = gatherCells(gather, cells, position, shapes.mNumCells[i]);
+			result.mCones[word] = i ? _mm256_and_ps(result.mCones[word], cones) : cones;
+		}
+		for (uint32_t word = 0; word < shapes.mNumSphereWords; ++word)
+		{
+			const uint32_t* cells = shapes.mSphereGrid + (word * 6 + i) * shapes.mGridStride;
+			__m256 spheres = gatherCells(gather, cells, position, shapes.mNumCells[i]);
+			result.mSpheres[word] = i ? _mm256_and_ps(result.mSpheres[word], spheres) : spheres;
+		}
+	}
+}
+
+void collideCones(const CollisionShapes& shapes, const __m256* positions, ShapeMask& shapeMask,
+                  ImpulseAccumulator& accum)
+{
+	getShapeMask(shapes, positions, shapeMask);
+	for (uint32_t word = 0; word < shapes.mNumConeWords; ++word)
+	{
+		const __m256& cones = shapeMask.mCones[word];
+		uint32_t mask = horizontalOr(lowerHalf(cones)) | horizontalOr(upperHalf(cones));
+		while (mask)
+		{
+			uint32_t test = mask - 1;
+			uint32_t bit = findBitSet(mask & ~test);
+			uint32_t coneIndex = word * 32 + bit;
+			mask = mask & test;
+
+			// same as the sse2 culling, the cone bits below coneIndex have already been cleared
+			__m256 culled = isZero(shapeMask.mCones[word], splat(1u << bit));
+
+			const float* center = shapes.mCones + coneIndex * sConeSize;
+			const float* axis = center + 4;
+			const float* auxiliary = center + 8; // sqrCosine, halfLength, firstMask, secondMask
+			const uint32_t* words = reinterpret_cast<const uint32_t*>(center + 12); // firstWord, secondWord
+
+			// sphere masks of the capsule ends, may be the same word
+			__m256& firstSpheres = shapeMask.mSpheres[words[0]];
+			__m256& secondSpheres = shapeMask.mSpheres[words[1]];
+
+			__m256 deltaX = _mm256_sub_ps(positions[0], _mm256_broadcast_ss(center + 0));
+			__m256 deltaY = _mm256_sub_ps(positions[1], _mm256_broadcast_ss(center + 1));
+			__m256 deltaZ = _mm256_sub_ps(positions[2], _mm256_broadcast_ss(center + 2));
+
+			__m256 axisX = _mm256_broadcast_ss(axis + 0);
+			__m256 axisY = _mm256_broadcast_ss(axis + 1);
+			__m256 axisZ = _mm256_broadcast_ss(axis + 2);
+			__m256 slope = _mm256_broadcast_ss(axis + 3);
+
+			__m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(deltaX, axisX), _mm256_mul_ps(deltaY, axisY)),
+			                           _mm256_mul_ps(deltaZ, axisZ));
+			__m256 radius = _mm256_add_ps(_mm256_mul_ps(dot, slope), _mm256_broadcast_ss(center + 3));
+			radius = _mm256_andnot_ps(culled, _mm256_max_ps(radius, _mm256_setzero_ps()));
+
+			__m256 sqrDistance = _mm256_sub_ps(
+			    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(deltaX, deltaX), _mm256_mul_ps(deltaY, deltaY)),
+			                  _mm256_mul_ps(deltaZ, deltaZ)),
+			    _mm256_mul_ps(dot, dot));
+
+			__m256 firstMask = _mm256_broadcast_ss(auxiliary + 2);
+			__m256 secondMask = _mm256_broadcast_ss(auxiliary + 3);
+
+			__m256 contactMask = _mm256_cmp_ps(_mm256_mul_ps(radius, radius), sqrDistance, _CMP_GT_OQ);
+			if (!_mm256_movemask_ps(contactMask))
+			{
+				firstSpheres = _mm256_andnot_ps(firstMask, firstSpheres);
+				secondSpheres = _mm256_andnot_ps(secondMask, secondSpheres);
+				continue;
+			}
+
+			sqrDistance = _mm256_max_ps(sqrDistance, sEpsilon);
+			__m256 invDistance = _mm256_rsqrt_ps(sqrDistance);
+
+			__m256 base = _mm256_add_ps(dot, _mm256_mul_ps(_mm256_mul_ps(slope, sqrDistance), invDistance));
+			base = _mm256_and_ps(base, contactMask);
+
+			__m256 halfLength = _mm256_broadcast_ss(auxiliary + 1);
+			__m256 leftMask = _mm256_cmp_ps(base, negate(halfLength), _CMP_LT_OQ);
+			__m256 rightMask = _mm256_cmp_ps(base, halfLength, _CMP_GT_OQ);
+
+			firstSpheres = _mm256_andnot_ps(_mm256_andnot_ps(leftMask, firstMask), firstSpheres);
+			secondSpheres = _mm256_andnot_ps(_mm256_andnot_ps(rightMask, secondMask), secondSpheres);
+
+			deltaX = _mm256_sub_ps(deltaX, _mm256_mul_ps(base, axisX));
+			deltaY = _mm256_sub_ps(deltaY, _mm256_mul_ps(base, axisY));
+			deltaZ = _mm256_sub_ps(deltaZ, _mm256_mul_ps(base, axisZ));
+
+			__m256 sqrCosine = _mm256_broadcast_ss(auxiliary);
+			__m256 scale = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(radius, invDistance), sqrCosine), sqrCosine);
+
+			contactMask = _mm256_andnot_ps(_mm256_or_ps(leftMask, rightMask), contactMask);
+
+			if (!_mm256_movemask_ps(contactMask))
+				continue;
+
+			accum.add(deltaX, deltaY, deltaZ, scale, contactMask);
+
+			if (shapes.mFrictionEnabled)
+			{
+				const float* s0p0 = shapes.mPrevSpheres + shapes.mCapsuleIndices[coneIndex * 2] * 4;
+				const float* s0p1 = shapes.mSpheres + shapes.mCapsuleIndices[coneIndex * 2] * 4;
+				const float* s1p0 = shapes.mPrevSpheres + shapes.mCapsuleIndices[coneIndex * 2 + 1] * 4;
+				const float* s1p1 = shapes.mSpheres + shapes.mCapsuleIndices[coneIndex * 2 + 1] * 4;
+
+				__m256 v0[3], vd[3];
+				for (int i = 0; i < 3; ++i)
+				{
+					float v = s0p1[i] - s0p0[i];
+					v0[i] = _mm256_set1_ps(v);
+					vd[i] = _mm256_set1_ps(s1p1[i] - s1p0[i] - v);
+				}
+
+				// dot is in the range -1 to 1, scale and bias to 0 to 1
+				__m256 half = _mm256_set1_ps(0.5f);
+				dot = _mm256_add_ps(_mm256_mul_ps(dot, half), half);
+
+				// interpolate velocity at contact points
+				accum.addVelocity(_mm256_add_ps(v0[0], _mm256_mul_ps(dot, vd[0])),
+				                  _mm256_add_ps(v0[1], _mm256_mul_ps(dot, vd[1])),
+				                  _mm256_add_ps(v0[2], _mm256_mul_ps(dot, vd[2])), contactMask);
+			}
+		}
+	}
+}
+
+void collideSpheres(const CollisionShapes& shapes, const __m256* sphereMask, const __m256* positions,
+                    ImpulseAccumulator& accum)
+{
+	for (uint32_t word = 0; word < shapes.mNumSphereWords; ++word)
+	{
+		uint32_t lowerMask = horizontalOr(lowerHalf(sphereMask[word]));
+		uint32_t upperMask = horizontalOr(upperHalf(sphereMask[word]));
+		uint32_t mask = lowerMask | upperMask;
+		while (mask)
+		{
+			uint32_t test = mask - 1;
+			uint32_t bit = mask & ~test;
+			mask = mask & test;
+
+			const float* sphere = shapes.mSpheres + (word * 32 + findBitSet(bit)) * 4;
+
+			__m256 deltaX = _mm256_sub_ps(positions[0], _mm256_broadcast_ss(sphere + 0));
+			__m256 deltaY = _mm256_sub_ps(positions[1], _mm256_broadcast_ss(sphere + 1));
+			__m256 deltaZ = _mm256_sub_ps(positions[2], _mm256_broadcast_ss(sphere + 2));
+
+			__m256 sqrDistance = _mm256_add_ps(
+			    _mm256_add_ps(_mm256_add_ps(sEpsilon, _mm256_mul_ps(deltaX, deltaX)), _mm256_mul_ps(deltaY, deltaY)),
+			    _mm256_mul_ps(deltaZ, deltaZ));
+			__m256 negativeScale =
+			    _mm256_sub_ps(sOne, _mm256_mul_ps(_mm256_rsqrt_ps(sqrDistance), _mm256_broadcast_ss(sphere + 3)));
+
+			// only collide the groups of 4 particles overlapping the sphere in the grid
+			__m256 contactMask = _mm256_cmp_ps(_mm256_setzero_ps(), negativeScale, _CMP_GT_OQ);
+			contactMask = _mm256_and_ps(contactMask, groupMask((lowerMask & bit ? 1u : 0u) | (upperMask & bit ? 2u : 0u)));
+			if (!_mm256_movemask_ps(contactMask))
+				continue;
+
+			accum.subtract(deltaX, deltaY, deltaZ, negativeScale, contactMask);
+
+			if (shapes.mFrictionEnabled)
+			{
+				const float* prevSphere = shapes.mPrevSpheres + (sphere - shapes.mSpheres);
+				accum.addVelocity(_mm256_set1_ps(sphere[0] - prevSphere[0]), _mm256_set1_ps(sphere[1] - prevSphere[1]),
+				                  _mm256_set1_ps(sphere[2] - prevSphere[2]), contactMask);
+			}
+		}
+	}
+}
+
+void calculateFrictionImpulse(const ImpulseAccumulator& accum, const __m256* curPos, const __m256* prevPos,
+                              const __m256& scale, const __m256& coefficient, const __m256& mask, __m256* impulse)
+{
+	// calculate collision normal
+	__m256 deltaSq =
+	    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(accum.mDeltaX, accum.mDeltaX), _mm256_mul_ps(accum.mDeltaY, accum.mDeltaY)),
+	                  _mm256_mul_ps(accum.mDeltaZ, accum.mDeltaZ));
+
+	__m256 rcpDelta = _mm256_rsqrt_ps(_mm256_add_ps(deltaSq, sEpsilon));
+
+	__m256 nx = _mm256_mul_ps(accum.mDeltaX, rcpDelta);
+	__m256 ny = _mm256_mul_ps(accum.mDeltaY, rcpDelta);
+	__m256 nz = _mm256_mul_ps(accum.mDeltaZ, rcpDelta);
+
+	// calculate relative velocity
+	__m256 rvx = _mm256_sub_ps(_mm256_sub_ps(curPos[0], prevPos[0]), _mm256_mul_ps(accum.mVelX, scale));
+	__m256 rvy = _mm256_sub_ps(_mm256_sub_ps(curPos[1], prevPos[1]), _mm256_mul_ps(accum.mVelY, scale));
+	__m256 rvz = _mm256_sub_ps(_mm256_sub_ps(curPos[2], prevPos[2]), _mm256_mul_ps(accum.mVelZ, scale));
+
+	// calculate magnitude of relative normal velocity
+	__m256 rvn = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rvx, nx), _mm256_mul_ps(rvy, ny)), _mm256_mul_ps(rvz, nz));
+
+	// calculate relative tangential velocity
+	__m256 rvtx = _mm256_sub_ps(rvx, _mm256_mul_ps(rvn, nx));
+	__m256 rvty = _mm256_sub_ps(rvy, _mm256_mul_ps(rvn, ny));
+	__m256 rvtz = _mm256_sub_ps(rvz, _mm256_mul_ps(rvn, nz));
+
+	// calculate magnitude of relative tangential velocity
+	__m256 rcpVt = _mm256_rsqrt_ps(_mm256_add_ps(
+	    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rvtx, rvtx), _mm256_mul_ps(rvty, rvty)), _mm256_mul_ps(rvtz, rvtz)),
+	    sEpsilon));
+
+	// magnitude of friction impulse (cannot be greater than -rvt)
+	__m256 j = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(negate(coefficient), deltaSq), rcpDelta), rcpVt);
+	j = _mm256_and_ps(_mm256_max_ps(j, negate(sOne)), mask);
+
+	impulse[0] = _mm256_mul_ps(rvtx, j);
+	impulse[1] = _mm256_mul_ps(rvty, j);
+	impulse[2] = _mm256_mul_ps(rvtz, j);
+}
+
+uint32_t horizontalSum(const __m128& v)
+{
+	float sum[4];
+	_mm_storeu_ps(sum, v);
+	return uint32_t(sum[0] + sum[1] + sum[2] + sum[3]);
+}
+
+} // anonymous namespace
+
+// collides particles [0, numParticles) of curIt, blocks is the transposed copy of the particles or null.
+// returns the number of collisions
+uint32_t collideParticles(float* __restrict curIt, float* __restrict prevIt, const float* __restrict blocks,
+                          uint32_t numParticles, const float* __restrict spheres, const float* __restrict prevSpheres,
+                          const float* __restrict cones, const uint32_t* __restrict capsuleIndices,
+                          const uint32_t* __restrict sphereGrid, const uint32_t* __restrict coneGrid,
+                          uint32_t numSphereWords, uint32_t numConeWords, const uint32_t* numCells,
+                          const __m128& gridScale, const __m128& gridBias, float frictionScale, float massScale)
+{
+	CollisionShapes shapes;
+	shapes.mSpheres = spheres;
+	shapes.mPrevSpheres = prevSpheres;
+	shapes.mCones = cones;
+	shapes.mCapsuleIndices = capsuleIndices;
+	shapes.mSphereGrid = sphereGrid;
+	shapes.mConeGrid = coneGrid;
+	shapes.mNumSphereWords = numSphereWords;
+	shapes.mNumConeWords = numConeWords;
+	shapes.mFrictionEnabled = frictionScale > 0.0f;
+
+	float scale[4], bias[4];
+	_mm_storeu_ps(scale, gridScale);
+	_mm_storeu_ps(bias, gridBias);
+	shapes.mGridStride = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		shapes.mNumCells[i] = numCells[i];
+		shapes.mGridStride = numCells[i] > shapes.mGridStride ? numCells[i] : shapes.mGridStride;
+		shapes.mGridScale[i] = _mm256_set1_ps(scale[i]);
+		shapes.mGridBias[i] = _mm256_set1_ps(bias[i]);
+	}
+
+	const bool massScalingEnabled = massScale > 0.0f;
+	const __m256 massScale8 = _mm256_set1_ps(massScale);
+	const __m256 frictionScale8 = _mm256_set1_ps(frictionScale);
+
+	uint32_t numCollisions = 0;
+
+	// an odd number of 4 particle groups processes the last group twice, without storing the upper half
+	for (uint32_t numGroups = (numParticles + 3) / 4; numGroups; curIt += 32, prevIt += 32, blocks += blocks ? 32 : 0)
+	{
+		bool bothGroups = numGroups > 1;
+		numGroups -= bothGroups ? 2 : 1;
+
+		__m256 curPos[4];
+		load(curIt, blocks, bothGroups, curPos);
+
+		ImpulseAccumulator accum;
+
+		// first collide cones, pass on hit mask to ignore sphere parts that are inside the cones
+		ShapeMask shapeMask;
+		collideCones(shapes, curPos, shapeMask, accum);
+		collideSpheres(shapes, shapeMask.mSpheres, curPos, accum);
+
+		__m256 mask = _mm256_cmp_ps(accum.mNumCollisions, sEpsilon, _CMP_GT_OQ);
+		uint32_t collided = uint32_t(_mm256_movemask_ps(mask));
+		if (!collided)
+		{
+			if (blocks)
+				store(curIt, bothGroups, curPos);
+			continue;
+		}
+
+		// groups of 4 particles without collisions are left untouched
+		__m256 updateMask = groupMask((collided & 0xf ? 1u : 0u) | (collided & 0xf0 ? 2u : 0u));
+
+		__m256 invNumCollisions = _mm256_rcp_ps(accum.mNumCollisions);
+
+		if (shapes.mFrictionEnabled)
+		{
+			__m256 prevPos[4];
+			load(prevIt, 0, bothGroups, prevPos);
+
+			__m256 frictionImpulse[3];
+			calculateFrictionImpulse(accum, curPos, prevPos, invNumCollisions, frictionScale8, mask, frictionImpulse);
+
+			for (int i = 0; i < 3; ++i)
+				prevPos[i] = _mm256_blendv_ps(prevPos[i], _mm256_sub_ps(prevPos[i], frictionImpulse[i]), updateMask);
+
+			store(prevIt, bothGroups, prevPos);
+		}
+
+		if (massScalingEnabled)
+		{
+			// calculate the inverse mass scale based on the collision impulse magnitude
+			__m256 dSq = _mm256_mul_ps(
+			    _mm256_mul_ps(invNumCollisions, invNumCollisions),
+			    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(accum.mDeltaX, accum.mDeltaX),
+			                                _mm256_mul_ps(accum.mDeltaY, accum.mDeltaY)),
+			                  _mm256_mul_ps(accum.mDeltaZ, accum.mDeltaZ)));
+
+			__m256 invMassScale = _mm256_rcp_ps(_mm256_add_ps(sOne, _mm256_mul_ps(massScale8, dSq)));
+
+			// scale invmass
+			curPos[3] = _mm256_blendv_ps(curPos[3], _mm256_mul_ps(curPos[3], invMassScale), mask);
+		}
+
+		// apply average de-penetration delta
+		curPos[0] = _mm256_blendv_ps(curPos[0], _mm256_add_ps(curPos[0], _mm256_mul_ps(accum.mDeltaX, invNumCollisions)), updateMask);
+		curPos[1] = _mm256_blendv_ps(curPos[1], _mm256_add_ps(curPos[1], _mm256_mul_ps(accum.mDeltaY, invNumCollisions)), updateMask);
+		curPos[2] = _mm256_blendv_ps(curPos[2], _mm256_add_ps(curPos[2], _mm256_mul_ps(accum.mDeltaZ, invNumCollisions)), updateMask);
+
+		store(curIt, bothGroups, curPos);
+
+		if (collided & 0xf)
+			numCollisions += horizontalSum(_mm256_castps256_ps128(accum.mNumCollisions));
+		if (bothGroups && collided & 0xf0)
+			numCollisions += horizontalSum(_mm256_extractf128_ps(accum.mNumCollisions, 1));
+	}
+
+	return numCollisions;
+}
+
+} // namespace avx
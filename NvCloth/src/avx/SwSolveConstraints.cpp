@@ -27,6 +27,8 @@
 // Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
 // Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
 
+#ifdef _MSC_VER
+
 #pragma warning(push)
 #pragma warning(disable : 4668) //'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
 #pragma warning(disable : 4987) // nonstandard extension used: 'throw (...)'
@@ -38,8 +40,30 @@
 typedef unsigned __int16 uint16_t;
 typedef unsigned __int32 uint32_t;
 
+#define NV_AVX_INSTANCES 1
+#define NV_AVX_FMA_INSTANCES (_MSC_VER >= 1700)
+
+#else
+
+#include <immintrin.h>
+#include <stdint.h>
+
+// gcc and clang only allow fma/avx2 intrinsics when compiling with -mfma -mavx2, but
+// those flags must not leak into the avx code path. SwSolveConstraintsFma.cpp includes
+// this file again with those flags to provide the avx+fma instances.
+#ifdef __FMA__
+#define NV_AVX_INSTANCES 0
+#define NV_AVX_FMA_INSTANCES 1
+#else
+#define NV_AVX_INSTANCES 1
+#define NV_AVX_FMA_INSTANCES 0
+#endif
+
+#endif
+
 namespace avx
 {
+#if NV_AVX_INSTANCES
 __m128 sMaskYZW;
 __m256 sOne, sEpsilon, sMinusOneXYZOneW, sMaskXY;
 
@@ -51,7 +75,14 @@ void initialize()
 	sMinusOneXYZOneW = _mm256_setr_ps(-1.0f, -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, -1.0f, 1.0f);
 	sMaskXY = _mm256_castsi256_ps(_mm256_setr_epi32(~0, ~0, 0, 0, ~0, ~0, 0, 0));
 }
+#else
+extern __m128 sMaskYZW;
+extern __m256 sOne, sEpsilon, sMinusOneXYZOneW, sMaskXY;
+#endif
 
+// internal linkage, so helpers compiled with different instruction sets don't get merged
+namespace
+{
 template <uint32_t>
 __m256 fmadd_ps(__m256 a, __m256 b, __m256 c)
 {
@@ -62,7 +93,7 @@ __m256 fnmadd_ps(__m256 a, __m256 b, __m256 c)
 {
 	return _mm256_sub_ps(c, _mm256_mul_ps(a, b));
 }
-#if _MSC_VER >= 1700
+#if NV_AVX_FMA_INSTANCES
 template <>
 __m256 fmadd_ps<2>(__m256 a, __m256 b, __m256 c)
 {
@@ -75,111 +106,12 @@ __m256 fnmadd_ps<2>(__m256 a, __m256 b, __m256 c)
 }
 #endif
 
-template <uint32_t>
-__m256 exp2(const __m256& v)
-{
-	// http://www.netlib.org/cephes/
-
-
-	__m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_set1_ps(-127.4999f), v), _mm256_set1_ps(127.4999f));
-
-	// separate into integer and fractional part
-
-	__m256 fx = _mm256_add_ps(x,_mm256_set1_ps(0.5f));
-	__m128 fx0 = _mm256_extractf128_ps(fx,0);
-	__m128 fx1 = _mm256_extractf128_ps(fx,1);
-
-	__m128i ix0 = _mm_sub_epi32(_mm_cvttps_epi32(fx0), _mm_srli_epi32(_mm_castps_si128(fx0), 31));
-	__m128i ix1 = _mm_sub_epi32(_mm_cvttps_epi32(fx1), _mm_srli_epi32(_mm_castps_si128(fx1), 31));
-	__m256i ix = _mm256_loadu2_m128i(&ix0,&ix1);
-	fx = _mm256_sub_ps(x,_mm256_cvtepi32_ps(ix));
-
-	// exp2(fx) ~ 1 + 2 * P(fx) / (Q(fx) - P(fx))
-
-	__m256 fx2 = _mm256_mul_ps(fx,fx);
-
-	__m256 px = _mm256_mul_ps(fx,
-						_mm256_add_ps(_mm256_add_ps(
-							_mm256_set1_ps(1.51390680115615096133e+3f),
-							_mm256_mul_ps(fx2, _mm256_set1_ps(2.02020656693165307700e+1f))),
-							_mm256_mul_ps(fx2, _mm256_set1_ps(2.30933477057345225087e-2f))
-						)
-				);
-
-
-
-	__m256 qx = _mm256_add_ps(
-					_mm256_set1_ps(4.36821166879210612817e+3f),
-					_mm256_mul_ps(
-						fx2,
-						_mm256_add_ps(_mm256_set1_ps(2.33184211722314911771e+2f), fx2)
-					)
-				);
-
-	__m256 exp2fx = _mm256_mul_ps(px,_mm256_rcp_ps(_mm256_sub_ps(qx, px)));
-	exp2fx = _mm256_add_ps(_mm256_add_ps(sOne, exp2fx), exp2fx);
-
-	// exp2(ix)
-
-	__m128 exp2ix0 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(ix0, _mm_set1_epi32(0x7f)), 23));
-	__m128 exp2ix1 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(ix1, _mm_set1_epi32(0x7f)), 23));
-	__m256 exp2ix = _mm256_loadu2_m128((float*)&exp2ix0,(float*)&exp2ix1);
-
-	return _mm256_mul_ps(exp2fx, exp2ix);
-}
-#if _MSC_VER >= 1700
-//AVX2
-template <>
-__m256 exp2<2>(const __m256& v)
-{
-	// http://www.netlib.org/cephes/
-
-
-	__m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_set1_ps(-127.4999f), v), _mm256_set1_ps(127.4999f));
-
-	// separate into integer and fractional part
-
-	__m256 fx = _mm256_add_ps(x,_mm256_set1_ps(0.5f));
-	__m256i ix = _mm256_sub_epi32(_mm256_cvttps_epi32(fx), _mm256_srli_epi32(_mm256_castps_si256(fx), 31));
-	fx = _mm256_sub_ps(x,_mm256_cvtepi32_ps(ix));
-
-	// exp2(fx) ~ 1 + 2 * P(fx) / (Q(fx) - P(fx))
-
-	__m256 fx2 = _mm256_mul_ps(fx,fx);
-
-	__m256 px = _mm256_mul_ps(fx,
-						_mm256_add_ps(_mm256_add_ps(
-							_mm256_set1_ps(1.51390680115615096133e+3f),
-							_mm256_mul_ps(fx2, _mm256_set1_ps(2.02020656693165307700e+1f))),
-							_mm256_mul_ps(fx2, _mm256_set1_ps(2.30933477057345225087e-2f))
-						)
-				);
-
-
-
-	__m256 qx = _mm256_add_ps(
-					_mm256_set1_ps(4.36821166879210612817e+3f),
-					_mm256_mul_ps(
-						fx2,
-						_mm256_add_ps(_mm256_set1_ps(2.33184211722314911771e+2f), fx2)
-					)
-				);
-
-	__m256 exp2fx = _mm256_mul_ps(px,_mm256_rcp_ps(_mm256_sub_ps(qx, px)));
-	exp2fx = _mm256_add_ps(_mm256_add_ps(sOne, exp2fx), exp2fx);
-
-	// exp2(ix)
-
-	__m256 exp2ix = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(ix, _mm256_set1_epi32(0x7f)), 23));
-
-	return _mm256_mul_ps(exp2fx, exp2ix);
-}
-#endif
+} // anonymous namespace
 
 // roughly same perf as SSE2 intrinsics, the asm version below is about 10% faster
-template <bool useMultiplier, uint32_t avx>
+template <bool useMultiplier, uint32_t avx, typename IndexT>
 void solveConstraints(float* __restrict posIt, const float* __restrict rIt, const float* __restrict stIt, const float* __restrict rEnd,
-                      const uint16_t* __restrict iIt, const __m128& stiffnessEtc, const __m128& stiffnessExponent)
+                      const IndexT* __restrict iIt, const __m128& stiffnessEtc)
 {
 	__m256 stiffness, stretchLimit, compressionLimit, multiplier;
 
@@ -268,7 +200,7 @@ void solveConstraints(float* __restrict posIt, const float* __restrict rIt, cons
 		__m256 e2ij = fmadd_ps<avx>(hxij, hxij, fmadd_ps<avx>(hyij, hyij, fmadd_ps<avx>(hzij, hzij, sEpsilon)));
 
 		__m256 rij = _mm256_load_ps(rIt);
-		__m256 stij = useStiffnessPerConstraint?_mm256_sub_ps(sOne, exp2<avx>(_mm256_mul_ps(_mm256_load_ps(stIt),_mm256_broadcast_ps(&stiffnessExponent)))):stiffness;
+		__m256 stij = useStiffnessPerConstraint ? _mm256_loadu_ps(stIt) : stiffness;
 		__m256 mask = _mm256_cmp_ps(rij, sEpsilon, _CMP_GT_OQ);
 		__m256 erij = _mm256_and_ps(fnmadd_ps<avx>(rij, _mm256_rsqrt_ps(e2ij), sOne), mask);
 
@@ -323,18 +255,33 @@ void solveConstraints(float* __restrict posIt, const float* __restrict rIt, cons
 	_mm256_zeroupper();
 }
 
+#if NV_AVX_INSTANCES
+template void solveConstraints<false, 1>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
+                                         const uint16_t* __restrict, const __m128&);
+
+template void solveConstraints<true, 1>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
+                                        const uint16_t* __restrict, const __m128&);
 
 template void solveConstraints<false, 1>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
-                                         const uint16_t* __restrict, const __m128&, const __m128&);
+                                         const uint32_t* __restrict, const __m128&);
 
 template void solveConstraints<true, 1>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
-                                         const uint16_t* __restrict, const __m128&, const __m128&);
+                                        const uint32_t* __restrict, const __m128&);
+#endif
+
+#if NV_AVX_FMA_INSTANCES
+template void solveConstraints<false, 2>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
+                                         const uint16_t* __restrict, const __m128&);
+
+template void solveConstraints<true, 2>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
+                                        const uint16_t* __restrict, const __m128&);
 
 template void solveConstraints<false, 2>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
-                                         const uint16_t* __restrict, const __m128&, const __m128&);
+                                         const uint32_t* __restrict, const __m128&);
 
 template void solveConstraints<true, 2>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
-                                         const uint16_t* __restrict, const __m128&, const __m128&);
+                                        const uint32_t* __restrict, const __m128&);
+#endif
 
 
 } // namespace avx
@@ -0,0 +1,179 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2020 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#ifdef _MSC_VER
+
+#pragma warning(push)
+#pragma warning(disable : 4668) //'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
+#pragma warning(disable : 4987) // nonstandard extension used: 'throw (...)'
+#include <intrin.h>
+#pragma warning(pop)
+
+#pragma warning(disable : 4127) // conditional expression is constant
+
+typedef unsigned __int16 uint16_t;
+typedef unsigned __int32 uint32_t;
+
+#else
+
+#ifndef __AVX512F__
+#error This file needs to be compiled with AVX-512F support!
+#endif
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#endif
+
+#if !defined(_MSC_VER) || _MSC_VER >= 1911
+
+namespace avx512
+{
+// internal linkage, so helpers compiled with avx-512 don't get merged with other instances
+namespace
+{
+// the unmasked gcc intrinsics of gathers, shifts, min/max and approximations start from an undefined
+// register, which -Wmaybe-uninitialized reports. the masked forms take an explicit zero instead.
+const __mmask16 sAllLanes = 0xffff;
+
+__m512i shiftLeft2(__m512i v)
+{
+	return _mm512_maskz_slli_epi32(sAllLanes, v, 2);
+}
+
+__m512 gather(const float* ptr, __m512i offsets)
+{
+	return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), sAllLanes, offsets, ptr, 4);
+}
+
+// splits 16 (i, j) index pairs into particle float offsets
+void loadIndices(const uint16_t* __restrict iIt, __m512i& pi, __m512i& pj)
+{
+	// i in the low and j in the high half of each lane
+	__m512i ij = _mm512_loadu_si512(iIt);
+	pi = shiftLeft2(_mm512_and_si512(ij, _mm512_set1_epi32(0xffff)));
+	pj = shiftLeft2(_mm512_maskz_srli_epi32(sAllLanes, ij, 16));
+}
+
+void loadIndices(const uint32_t* __restrict iIt, __m512i& pi, __m512i& pj)
+{
+	__m512i ij0 = _mm512_loadu_si512(iIt);
+	__m512i ij1 = _mm512_loadu_si512(iIt + 16);
+	const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+	const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+	pi = shiftLeft2(_mm512_permutex2var_epi32(ij0, even, ij1));
+	pj = shiftLeft2(_mm512_permutex2var_epi32(ij0, odd, ij1));
+}
+} // anonymous namespace
+
+// processes 16 constraints per iteration, particles are gathered/scattered per component.
+// constraints of a set need to be padded to a multiple of 16 and may not share particles.
+template <bool useMultiplier, typename IndexT>
+void solveConstraints(float* __restrict posIt, const float* __restrict rIt, const float* __restrict stIt, const float* __restrict rEnd,
+                      const IndexT* __restrict iIt, const __m128& stiffnessEtc)
+{
+	const __m512 one = _mm512_set1_ps(1.0f);
+	const __m512 epsilon = _mm512_set1_ps(1.192092896e-07f);
+
+	// (stiffness, multiplier, compressionLimit, stretchLimit)
+	__m512 stiffness = _mm512_set1_ps(reinterpret_cast<const float*>(&stiffnessEtc)[0]);
+	__m512 multiplier = _mm512_set1_ps(reinterpret_cast<const float*>(&stiffnessEtc)[1]);
+	__m512 compressionLimit = _mm512_set1_ps(reinterpret_cast<const float*>(&stiffnessEtc)[2]);
+	__m512 stretchLimit = _mm512_set1_ps(reinterpret_cast<const float*>(&stiffnessEtc)[3]);
+
+	bool useStiffnessPerConstraint = stIt != nullptr;
+
+	for (; rIt < rEnd; rIt += 16, iIt += 32, stIt += 16)
+	{
+		__m512i pi, pj;
+		loadIndices(iIt, pi, pj);
+
+		__m512 xi = gather(posIt + 0, pi);
+		__m512 yi = gather(posIt + 1, pi);
+		__m512 zi = gather(posIt + 2, pi);
+		__m512 wi = gather(posIt + 3, pi);
+		__m512 xj = gather(posIt + 0, pj);
+		__m512 yj = gather(posIt + 1, pj);
+		__m512 zj = gather(posIt + 2, pj);
+		__m512 wj = gather(posIt + 3, pj);
+
+		// offset = posJ - posI, invMass sum
+		__m512 hx = _mm512_sub_ps(xj, xi);
+		__m512 hy = _mm512_sub_ps(yj, yi);
+		__m512 hz = _mm512_sub_ps(zj, zi);
+		__m512 vw = _mm512_add_ps(wj, wi);
+
+		__m512 e2 = _mm512_fmadd_ps(hz, hz, _mm512_fmadd_ps(hy, hy, _mm512_fmadd_ps(hx, hx, epsilon)));
+
+		__m512 r = _mm512_load_ps(rIt);
+		__m512 st = useStiffnessPerConstraint ? _mm512_loadu_ps(stIt) : stiffness;
+
+		// slack, zero for rest length < epsilon (padding)
+		__mmask16 mask = _mm512_cmp_ps_mask(r, epsilon, _CMP_GT_OQ);
+		__m512 er = _mm512_maskz_mov_ps(mask, _mm512_fnmadd_ps(r, _mm512_maskz_rsqrt14_ps(sAllLanes, e2), one));
+
+		if (useMultiplier)
+		{
+			__m512 clamped = _mm512_maskz_max_ps(sAllLanes, compressionLimit, _mm512_maskz_min_ps(sAllLanes, er, stretchLimit));
+			er = _mm512_fnmadd_ps(multiplier, clamped, er);
+		}
+
+		__m512 ex = _mm512_mul_ps(er, _mm512_mul_ps(st, _mm512_maskz_rcp14_ps(sAllLanes, _mm512_add_ps(epsilon, vw))));
+
+		hx = _mm512_mul_ps(hx, ex);
+		hy = _mm512_mul_ps(hy, ex);
+		hz = _mm512_mul_ps(hz, ex);
+
+		// pos = pos + h * invMass, i and j of padding constraints alias but stay unchanged
+		_mm512_i32scatter_ps(posIt + 0, pi, _mm512_fmadd_ps(hx, wi, xi), 4);
+		_mm512_i32scatter_ps(posIt + 1, pi, _mm512_fmadd_ps(hy, wi, yi), 4);
+		_mm512_i32scatter_ps(posIt + 2, pi, _mm512_fmadd_ps(hz, wi, zi), 4);
+		_mm512_i32scatter_ps(posIt + 0, pj, _mm512_fnmadd_ps(hx, wj, xj), 4);
+		_mm512_i32scatter_ps(posIt + 1, pj, _mm512_fnmadd_ps(hy, wj, yj), 4);
+		_mm512_i32scatter_ps(posIt + 2, pj, _mm512_fnmadd_ps(hz, wj, zj), 4);
+	}
+
+	_mm256_zeroupper();
+}
+
+template void solveConstraints<false>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
+                                      const uint16_t* __restrict, const __m128&);
+
+template void solveConstraints<true>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
+                                     const uint16_t* __restrict, const __m128&);
+
+template void solveConstraints<false>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
+                                      const uint32_t* __restrict, const __m128&);
+
+template void solveConstraints<true>(float* __restrict, const float* __restrict, const float* __restrict, const float* __restrict,
+                                     const uint32_t* __restrict, const __m128&);
+
+} // namespace avx512
+
+#endif // _MSC_VER
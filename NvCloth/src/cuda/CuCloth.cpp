@@ -309,6 +309,32 @@ cloth::Range<const PxVec3> cloth::CuCloth::clampTriangleCount(Range<const PxVec3
 	return Range<const PxVec3>(range.begin(), std::min(range.end(), clamp));
 }
 
+void cloth::CuCloth::setDistanceField(Range<const float> distances, uint32_t, uint32_t, uint32_t, const PxVec3&, float)
+{
+	if (!distances.empty())
+	{
+		NV_CLOTH_LOG_WARNING("Distance field collision is not supported by the CUDA solver.\n");
+	}
+}
+
+uint32_t cloth::CuCloth::getNumDistanceFieldSamples() const
+{
+	return 0;
+}
+
+void cloth::CuCloth::setHeightfield(Range<const float> heights, uint32_t, uint32_t, const PxVec3&, float)
+{
+	if (!heights.empty())
+	{
+		NV_CLOTH_LOG_WARNING("Heightfield collision is not supported by the CUDA solver.\n");
+	}
+}
+
+uint32_t cloth::CuCloth::getNumHeightfieldSamples() const
+{
+	return 0;
+}
+
 #include "../ClothImpl.h"
 
 namespace nv
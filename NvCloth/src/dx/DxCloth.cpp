@@ -324,6 +324,32 @@ cloth::Range<const PxVec3> cloth::DxCloth::clampTriangleCount(Range<const PxVec3
 	return Range<const PxVec3>(range.begin(), std::min(range.end(), clamp));
 }
 
+void cloth::DxCloth::setDistanceField(Range<const float> distances, uint32_t, uint32_t, uint32_t, const PxVec3&, float)
+{
+	if (!distances.empty())
+	{
+		NV_CLOTH_LOG_WARNING("Distance field collision is not supported by the DirectCompute solver.\n");
+	}
+}
+
+uint32_t cloth::DxCloth::getNumDistanceFieldSamples() const
+{
+	return 0;
+}
+
+void cloth::DxCloth::setHeightfield(Range<const float> heights, uint32_t, uint32_t, const PxVec3&, float)
+{
+	if (!heights.empty())
+	{
+		NV_CLOTH_LOG_WARNING("Heightfield collision is not supported by the DirectCompute solver.\n");
+	}
+}
+
+uint32_t cloth::DxCloth::getNumHeightfieldSamples() const
+{
+	return 0;
+}
+
 #include "../ClothImpl.h"
 
 namespace nv
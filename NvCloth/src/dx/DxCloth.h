@@ -79,6 +79,9 @@ public:
 	typedef DxFactory FactoryType;
 	typedef DxFabric FabricType;
 	typedef DxContextLock ContextLockType;
+
+	// collision spheres and capsules each, limited by the 32 bit shape masks of the kernel
+	static const uint32_t sMaxCollisionShapes = 32;
 };
 
 class DxCloth : protected DxContextLock, public ClothImpl<DxCloth>
@@ -113,6 +116,10 @@ class DxCloth : protected DxContextLock, public ClothImpl<DxCloth>
 	MappedRange<physx::PxVec4> getPreviousParticles();
 	MappedRange<const physx::PxVec4> getPreviousParticles() const;
 	GpuParticles getGpuParticles();
+	Range<const physx::PxVec4> getPublishedParticles() const
+	{
+		return Range<const physx::PxVec4>();
+	}
 
 	void setPhaseConfig(Range<const PhaseConfig> configs);
 	void setSelfCollisionIndices(Range<const uint32_t> indices);
@@ -122,6 +129,9 @@ class DxCloth : protected DxContextLock, public ClothImpl<DxCloth>
 	void setVirtualParticles(Range<const uint32_t[4]> indices, Range<const physx::PxVec3> weights);
 
 	void notifyChanged();
+	void notifyWakeUp()
+	{
+	}
 
 	bool updateClothData(DxClothData&);   // expects acquired context
 	uint32_t getSharedMemorySize() const; // without particle data
@@ -137,6 +147,14 @@ class DxCloth : protected DxContextLock, public ClothImpl<DxCloth>
 
 	Range<const physx::PxVec3> clampTriangleCount(Range<const physx::PxVec3>, uint32_t);
 
+	// distance fields and heightfields are not supported by the GPU solvers
+	void setDistanceField(Range<const float> distances, uint32_t dimX, uint32_t dimY, uint32_t dimZ,
+	                      const physx::PxVec3& lower, float cellSize);
+	uint32_t getNumDistanceFieldSamples() const;
+	void setHeightfield(Range<const float> heights, uint32_t numColumns, uint32_t numRows, const physx::PxVec3& lower,
+	                    float cellSize);
+	uint32_t getNumHeightfieldSamples() const;
+
   public:
 	DxFactory& mFactory;
 	DxFabric& mFabric;
@@ -66,6 +66,59 @@ class DxSolver : private DxContextLock, public Solver
 	virtual void simulateChunk(int idx);
 	virtual void endSimulation();
 	virtual int getSimulationChunkCount() const override;
+	virtual float getSimulationChunkCost(int) const override
+	{
+		return 1.0f;
+	}
+
+	virtual void setMinParticlesPerChunk(uint32_t) override
+	{
+	}
+	virtual uint32_t getMinParticlesPerChunk() const override
+	{
+		return 0;
+	}
+	virtual void setTargetSimulationChunkCount(uint32_t) override
+	{
+	}
+	virtual uint32_t getTargetSimulationChunkCount() const override
+	{
+		return 0;
+	}
+
+	virtual void setClothUpdateInterval(Cloth&, uint32_t) override
+	{
+	}
+	virtual uint32_t getClothUpdateInterval(const Cloth&) const override
+	{
+		return 1;
+	}
+
+	virtual float getClothSimulationTime(const Cloth&) const override
+	{
+		return 0.0f;
+	}
+
+	// the frame is simulated synchronously
+	virtual uint32_t simulateAsync(float dt, Executor& executor) override
+	{
+		return simulate(dt, executor) ? 1u : 0u;
+	}
+	virtual bool isSimulationComplete(uint32_t) const override
+	{
+		return true;
+	}
+	virtual void waitForSimulation(uint32_t) override
+	{
+	}
+
+	virtual void enableOutputBuffering(bool) override
+	{
+	}
+	virtual bool isOutputBufferingEnabled() const override
+	{
+		return false;
+	}
 
 	virtual bool hasError() const
 	{
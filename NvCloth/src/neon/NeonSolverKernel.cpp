@@ -45,9 +45,9 @@ namespace nv
 namespace cloth
 {
 bool neonSolverKernel(SwCloth const& cloth, SwClothData& data, SwKernelAllocator& allocator,
-                      IterationStateFactory& factory)
+                      const IterationState<Simd4f>& state)
 {
-	return sNeonSupport && (SwSolverKernel<Simd4f>(cloth, data, allocator, factory)(), true);
+	return sNeonSupport && (SwSolverKernel<Simd4f>(cloth, data, allocator, state)(), true);
 }
 }
 }
@@ -34,11 +34,10 @@ __pragma(warning(push))
 
 template <bool useMultiplier>
 void solveConstraints(float* __restrict posIt, const float* __restrict rIt, const float* __restrict stIt, const float* __restrict rEnd,
-						const uint16_t* __restrict iIt, const Simd4f& stiffnessEtc, const Simd4f& stiffnessExponent)
+						const uint16_t* __restrict iIt, const Simd4f& stiffnessEtc)
 {
 	PX_UNUSED(stIt);
 	PX_UNUSED(stiffnessEtc);
-	PX_UNUSED(stiffnessExponent);
 	__m128 sOne = _mm_set1_ps(1.0f);
 
 	__m128 stretchLimit, compressionLimit, multiplier;
@@ -90,8 +89,8 @@ void solveConstraints(float* __restrict posIt, const float* __restrict rIt, cons
 		__m128 e2ij = _mm_add_ps(gSimd4fEpsilon, _mm_add_ps(_mm_mul_ps(hxij, hxij),
 		                                                    _mm_add_ps(_mm_mul_ps(hyij, hyij), _mm_mul_ps(hzij, hzij))));
 
-		//Load/calculate the constraint stiffness
-		__m128 stij = useStiffnessPerConstraint ? _mm_set_ps1(1.0f) - exp2(stiffnessExponent * _mm_load_ps(stIt)) : stiffness;
+		//Load the constraint stiffness
+		__m128 stij = useStiffnessPerConstraint ? _mm_load_ps(stIt) : stiffness;
 
 
 		__m128 mask = _mm_cmpnle_ps(rij, gSimd4fEpsilon);